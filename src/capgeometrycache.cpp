@@ -0,0 +1,107 @@
+#include "capgeometrycache.h"
+#include "capmesh.h"
+
+#include <Qt3DCore/QAttribute>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DCore/QGeometry>
+#include <Qt3DCore/QNode>
+#include <Qt3DRender/QGeometryRenderer>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+// Stufenbreite: benachbarte Stufen unterscheiden sich um 1 % im Radius
+const double bucketRatio = 1.01;
+const double logBucketRatio = std::log(bucketRatio);
+const float minRadius = 0.0001f;
+
+Qt3DRender::QGeometryRenderer *createSphericalCap(Qt3DCore::QNode *owner, float surfaceRadius, float markerRadius)
+{
+    const CapMesh::Data mesh = CapMesh::build(surfaceRadius, markerRadius);
+
+    auto *renderer = new Qt3DRender::QGeometryRenderer(owner);
+    auto *geometry = new Qt3DCore::QGeometry(renderer);
+
+    auto *vertexBuffer = new Qt3DCore::QBuffer(geometry);
+    vertexBuffer->setData(mesh.vertices);
+
+    auto *indexBuffer = new Qt3DCore::QBuffer(geometry);
+    indexBuffer->setData(mesh.indices);
+
+    const int stride = mesh.floatsPerVertex * sizeof(float);
+
+    auto *positionAttribute = new Qt3DCore::QAttribute();
+    positionAttribute->setName(Qt3DCore::QAttribute::defaultPositionAttributeName());
+    positionAttribute->setVertexBaseType(Qt3DCore::QAttribute::Float);
+    positionAttribute->setVertexSize(3);
+    positionAttribute->setAttributeType(Qt3DCore::QAttribute::VertexAttribute);
+    positionAttribute->setBuffer(vertexBuffer);
+    positionAttribute->setByteStride(stride);
+    positionAttribute->setByteOffset(0);
+    positionAttribute->setCount(mesh.vertexCount);
+
+    auto *normalAttribute = new Qt3DCore::QAttribute();
+    normalAttribute->setName(Qt3DCore::QAttribute::defaultNormalAttributeName());
+    normalAttribute->setVertexBaseType(Qt3DCore::QAttribute::Float);
+    normalAttribute->setVertexSize(3);
+    normalAttribute->setAttributeType(Qt3DCore::QAttribute::VertexAttribute);
+    normalAttribute->setBuffer(vertexBuffer);
+    normalAttribute->setByteStride(stride);
+    normalAttribute->setByteOffset(3 * sizeof(float));
+    normalAttribute->setCount(mesh.vertexCount);
+
+    auto *indexAttribute = new Qt3DCore::QAttribute();
+    indexAttribute->setAttributeType(Qt3DCore::QAttribute::IndexAttribute);
+    indexAttribute->setVertexBaseType(Qt3DCore::QAttribute::UnsignedInt);
+    indexAttribute->setBuffer(indexBuffer);
+    indexAttribute->setCount(mesh.indexCount);
+
+    geometry->addAttribute(positionAttribute);
+    geometry->addAttribute(normalAttribute);
+    geometry->addAttribute(indexAttribute);
+
+    renderer->setGeometry(geometry);
+    renderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Triangles);
+    return renderer;
+}
+}
+
+CapGeometryCache::CapGeometryCache(Qt3DCore::QNode *owner, float surfaceRadius)
+    : ownerNode(owner),
+      surfaceRadius(surfaceRadius)
+{
+}
+
+CapGeometryCache::Key CapGeometryCache::keyFor(float markerRadius)
+{
+    return static_cast<Key>(std::lround(std::log(qMax(markerRadius, minRadius)) / logBucketRatio));
+}
+
+float CapGeometryCache::radiusFor(Key key)
+{
+    return static_cast<float>(std::exp(key * logBucketRatio));
+}
+
+Qt3DRender::QGeometryRenderer *CapGeometryCache::acquire(Key key)
+{
+    Entry &entry = entries[key];
+    if (!entry.renderer) {
+        entry.renderer = createSphericalCap(ownerNode, surfaceRadius, radiusFor(key));
+    }
+    ++entry.references;
+    return entry.renderer;
+}
+
+void CapGeometryCache::release(Key key)
+{
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+
+    if (--it->references <= 0) {
+        // Entfernt sich beim Loeschen selbst aus allen Entities, die ihn noch referenzieren
+        delete it->renderer;
+        entries.erase(it);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef CAPGEOMETRYCACHE_H
+#define CAPGEOMETRYCACHE_H
+
+#include <QHash>
+
+QT_BEGIN_NAMESPACE
+namespace Qt3DCore {
+    class QNode;
+}
+namespace Qt3DRender {
+    class QGeometryRenderer;
+}
+QT_END_NAMESPACE
+
+/**
+ * @brief CapGeometryCache - Gemeinsam genutzte Kappen-Geometrien fuer SurfaceMarker
+ *
+ * Verantwortlichkeiten:
+ * - Quantisierung des Markerradius in logarithmische Stufen (1 % relative Breite)
+ * - Ein QGeometryRenderer pro belegter Stufe, von allen Markern dieser Stufe als Komponente geteilt
+ * - Referenzzaehlung: die Geometrie wird beim ersten acquire() erzeugt und beim letzten release() geloescht
+ * - Die Renderer gehoeren dem uebergebenen Besitzer-Knoten, nicht den einzelnen Marker-Entities
+ */
+class CapGeometryCache {
+public:
+    using Key = int;
+
+    CapGeometryCache(Qt3DCore::QNode *owner, float surfaceRadius);
+    ~CapGeometryCache() = default;
+
+    CapGeometryCache(const CapGeometryCache &) = delete;
+    CapGeometryCache &operator=(const CapGeometryCache &) = delete;
+
+    static Key keyFor(float markerRadius);
+    static float radiusFor(Key key);
+
+    Qt3DRender::QGeometryRenderer *acquire(Key key);
+    void release(Key key);
+
+    int geometryCount() const { return static_cast<int>(entries.size()); }
+
+private:
+    struct Entry {
+        Qt3DRender::QGeometryRenderer *renderer = nullptr;
+        int references = 0;
+    };
+
+    Qt3DCore::QNode *ownerNode;
+    float surfaceRadius;
+    QHash<Key, Entry> entries;
+};
+
+#endif // CAPGEOMETRYCACHE_H
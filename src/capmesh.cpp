@@ -0,0 +1,213 @@
+#include "capmesh.h"
+
+#include <QtGlobal>
+#include <QtMath>
+
+namespace CapMesh {
+
+namespace {
+constexpr float minRadius = 0.0001f;
+constexpr int verticesPerRing = slices + 1;
+constexpr int capVertexCount = (rings + 1) * verticesPerRing;
+constexpr int sideVertexCount = 2 * verticesPerRing;
+constexpr int vertexTotal = capVertexCount * 2 + sideVertexCount;
+constexpr int capIndexCount = rings * slices * 6;
+constexpr int sideIndexCount = slices * 6;
+constexpr int indexTotal = capIndexCount * 2 + sideIndexCount;
+
+// cos/sin der Segmentwinkel werden fuer alle Ringe geteilt
+struct SliceTable {
+    float cosPhi[verticesPerRing];
+    float sinPhi[verticesPerRing];
+
+    SliceTable()
+    {
+        for (int slice = 0; slice <= slices; ++slice) {
+            const float phi = static_cast<float>(2.0 * M_PI) * static_cast<float>(slice) / static_cast<float>(slices);
+            cosPhi[slice] = qCos(phi);
+            sinPhi[slice] = qSin(phi);
+        }
+    }
+};
+
+const SliceTable &sliceTable()
+{
+    static const SliceTable table;
+    return table;
+}
+
+QByteArray buildIndices()
+{
+    QByteArray indexBufferData;
+    indexBufferData.resize(indexTotal * sizeof(quint32));
+    quint32 *indices = reinterpret_cast<quint32 *>(indexBufferData.data());
+
+    const int outerStart = 0;
+    const int innerStart = capVertexCount;
+    const int sideStart = capVertexCount * 2;
+
+    for (int ring = 0; ring < rings; ++ring) {
+        for (int slice = 0; slice < slices; ++slice) {
+            const int ringStart = ring * verticesPerRing;
+            const int nextRingStart = (ring + 1) * verticesPerRing;
+
+            const quint32 a = outerStart + ringStart + slice;
+            const quint32 b = outerStart + ringStart + slice + 1;
+            const quint32 c = outerStart + nextRingStart + slice;
+            const quint32 d = outerStart + nextRingStart + slice + 1;
+
+            *indices++ = a;
+            *indices++ = c;
+            *indices++ = b;
+            *indices++ = b;
+            *indices++ = c;
+            *indices++ = d;
+        }
+    }
+
+    for (int ring = 0; ring < rings; ++ring) {
+        for (int slice = 0; slice < slices; ++slice) {
+            const int ringStart = ring * verticesPerRing;
+            const int nextRingStart = (ring + 1) * verticesPerRing;
+
+            const quint32 a = innerStart + ringStart + slice;
+            const quint32 b = innerStart + ringStart + slice + 1;
+            const quint32 c = innerStart + nextRingStart + slice;
+            const quint32 d = innerStart + nextRingStart + slice + 1;
+
+            *indices++ = a;
+            *indices++ = b;
+            *indices++ = c;
+            *indices++ = b;
+            *indices++ = d;
+            *indices++ = c;
+        }
+    }
+
+    for (int slice = 0; slice < slices; ++slice) {
+        const quint32 outerA = sideStart + slice * 2;
+        const quint32 innerA = sideStart + slice * 2 + 1;
+        const quint32 outerB = sideStart + (slice + 1) * 2;
+        const quint32 innerB = sideStart + (slice + 1) * 2 + 1;
+
+        *indices++ = outerA;
+        *indices++ = innerA;
+        *indices++ = outerB;
+        *indices++ = outerB;
+        *indices++ = innerA;
+        *indices++ = innerB;
+    }
+
+    return indexBufferData;
+}
+}
+
+float capAngle(float surfaceRadius, float markerRadius)
+{
+    const float maxAngle = static_cast<float>(M_PI) - 0.01f;
+    return qMin(qMax(markerRadius, minRadius) / qMax(surfaceRadius, minRadius), maxAngle);
+}
+
+Data build(float surfaceRadius, float markerRadius)
+{
+    surfaceRadius = qMax(surfaceRadius, minRadius);
+    markerRadius = qMax(markerRadius, minRadius);
+
+    const float angle = capAngle(surfaceRadius, markerRadius);
+    const float renderRadius = surfaceRadius + qMax(markerRadius * 0.12f, 0.02f);
+    const float thickness = qMax(markerRadius * 0.15f, 0.01f);
+    const float innerRadius = qMax(renderRadius - thickness, minRadius);
+    const SliceTable &table = sliceTable();
+
+    Data data;
+    data.floatsPerVertex = 6;
+    data.vertexCount = vertexTotal;
+    data.indexCount = indexTotal;
+    data.vertices.resize(vertexTotal * data.floatsPerVertex * sizeof(float));
+    float *v = reinterpret_cast<float *>(data.vertices.data());
+
+    // Outer cap, dann inner cap (normals inverted)
+    for (int layer = 0; layer < 2; ++layer) {
+        const float shellRadius = layer == 0 ? renderRadius : innerRadius;
+        const float normalSign = layer == 0 ? 1.0f : -1.0f;
+
+        for (int ring = 0; ring <= rings; ++ring) {
+            const float theta = angle * static_cast<float>(ring) / static_cast<float>(rings);
+            const float sinTheta = qSin(theta);
+            const float cosTheta = qCos(theta);
+
+            for (int slice = 0; slice <= slices; ++slice) {
+                const float nx = sinTheta * table.cosPhi[slice];
+                const float ny = cosTheta;
+                const float nz = sinTheta * table.sinPhi[slice];
+
+                *v++ = nx * shellRadius;
+                *v++ = ny * shellRadius;
+                *v++ = nz * shellRadius;
+                *v++ = normalSign * nx;
+                *v++ = normalSign * ny;
+                *v++ = normalSign * nz;
+            }
+        }
+    }
+
+    // Side ring
+    const float sinTheta = qSin(angle);
+    const float cosTheta = qCos(angle);
+    for (int slice = 0; slice <= slices; ++slice) {
+        const float dx = sinTheta * table.cosPhi[slice];
+        const float dy = cosTheta;
+        const float dz = sinTheta * table.sinPhi[slice];
+
+        for (int layer = 0; layer < 2; ++layer) {
+            const float shellRadius = layer == 0 ? renderRadius : innerRadius;
+            *v++ = dx * shellRadius;
+            *v++ = dy * shellRadius;
+            *v++ = dz * shellRadius;
+            *v++ = table.cosPhi[slice];
+            *v++ = 0.0f;
+            *v++ = table.sinPhi[slice];
+        }
+    }
+
+    data.indices = buildIndices();
+    return data;
+}
+
+Data buildUnit()
+{
+    const SliceTable &table = sliceTable();
+
+    Data data;
+    data.floatsPerVertex = 4;
+    data.vertexCount = vertexTotal;
+    data.indexCount = indexTotal;
+    data.vertices.resize(vertexTotal * data.floatsPerVertex * sizeof(float));
+    float *v = reinterpret_cast<float *>(data.vertices.data());
+
+    for (int kind : {OuterCap, InnerCap}) {
+        for (int ring = 0; ring <= rings; ++ring) {
+            const float t = static_cast<float>(ring) / static_cast<float>(rings);
+            for (int slice = 0; slice <= slices; ++slice) {
+                *v++ = t;
+                *v++ = table.cosPhi[slice];
+                *v++ = table.sinPhi[slice];
+                *v++ = static_cast<float>(kind);
+            }
+        }
+    }
+
+    for (int slice = 0; slice <= slices; ++slice) {
+        for (int kind : {OuterRim, InnerRim}) {
+            *v++ = 1.0f;
+            *v++ = table.cosPhi[slice];
+            *v++ = table.sinPhi[slice];
+            *v++ = static_cast<float>(kind);
+        }
+    }
+
+    data.indices = buildIndices();
+    return data;
+}
+
+}
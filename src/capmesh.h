@@ -0,0 +1,44 @@
+#ifndef CAPMESH_H
+#define CAPMESH_H
+
+#include <QByteArray>
+
+/**
+ * @brief CapMesh - Erzeugung der Vertex- und Indexdaten fuer die Kugelkappen der Marker
+ *
+ * Verantwortlichkeiten:
+ * - Kappe mit Aussen- und Innenschale sowie Randring (16 Ringe x 32 Segmente), Dreiecke als 32-Bit-Indizes
+ * - build(): fertige Positionen und Normalen (6 Floats je Vertex) fuer einen Markerradius
+ * - buildUnit(): Einheitsparameter (t, cos phi, sin phi, Art) fuer den instanzierten Renderer,
+ *   aus denen der Vertex-Shader die Kappe je Instanz aufspannt
+ * - Reine Datenerzeugung ohne Qt3D, damit Benchmarks und Tools sie ohne GUI nutzen koennen
+ */
+namespace CapMesh {
+
+constexpr int rings = 16;
+constexpr int slices = 32;
+
+enum VertexKind {
+    OuterCap = 0,
+    InnerCap = 1,
+    OuterRim = 2,
+    InnerRim = 3
+};
+
+struct Data {
+    QByteArray vertices;  // float, interleaved
+    QByteArray indices;   // quint32
+    int floatsPerVertex = 0;
+    int vertexCount = 0;
+    int indexCount = 0;
+};
+
+// Kappenoeffnung, Schalenradien und Dicke wie bei den einzelnen Markern
+float capAngle(float surfaceRadius, float markerRadius);
+
+Data build(float surfaceRadius, float markerRadius);
+Data buildUnit();
+
+}
+
+#endif // CAPMESH_H
@@ -0,0 +1,311 @@
+#include "checkpointstore.h"
+
+#include <algorithm>
+
+namespace {
+
+// Byte-Ebenen trennen (alle ersten Bytes, dann alle zweiten, ...): Vorzeichen und Exponenten benachbarter Werte
+// liegen danach hintereinander und komprimieren deutlich besser als verschraenkt gespeicherte floats
+QByteArray encodeColumn(const QByteArray &raw, int count, int level)
+{
+    if (count <= 0 || raw.isEmpty()) {
+        return QByteArray();
+    }
+    const qsizetype elementSize = raw.size() / count;
+    QByteArray planes(raw.size(), Qt::Uninitialized);
+    const char *in = raw.constData();
+    char *out = planes.data();
+    for (qsizetype b = 0; b < elementSize; ++b) {
+        char *plane = out + b * count;
+        for (qsizetype i = 0; i < count; ++i) {
+            plane[i] = in[i * elementSize + b];
+        }
+    }
+    return qCompress(planes, level);
+}
+
+QByteArray decodeColumn(const QByteArray &packed, int count)
+{
+    if (count <= 0 || packed.isEmpty()) {
+        return QByteArray();
+    }
+    const QByteArray planes = qUncompress(packed);
+    const qsizetype elementSize = planes.size() / count;
+    QByteArray raw(planes.size(), Qt::Uninitialized);
+    const char *in = planes.constData();
+    char *out = raw.data();
+    for (qsizetype b = 0; b < elementSize; ++b) {
+        const char *plane = in + b * count;
+        for (qsizetype i = 0; i < count; ++i) {
+            out[i * elementSize + b] = plane[i];
+        }
+    }
+    return raw;
+}
+
+}
+
+void CheckpointStore::setOptions(const Options &options)
+{
+    config = options;
+    config.interval = qMax(1, config.interval);
+    config.compressionLevel = qBound(-1, config.compressionLevel, 9);
+    if (!isEnabled()) {
+        clear();
+    } else {
+        thin();
+    }
+}
+
+void CheckpointStore::clear()
+{
+    checkpoints.clear();
+    stepDurations.clear();
+    reference.clear();
+    checkpointBytes = 0;
+    endTime = 0.0;
+    changePending = false;
+}
+
+void CheckpointStore::recordStep(const SimulationCore &core, double time, quint64 step, float deltaSeconds)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    if (!checkpoints.isEmpty() && step < lastStep()) {
+        // Neuer Zweig ab einem frueheren Zustand: die aufgezeichnete Zukunft gilt nicht mehr
+        truncate(step, false, time);
+    }
+    if (!checkpoints.isEmpty() && step != lastStep()) {
+        // Luecke (z. B. Schritte vor dem Einschalten): das Protokoll waere nicht mehr zusammenhaengend
+        clear();
+    }
+
+    if (checkpoints.isEmpty() || changePending) {
+        capture(core, time, step, changePending);
+    } else if (step - checkpoints.last().step >= quint64(config.interval)) {
+        capture(core, time, step, false);
+    }
+    changePending = false;
+    stepDurations.append(deltaSeconds);
+    endTime = time + deltaSeconds;
+    thin();
+}
+
+void CheckpointStore::markChanged(quint64 step, double time)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    truncate(step, true, time);
+    changePending = true;
+}
+
+void CheckpointStore::flush(const SimulationCore &core, double time, quint64 step)
+{
+    if (!isEnabled() || !changePending) {
+        return;
+    }
+    if (!checkpoints.isEmpty() && step != lastStep()) {
+        clear();
+    }
+    capture(core, time, step, true);
+    changePending = false;
+    endTime = time;
+    thin();
+}
+
+bool CheckpointStore::seek(quint64 step, SimulationCore &core, double &time) const
+{
+    if (checkpoints.isEmpty() || step < firstStep() || step > lastStep()) {
+        return false;
+    }
+    const Checkpoint &checkpoint = checkpoints[checkpointAtOrBefore(step)];
+    if (!restore(checkpoint, core)) {
+        return false;
+    }
+    time = checkpoint.time;
+    // Zwischen zwei Checkpoints gab es keine Aenderungen, die Schritte allein ergeben denselben Zustand
+    for (quint64 s = checkpoint.step; s < step; ++s) {
+        const float deltaSeconds = stepDurations[static_cast<int>(s - firstStep())];
+        core.step(deltaSeconds);
+        time += deltaSeconds;
+    }
+    return true;
+}
+
+bool CheckpointStore::replayStep(SimulationCore &core, double &time, quint64 &step) const
+{
+    if (checkpoints.isEmpty() || step < firstStep() || step >= lastStep()) {
+        return false;
+    }
+    const float deltaSeconds = stepDurations[static_cast<int>(step - firstStep())];
+    core.step(deltaSeconds);
+    time += deltaSeconds;
+    ++step;
+    // Aenderung, die im ersten Lauf nach diesem Schritt kam (z. B. neue Dichte): ihren Checkpoint einsetzen
+    const Checkpoint &checkpoint = checkpoints[checkpointAtOrBefore(step)];
+    if (checkpoint.step == step && checkpoint.afterChange) {
+        return restore(checkpoint, core);
+    }
+    return true;
+}
+
+qint64 CheckpointStore::memoryUsage() const
+{
+    qint64 bytes = checkpointBytes + qint64(stepDurations.size()) * qint64(sizeof(float));
+    for (const QByteArray &column : reference) {
+        bytes += column.size();
+    }
+    return bytes;
+}
+
+void CheckpointStore::forEachColumn(int columns, int markers, const std::function<void(int)> &task) const
+{
+    if (markers < parallelMarkers || WorkerPool::idealThreadCount() <= 1) {
+        for (int c = 0; c < columns; ++c) {
+            task(c);
+        }
+        return;
+    }
+    if (!pool) {
+        pool = std::make_shared<WorkerPool>(WorkerPool::idealThreadCount());
+    }
+    pool->run(columns, [&task](int begin, int end, int) {
+        for (int c = begin; c < end; ++c) {
+            task(c);
+        }
+    });
+}
+
+void CheckpointStore::capture(const SimulationCore &core, double time, quint64 step, bool afterChange)
+{
+    const QVector<QByteArray> raw = core.columnBytes();
+
+    Checkpoint checkpoint;
+    checkpoint.step = step;
+    checkpoint.time = time;
+    checkpoint.afterChange = afterChange;
+    checkpoint.markers = core.size();
+    checkpoint.parameters = core.parameterCopy();
+    checkpoint.columns.reserve(raw.size());
+
+    checkpoint.columns.resize(raw.size());
+
+    const bool comparable = !checkpoints.isEmpty() && reference.size() == raw.size();
+    const QVector<QByteArray> *previous = comparable ? &checkpoints.last().columns : nullptr;
+    const int level = config.compressionLevel;
+    QByteArray *packed = checkpoint.columns.data();
+    forEachColumn(static_cast<int>(raw.size()), checkpoint.markers, [&](int c) {
+        if (previous && raw[c] == reference[c]) {
+            packed[c] = (*previous)[c];
+        } else {
+            packed[c] = encodeColumn(raw[c], checkpoint.markers, level);
+        }
+    });
+
+    reference = raw;
+    checkpoints.append(checkpoint);
+    checkpointBytes += ownBytes(static_cast<int>(checkpoints.size()) - 1);
+}
+
+bool CheckpointStore::restore(const Checkpoint &checkpoint, SimulationCore &core) const
+{
+    QVector<QByteArray> raw(checkpoint.columns.size());
+    QByteArray *columns = raw.data();
+    forEachColumn(static_cast<int>(raw.size()), checkpoint.markers, [&](int c) {
+        columns[c] = decodeColumn(checkpoint.columns[c], checkpoint.markers);
+    });
+    return core.restoreCheckpoint(checkpoint.parameters, raw);
+}
+
+void CheckpointStore::truncate(quint64 step, bool inclusive, double time)
+{
+    while (!checkpoints.isEmpty()
+           && (checkpoints.last().step > step || (inclusive && checkpoints.last().step == step))) {
+        removeCheckpoint(static_cast<int>(checkpoints.size()) - 1);
+    }
+    if (checkpoints.isEmpty()) {
+        stepDurations.clear();
+    } else if (step < lastStep()) {
+        stepDurations.resize(static_cast<int>(step - firstStep()));
+    }
+    endTime = time;
+}
+
+void CheckpointStore::removeCheckpoint(int index)
+{
+    const int next = index + 1;
+    checkpointBytes -= ownBytes(index);
+    if (next < checkpoints.size()) {
+        checkpointBytes -= ownBytes(next);
+    }
+    checkpoints.remove(index);
+    if (index < checkpoints.size()) {
+        // Der Nachfolger teilt seine unveraenderten Spalten jetzt mit einem anderen Vorgaenger (oder mit keinem)
+        checkpointBytes += ownBytes(index);
+    } else {
+        // reference gehoert nur zum juengsten Checkpoint
+        reference.clear();
+    }
+}
+
+void CheckpointStore::dropOldest()
+{
+    const quint64 oldFirst = firstStep();
+    removeCheckpoint(0);
+    stepDurations.remove(0, static_cast<int>(firstStep() - oldFirst));
+}
+
+void CheckpointStore::thin()
+{
+    while (memoryUsage() > config.memoryBudget && checkpoints.size() > 1) {
+        // Entfernt wird der Checkpoint, dessen Luecke nach dem Entfernen im Verhaeltnis zu seinem Alter am
+        // kleinsten ist. Die Abstaende wachsen so proportional zum Alter und die Anzahl nur logarithmisch mit
+        // der abgedeckten Dauer; der erste und der juengste Checkpoint bleiben stehen.
+        const quint64 now = lastStep();
+        int victim = -1;
+        double bestScore = 0.0;
+        for (int k = 1; k + 1 < checkpoints.size(); ++k) {
+            if (checkpoints[k].afterChange) {
+                continue;
+            }
+            const double gap = double(checkpoints[k + 1].step - checkpoints[k - 1].step);
+            const double age = double(now - checkpoints[k].step) + 1.0;
+            const double score = gap / age;
+            if (victim < 0 || score < bestScore) {
+                victim = k;
+                bestScore = score;
+            }
+        }
+        if (victim >= 0) {
+            removeCheckpoint(victim);
+        } else {
+            dropOldest();
+        }
+    }
+}
+
+qint64 CheckpointStore::ownBytes(int index) const
+{
+    // Mit dem Vorgaenger geteilte Spalten zaehlen nur bei ihm; geteilt wird nur zwischen benachbarten Checkpoints
+    const Checkpoint &checkpoint = checkpoints[index];
+    const Checkpoint *previous = index > 0 ? &checkpoints[index - 1] : nullptr;
+    qint64 bytes = qint64(sizeof(Checkpoint));
+    for (int c = 0; c < checkpoint.columns.size(); ++c) {
+        const QByteArray &column = checkpoint.columns[c];
+        const bool shared = previous && c < previous->columns.size() && !column.isEmpty()
+                            && column.constData() == previous->columns[c].constData();
+        if (!shared) {
+            bytes += column.size();
+        }
+    }
+    return bytes;
+}
+
+int CheckpointStore::checkpointAtOrBefore(quint64 step) const
+{
+    const auto next = std::upper_bound(checkpoints.cbegin(), checkpoints.cend(), step,
+                                       [](quint64 value, const Checkpoint &checkpoint) { return value < checkpoint.step; });
+    return qMax(0, static_cast<int>(next - checkpoints.cbegin()) - 1);
+}
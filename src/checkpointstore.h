@@ -0,0 +1,99 @@
+#ifndef CHECKPOINTSTORE_H
+#define CHECKPOINTSTORE_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+#include <memory>
+
+#include "simulationcore.h"
+#include "workerpool.h"
+
+/**
+ * @brief CheckpointStore - Checkpoints der laufenden Simulation im Speicher, Zuruecksetzen mit bitgleicher Wiederholung
+ *
+ * Verantwortlichkeiten:
+ * - Alle interval Schritte und nach jeder Aenderung ausserhalb von step() ein Checkpoint des vollstaendigen Zustands
+ *   (Parameter, alle Markerspalten, ID-Zaehler, Simulationszeit, Schrittnummer)
+ * - Spalten werden nach Byte-Ebenen umsortiert und mit zlib komprimiert; unveraenderte Spalten (Radien, Farben,
+ *   IDs, ...) teilen sich die komprimierten Daten implizit mit dem vorherigen Checkpoint
+ * - Protokoll der Schrittweiten ab dem aeltesten Checkpoint: seek() setzt den letzten Checkpoint vor dem Ziel ein
+ *   und wiederholt die protokollierten Schritte, das Ergebnis ist bitgleich zum urspruenglichen Lauf
+ * - Speicherbudget: ueberzaehlige Checkpoints werden logarithmisch ausgeduennt (Abstand waechst mit dem Alter);
+ *   Checkpoints nach Aenderungen braucht die Wiederholung, sie fallen erst mit dem aeltesten Ende weg
+ * - Ab parallelMarkers Markern werden die Spalten ueber einen eigenen WorkerPool parallel (de)komprimiert
+ * - Nicht threadsicher; wird vom Simulations-Thread neben dem Kern gehalten
+ */
+class CheckpointStore {
+public:
+    struct Options {
+        int interval = 120;                        // Schritte zwischen regulaeren Checkpoints
+        qint64 memoryBudget = qint64(256) << 20;   // Bytes fuer Checkpoints und Schrittprotokoll, 0 = aus
+        int compressionLevel = 1;                  // zlib-Stufe fuer qCompress (-1 = zlib-Standard)
+    };
+
+    CheckpointStore() = default;
+
+    const Options &options() const { return config; }
+    // Ein kleineres Budget duennt sofort aus, Budget 0 verwirft alles
+    void setOptions(const Options &options);
+    bool isEnabled() const { return config.memoryBudget > 0; }
+    void clear();
+
+    // Vor jedem Schritt aufrufen, mit Zeit und Schrittnummer vor dem Schritt: legt bei Bedarf einen Checkpoint an
+    // und protokolliert die Schrittweite. Liegt step vor dem Ende des Protokolls, wird die Zukunft verworfen.
+    void recordStep(const SimulationCore &core, double time, quint64 step, float deltaSeconds);
+    // Der Zustand wurde beim Schritt step ausserhalb von step() geaendert (Befehl aus der GUI, neues Szenario):
+    // Checkpoints und Protokoll ab step werden verworfen, flush() oder recordStep() sichern den neuen Zustand
+    void markChanged(quint64 step, double time);
+    void flush(const SimulationCore &core, double time, quint64 step);
+
+    // Setzt core auf den Zustand nach Schritt step (firstStep() <= step <= lastStep())
+    bool seek(quint64 step, SimulationCore &core, double &time) const;
+    // Wiederholt den protokollierten Schritt nach step und zaehlt time und step weiter; gab es danach eine
+    // Aenderung, wird ihr Checkpoint eingesetzt. false am Ende des Protokolls.
+    bool replayStep(SimulationCore &core, double &time, quint64 &step) const;
+
+    bool isEmpty() const { return checkpoints.isEmpty(); }
+    int checkpointCount() const { return static_cast<int>(checkpoints.size()); }
+    quint64 firstStep() const { return checkpoints.isEmpty() ? 0 : checkpoints.first().step; }
+    quint64 lastStep() const { return firstStep() + quint64(stepDurations.size()); }
+    double firstTime() const { return checkpoints.isEmpty() ? 0.0 : checkpoints.first().time; }
+    double lastTime() const { return endTime; }
+    qint64 memoryUsage() const;
+
+private:
+    struct Checkpoint {
+        quint64 step = 0;
+        double time = 0.0;
+        bool afterChange = false;      // wird nicht ausgeduennt
+        int markers = 0;
+        SimulationCore parameters;     // ohne Markerspalten (SimulationCore::parameterCopy)
+        QVector<QByteArray> columns;   // umsortiert und komprimiert, Reihenfolge wie SimulationCore::columnBytes
+    };
+
+    static constexpr int parallelMarkers = 4096;
+
+    // task(c) fuer jede Spalte c; parallel, sobald sich der Fork/Join-Aufwand lohnt
+    void forEachColumn(int columns, int markers, const std::function<void(int column)> &task) const;
+    void capture(const SimulationCore &core, double time, quint64 step, bool afterChange);
+    bool restore(const Checkpoint &checkpoint, SimulationCore &core) const;
+    void truncate(quint64 step, bool inclusive, double time);
+    void removeCheckpoint(int index);
+    void dropOldest();
+    void thin();
+    qint64 ownBytes(int index) const;
+    int checkpointAtOrBefore(quint64 step) const;
+
+    Options config;
+    QVector<Checkpoint> checkpoints;   // aufsteigend nach Schritt
+    QVector<float> stepDurations;      // Schrittweite von Schritt firstStep() + 1 + k
+    QVector<QByteArray> reference;     // rohe Spalten des juengsten Checkpoints, erkennt unveraenderte Spalten
+    qint64 checkpointBytes = 0;        // Summe von ownBytes() ueber alle Checkpoints
+    double endTime = 0.0;
+    bool changePending = false;
+    mutable std::shared_ptr<WorkerPool> pool;  // erst beim ersten grossen Checkpoint erzeugt
+};
+
+#endif // CHECKPOINTSTORE_H
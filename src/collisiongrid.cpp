@@ -0,0 +1,102 @@
+#include "collisiongrid.h"
+
+#include <QtMath>
+#include <algorithm>
+
+CollisionGrid::CollisionGrid()
+    : invCellSize(1.0f),
+      bucketMask(0)
+{
+}
+
+void CollisionGrid::build(const float *posX, const float *posY, const float *posZ, int count, float maxContactAngle)
+{
+    // Sehnenlaenge zum groessten Kontaktwinkel: naeher koennen sich beruehrende Marker im Raum nicht liegen
+    const float angle = qBound(0.0f, maxContactAngle, static_cast<float>(M_PI));
+    const float cellSize = qMax(2.0f * qSin(angle * 0.5f), 1e-4f);
+    invCellSize = 1.0f / cellSize;
+
+    quint32 bucketCount = 64;
+    while (bucketCount < static_cast<quint32>(count) * 2u) {
+        bucketCount <<= 1;
+    }
+    bucketMask = bucketCount - 1;
+
+    cellX.resize(count);
+    cellY.resize(count);
+    cellZ.resize(count);
+    bucketOfMarker.resize(count);
+    bucketEntries.resize(count);
+    bucketStart.fill(0, static_cast<int>(bucketCount) + 1);
+
+    for (int i = 0; i < count; ++i) {
+        cellX[i] = cellCoordinate(posX[i]);
+        cellY[i] = cellCoordinate(posY[i]);
+        cellZ[i] = cellCoordinate(posZ[i]);
+        const quint32 bucket = bucketOf(cellX[i], cellY[i], cellZ[i]);
+        bucketOfMarker[i] = bucket;
+        ++bucketStart[bucket + 1];
+    }
+
+    for (quint32 b = 0; b < bucketCount; ++b) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+
+    // Counting-Sort; Indizes bleiben innerhalb eines Buckets aufsteigend
+    QVector<int> cursor(bucketStart.begin(), bucketStart.end() - 1);
+    for (int i = 0; i < count; ++i) {
+        bucketEntries[cursor[bucketOfMarker[i]]++] = i;
+    }
+}
+
+void CollisionGrid::collect(int index, int firstIndex, QVector<int> &out) const
+{
+    out.clear();
+
+    const int cx = cellX[index];
+    const int cy = cellY[index];
+    const int cz = cellZ[index];
+
+    // Mehrere Nachbarzellen koennen in denselben Bucket fallen; jeden Bucket nur einmal besuchen
+    quint32 visited[27];
+    int visitedCount = 0;
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                const quint32 bucket = bucketOf(cx + dx, cy + dy, cz + dz);
+                if (std::find(visited, visited + visitedCount, bucket) != visited + visitedCount) {
+                    continue;
+                }
+                visited[visitedCount++] = bucket;
+
+                for (int k = bucketStart[bucket]; k < bucketStart[bucket + 1]; ++k) {
+                    const int j = bucketEntries[k];
+                    if (j < firstIndex || j == index) {
+                        continue;
+                    }
+                    // Hash-Kollisionen weit entfernter Zellen aussortieren
+                    if (qAbs(cellX[j] - cx) > 1 || qAbs(cellY[j] - cy) > 1 || qAbs(cellZ[j] - cz) > 1) {
+                        continue;
+                    }
+                    out.append(j);
+                }
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+}
+
+quint32 CollisionGrid::bucketOf(int cx, int cy, int cz) const
+{
+    const quint32 h = (static_cast<quint32>(cx) * 73856093u)
+                    ^ (static_cast<quint32>(cy) * 19349663u)
+                    ^ (static_cast<quint32>(cz) * 83492791u);
+    return h & bucketMask;
+}
+
+int CollisionGrid::cellCoordinate(float value) const
+{
+    return static_cast<int>(qFloor((value + 1.0f) * invCellSize));
+}
@@ -0,0 +1,45 @@
+#ifndef COLLISIONGRID_H
+#define COLLISIONGRID_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief CollisionGrid - Broad Phase der Kollisionserkennung auf der Kugeloberflaeche
+ *
+ * Verantwortlichkeiten:
+ * - Einsortieren der Marker in ein gleichmaessiges Zellgitter um die Einheitskugel (raeumlicher Hash)
+ * - Zellgroesse aus dem groessten Marker-Radius, sodass sich nur Marker benachbarter Zellen beruehren koennen
+ * - Liefern der Kandidatenpaare (i < j) in aufsteigender Reihenfolge fuer die Narrow Phase
+ * - Nachbarn in beide Richtungen, wenn nur wenige Marker erneut geprueft werden muessen
+ * - Keine Sonderbehandlung der Pole noetig, da im umgebenden 3D-Raum gerastert wird
+ */
+class CollisionGrid {
+public:
+    CollisionGrid();
+
+    // maxContactAngle: groesster Winkel (Bogenmass), bei dem sich zwei Marker beruehren koennen
+    void build(const float *posX, const float *posY, const float *posZ, int count, float maxContactAngle);
+
+    // Kandidaten j > index aus den 27 Nachbarzellen, aufsteigend sortiert
+    void candidates(int index, QVector<int> &out) const { collect(index, index + 1, out); }
+    // Alle Marker j != index aus den 27 Nachbarzellen, aufsteigend sortiert
+    void neighbours(int index, QVector<int> &out) const { collect(index, 0, out); }
+
+private:
+    void collect(int index, int firstIndex, QVector<int> &out) const;
+    quint32 bucketOf(int cx, int cy, int cz) const;
+    int cellCoordinate(float value) const;
+
+    QVector<int> cellX;
+    QVector<int> cellY;
+    QVector<int> cellZ;
+    QVector<int> bucketStart;   // Groesse bucketCount + 1
+    QVector<int> bucketEntries; // Markerindizes, nach Bucket gruppiert
+    QVector<quint32> bucketOfMarker;
+
+    float invCellSize;
+    quint32 bucketMask;
+};
+
+#endif // COLLISIONGRID_H
@@ -0,0 +1,449 @@
+#include "ensemblerunner.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QtMath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "collisiongrid.h"
+#include "scenariofile.h"
+#include "workerpool.h"
+
+namespace EnsembleRunner {
+
+namespace {
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+double relativeDrift(double energy, double reference)
+{
+    const double scale = qAbs(reference);
+    return scale > 0.0 ? qAbs(energy - reference) / scale : qAbs(energy - reference);
+}
+
+// Einzelne Zahl oder Array von Zahlen
+bool readValues(const QJsonValue &value, QVector<double> &values)
+{
+    values.clear();
+    if (value.isDouble()) {
+        values.append(value.toDouble());
+        return true;
+    }
+    if (!value.isArray()) {
+        return false;
+    }
+    for (const QJsonValue &entry : value.toArray()) {
+        if (!entry.isDouble()) {
+            return false;
+        }
+        values.append(entry.toDouble());
+    }
+    return !values.isEmpty();
+}
+
+int findRoot(QVector<int> &parent, int i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+bool parseGenerator(const QJsonObject &object, MarkerGenerator::Settings &settings, QString *error)
+{
+    settings.count = object["count"].toInt(0);
+    if (settings.count <= 0) {
+        setError(error, "generate: count muss groesser als 0 sein");
+        return false;
+    }
+    if (object.contains("distribution")
+        && !MarkerGenerator::parseDistribution(object["distribution"].toString(), settings.distribution)) {
+        setError(error, "generate: unbekannte Verteilung " + object["distribution"].toString());
+        return false;
+    }
+    settings.speed = static_cast<float>(object["speed"].toDouble(settings.speed));
+    settings.size = static_cast<float>(object["size"].toDouble(settings.size));
+    settings.density = static_cast<float>(object["density"].toDouble(settings.density));
+    settings.clusterCount = object["clusterCount"].toInt(settings.clusterCount);
+    settings.spread = static_cast<float>(object["spread"].toDouble(settings.spread));
+    settings.bandLatitude = static_cast<float>(object["bandLatitude"].toDouble(settings.bandLatitude));
+    settings.velocityDispersion = static_cast<float>(object["velocityDispersion"].toDouble(settings.velocityDispersion));
+    settings.seed = quint64(qMax(0.0, object["seed"].toDouble(double(settings.seed))));
+    if (settings.size <= 0.0f || settings.density <= 0.0f) {
+        setError(error, "generate: size und density muessen groesser als 0 sein");
+        return false;
+    }
+    return true;
+}
+
+bool parseCore(const QJsonObject &description, SimulationCore &core, QString *error)
+{
+    if (description.contains("integrator")) {
+        SimulationCore::Integrator integrator;
+        if (!SimulationCore::parseIntegrator(description["integrator"].toString(), integrator)) {
+            setError(error, "Unbekannter Integrator: " + description["integrator"].toString());
+            return false;
+        }
+        core.setIntegrator(integrator);
+    }
+    if (description.contains("precision")) {
+        SimulationCore::Precision precision;
+        if (!SimulationCore::parsePrecision(description["precision"].toString(), precision)) {
+            setError(error, "Unbekannte Genauigkeit: " + description["precision"].toString());
+            return false;
+        }
+        core.setPrecision(precision);
+    }
+    if (description.contains("solver")) {
+        SimulationCore::ForceSolver solver;
+        if (!SimulationCore::parseForceSolver(description["solver"].toString(), solver)) {
+            setError(error, "Unbekannter Kraftloeser: " + description["solver"].toString());
+            return false;
+        }
+        core.setForceSolver(solver);
+    }
+    if (description.contains("theta")) {
+        core.setOpeningAngle(static_cast<float>(description["theta"].toDouble()));
+    }
+    if (description.contains("collisions")) {
+        SimulationCore::CollisionMode mode;
+        if (!SimulationCore::parseCollisionMode(description["collisions"].toString(), mode)) {
+            setError(error, "Unbekannter Kollisionsmodus: " + description["collisions"].toString());
+            return false;
+        }
+        core.setCollisionMode(mode);
+    }
+    core.setContinuousCollisions(description["continuousCollisions"].toBool(true));
+    // Parallel wird ueber die Varianten gerechnet, nicht innerhalb eines Laufs
+    core.setThreadCount(1);
+    return true;
+}
+}
+
+QVector<Variant> Sweep::variants() const
+{
+    const QVector<float> gravities = gravityConstants.isEmpty() ? QVector<float>{base.gravityConstant()}
+                                                                : gravityConstants;
+    const QVector<quint64> seedList = seeds.isEmpty() ? QVector<quint64>{generator.seed} : seeds;
+
+    QVector<Variant> list;
+    list.reserve(densityScales.size() * speedScales.size() * gravities.size() * seedList.size());
+    for (float densityScale : densityScales) {
+        for (float speedScale : speedScales) {
+            for (float gravity : gravities) {
+                for (quint64 seed : seedList) {
+                    list.append({densityScale, speedScale, gravity, seed});
+                }
+            }
+        }
+    }
+    return list;
+}
+
+bool parseSweep(const QJsonObject &description, const QString &baseDirectory, Sweep &sweep, QString *error)
+{
+    Sweep parsed;
+    if (!parseCore(description, parsed.base, error)) {
+        return false;
+    }
+
+    const bool hasScenario = description.contains("scenario");
+    const bool hasGenerator = description.contains("generate");
+    if (hasScenario == hasGenerator) {
+        setError(error, "Genau eines der Felder scenario oder generate angeben");
+        return false;
+    }
+    if (hasScenario) {
+        // Szenario wie beim Laden in der GUI: Datei ueber ScenarioFile, eingebettet ueber SimulationCore::applyScenario
+        const QJsonValue scenario = description["scenario"];
+        if (scenario.isObject()) {
+            if (!parsed.base.applyScenario(scenario.toObject())) {
+                setError(error, "Szenario enthaelt kein Marker-Array");
+                return false;
+            }
+        } else {
+            const QString path = QDir(baseDirectory).filePath(scenario.toString());
+            QString loadError;
+            if (!ScenarioFile::load(path, parsed.base, nullptr, &loadError)) {
+                setError(error, path + ": " + loadError);
+                return false;
+            }
+        }
+    } else {
+        if (!description["generate"].isObject()) {
+            setError(error, "generate muss ein Objekt sein");
+            return false;
+        }
+        if (!parseGenerator(description["generate"].toObject(), parsed.generator, error)) {
+            return false;
+        }
+        parsed.generate = true;
+    }
+
+    if (description.contains("dt")) {
+        parsed.dt = static_cast<float>(description["dt"].toDouble());
+    }
+    if (!(parsed.dt > 0.0f)) {
+        setError(error, "dt muss groesser als 0 sein");
+        return false;
+    }
+    if (description.contains("steps") == description.contains("seconds")) {
+        setError(error, "Genau eines der Felder steps oder seconds angeben");
+        return false;
+    }
+    parsed.steps = description.contains("steps") ? qint64(description["steps"].toDouble(-1.0))
+                                                 : qRound64(description["seconds"].toDouble(-1.0) / parsed.dt);
+    if (parsed.steps < 0) {
+        setError(error, "Ungueltige Schrittanzahl");
+        return false;
+    }
+    parsed.energySamples = qMax(1, description["energySamples"].toInt(parsed.energySamples));
+    parsed.clusterContactFactor = static_cast<float>(description["clusterContactFactor"].toDouble(parsed.clusterContactFactor));
+
+    const QJsonObject ranges = description["sweep"].toObject();
+    QVector<double> values;
+    const struct {
+        const char *key;
+        QVector<float> *target;
+    } floatRanges[] = {
+        {"densityScale", &parsed.densityScales},
+        {"speedScale", &parsed.speedScales},
+        {"gravityConstant", &parsed.gravityConstants},
+    };
+    for (const auto &range : floatRanges) {
+        if (!ranges.contains(range.key)) {
+            continue;
+        }
+        if (!readValues(ranges[range.key], values)) {
+            setError(error, QString("sweep.%1: Zahl oder Array von Zahlen erwartet").arg(range.key));
+            return false;
+        }
+        range.target->clear();
+        for (double value : values) {
+            range.target->append(static_cast<float>(value));
+        }
+    }
+    for (float scale : parsed.densityScales) {
+        if (!(scale > 0.0f)) {
+            setError(error, "sweep.densityScale: Faktoren muessen groesser als 0 sein");
+            return false;
+        }
+    }
+    for (float scale : parsed.speedScales) {
+        if (scale < 0.0f) {
+            setError(error, "sweep.speedScale: Faktoren duerfen nicht negativ sein");
+            return false;
+        }
+    }
+
+    if (ranges.contains("seed")) {
+        if (!parsed.generate) {
+            // Ein geladenes Szenario haengt von keinem Seed ab, jede Variante waere identisch
+            setError(error, "sweep.seed ist nur zusammen mit generate moeglich");
+            return false;
+        }
+        if (!readValues(ranges["seed"], values)) {
+            setError(error, "sweep.seed: Zahl oder Array von Zahlen erwartet");
+            return false;
+        }
+        for (double value : values) {
+            if (value < 0.0 || value != qFloor(value)) {
+                setError(error, "sweep.seed: nichtnegative ganze Zahlen erwartet");
+                return false;
+            }
+            parsed.seeds.append(quint64(value));
+        }
+    }
+
+    sweep = parsed;
+    return true;
+}
+
+Result runVariant(const Sweep &sweep, const Variant &variant)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    SimulationCore core = sweep.base;
+    core.setThreadCount(1);
+    if (sweep.generate) {
+        MarkerGenerator::Settings settings = sweep.generator;
+        settings.seed = variant.seed;
+        core.generateMarkers(settings);
+    }
+    core.setGravityConstant(variant.gravityConstant);
+    const int n = core.size();
+    if (variant.densityScale != 1.0f) {
+        for (int i = 0; i < n; ++i) {
+            core.setMarkerDensity(i, core.density(i) * variant.densityScale);
+        }
+    }
+    if (variant.speedScale != 1.0f) {
+        for (int i = 0; i < n; ++i) {
+            core.setMarkerVelocityMagnitude(i, core.velocity(i).length() * variant.speedScale);
+        }
+    }
+
+    Result result;
+    result.variant = variant;
+    result.initialMarkers = n;
+    result.steps = sweep.steps;
+    result.initialEnergy = core.totalEnergy();
+
+    double energy = result.initialEnergy;
+    qint64 done = 0;
+    for (int sample = 1; sample <= sweep.energySamples; ++sample) {
+        const qint64 target = (sweep.steps * sample) / sweep.energySamples;
+        for (; done < target; ++done) {
+            core.step(sweep.dt);
+            result.collisions += core.collisionCount();
+            result.sweptContacts += core.sweptContactCount();
+            result.merges += core.mergeCount();
+        }
+        energy = core.totalEnergy();
+        result.maxEnergyDrift = qMax(result.maxEnergyDrift, relativeDrift(energy, result.initialEnergy));
+    }
+
+    result.finalMarkers = core.size();
+    result.finalEnergy = energy;
+    result.finalEnergyDrift = relativeDrift(energy, result.initialEnergy);
+    result.clusters = clusterCount(core, sweep.clusterContactFactor, &result.largestCluster);
+    result.wallMilliseconds = timer.nsecsElapsed() / 1.0e6;
+    return result;
+}
+
+QVector<Result> run(const Sweep &sweep, int threads, const std::function<void(int, int, const Result &)> &progress)
+{
+    const QVector<Variant> variants = sweep.variants();
+    const int total = static_cast<int>(variants.size());
+    QVector<Result> results(total);
+    if (total == 0) {
+        return results;
+    }
+
+    // Jeder Thread holt sich die naechste freie Variante; die Laeufe sind unabhaengig, nur der Fortschritt wird
+    // serialisiert. Die Ergebnisse stehen unabhaengig von der Abarbeitungsreihenfolge an ihrem Index.
+    std::atomic<int> next{0};
+    int finished = 0;
+    std::mutex progressMutex;
+    Result *slots = results.data();
+    auto work = [&]() {
+        for (int index = next++; index < total; index = next++) {
+            slots[index] = runVariant(sweep, variants[index]);
+            std::lock_guard<std::mutex> lock(progressMutex);
+            ++finished;
+            if (progress) {
+                progress(finished, total, slots[index]);
+            }
+        }
+    };
+
+    const int workers = qBound(1, threads > 0 ? threads : WorkerPool::idealThreadCount(), total);
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (int t = 1; t < workers; ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    return results;
+}
+
+QString toCsv(const QVector<Result> &results, float dt)
+{
+    QString text = "run,densityScale,speedScale,gravityConstant,seed,markers,finalMarkers,steps,simulatedSeconds,"
+                   "collisions,sweptContacts,merges,initialEnergy,finalEnergy,energyDriftFinal,energyDriftMax,"
+                   "clusters,largestCluster,wallMs\n";
+    for (int r = 0; r < results.size(); ++r) {
+        const Result &result = results[r];
+        const Variant &variant = result.variant;
+        text += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,")
+            .arg(r)
+            .arg(variant.densityScale, 0, 'g', 9)
+            .arg(variant.speedScale, 0, 'g', 9)
+            .arg(variant.gravityConstant, 0, 'g', 9)
+            .arg(variant.seed)
+            .arg(result.initialMarkers)
+            .arg(result.finalMarkers)
+            .arg(result.steps)
+            .arg(result.steps * double(dt), 0, 'g', 9);
+        text += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10\n")
+            .arg(result.collisions)
+            .arg(result.sweptContacts)
+            .arg(result.merges)
+            .arg(result.initialEnergy, 0, 'g', 12)
+            .arg(result.finalEnergy, 0, 'g', 12)
+            .arg(result.finalEnergyDrift, 0, 'e', 4)
+            .arg(result.maxEnergyDrift, 0, 'e', 4)
+            .arg(result.clusters)
+            .arg(result.largestCluster)
+            .arg(result.wallMilliseconds, 0, 'f', 1);
+    }
+    return text;
+}
+
+int clusterCount(const SimulationCore &core, float contactFactor, int *largest)
+{
+    const int n = core.size();
+    if (largest) {
+        *largest = 0;
+    }
+    if (n < 2) {
+        return 0;
+    }
+
+    float maxRadius = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        maxRadius = qMax(maxRadius, core.radius(i));
+    }
+    const float factor = qMax(0.0f, contactFactor);
+
+    // Broad Phase wie bei den Kollisionen, nur mit aufgeweitetem Kontaktwinkel
+    CollisionGrid grid;
+    grid.build(core.positionsX(), core.positionsY(), core.positionsZ(), n,
+               factor * 2.0f * maxRadius / SimulationCore::sphereRadius);
+
+    QVector<int> parent(n);
+    for (int i = 0; i < n; ++i) {
+        parent[i] = i;
+    }
+    QVector<int> candidates;
+    for (int i = 0; i < n; ++i) {
+        const Vec3 pi = core.position(i);
+        grid.candidates(i, candidates);
+        for (int j : candidates) {
+            const float dot = qBound(-1.0f, Vec3::dot(pi, core.position(j)), 1.0f);
+            if (qAcos(dot) <= factor * (core.radius(i) + core.radius(j)) / SimulationCore::sphereRadius) {
+                parent[findRoot(parent, j)] = findRoot(parent, i);
+            }
+        }
+    }
+
+    QVector<int> members(n, 0);
+    for (int i = 0; i < n; ++i) {
+        ++members[findRoot(parent, i)];
+    }
+    int clusters = 0;
+    for (int count : members) {
+        if (count >= 2) {
+            ++clusters;
+            if (largest) {
+                *largest = qMax(*largest, count);
+            }
+        }
+    }
+    return clusters;
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef ENSEMBLERUNNER_H
+#define ENSEMBLERUNNER_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+#include "markergenerator.h"
+#include "simulationcore.h"
+
+/**
+ * @brief EnsembleRunner - Parameterstudien: viele Varianten eines Szenarios ohne GUI, parallel ueber alle Kerne
+ *
+ * Verantwortlichkeiten:
+ * - Liest eine Sweep-Beschreibung (JSON): Startszenario als Datei, eingebettetes Szenario oder Generator-Einstellungen,
+ *   Laufzeit und Kern-Parameter sowie Wertelisten fuer Dichte- und Geschwindigkeitsfaktor, Gravitationskonstante und Seed
+ * - Jede Kombination der Wertelisten ist eine Variante mit eigenem SimulationCore (einfaedig); die Varianten laufen
+ *   gleichzeitig auf bis zu threads Threads, das Ergebnis haengt nicht von der Thread-Anzahl ab
+ * - Kennzahlen je Lauf: Stoesse, Kontakte waehrend des Schritts, Verschmelzungen, Energiedrift (End- und Maximalwert),
+ *   Cluster sich beruehrender Marker am Ende und Wall-Clock-Zeit
+ * - Ausgabe als CSV, eine Zeile je Variante in der Reihenfolge der Sweep-Beschreibung
+ *
+ * Aufbau der Sweep-Beschreibung (alle Felder ausser "scenario"/"generate" und "steps"/"seconds" optional):
+ *   {
+ *     "scenario": "start.grvb",                // relativ zur Sweep-Datei; alternativ ein Szenario-Objekt
+ *     "generate": {"count": 2000, "distribution": "clustered", "speed": 0.5, "size": 0.02, "density": 1.0,
+ *                  "clusterCount": 4, "spread": 0.2, "velocityDispersion": 0.0, "seed": 1},
+ *     "steps": 3600, "seconds": 60.0, "dt": 0.0166667,
+ *     "integrator": "leapfrog", "precision": "float", "solver": "direct", "theta": 0.5,
+ *     "collisions": "elastic", "continuousCollisions": true,
+ *     "energySamples": 8, "clusterContactFactor": 1.1,
+ *     "sweep": {"densityScale": [0.5, 1, 2], "speedScale": [1], "gravityConstant": [1e-3], "seed": [1, 2, 3]}
+ *   }
+ */
+namespace EnsembleRunner {
+
+struct Variant {
+    float densityScale = 1.0f;     // Faktor auf die Dichte jedes Markers
+    float speedScale = 1.0f;       // Faktor auf den Geschwindigkeitsbetrag jedes Markers
+    float gravityConstant = 0.0f;
+    quint64 seed = 1;              // nur mit "generate"
+};
+
+struct Sweep {
+    SimulationCore base;           // Parameter und (ohne generate) die Startmarker
+    bool generate = false;
+    MarkerGenerator::Settings generator;
+    qint64 steps = 0;
+    float dt = 1.0f / 60.0f;
+    int energySamples = 8;         // Energieauswertungen je Lauf (O(N^2) bzw. O(N log N) je Auswertung)
+    float clusterContactFactor = 1.1f;  // Marker gelten als verbunden bis zum Faktor mal der Summe der Radien
+    QVector<float> densityScales{1.0f};
+    QVector<float> speedScales{1.0f};
+    QVector<float> gravityConstants;    // leer = Wert aus base
+    QVector<quint64> seeds;             // leer = Seed aus generator
+
+    // Kartesisches Produkt der Wertelisten; der Seed laeuft am schnellsten
+    QVector<Variant> variants() const;
+};
+
+struct Result {
+    Variant variant;
+    int initialMarkers = 0;
+    int finalMarkers = 0;
+    qint64 steps = 0;
+    qint64 collisions = 0;         // aufgeloeste Stoesse inklusive Verschmelzungen (SimulationCore::collisionCount)
+    qint64 sweptContacts = 0;
+    qint64 merges = 0;
+    double initialEnergy = 0.0;
+    double finalEnergy = 0.0;
+    double finalEnergyDrift = 0.0; // |E - E0| / |E0|
+    double maxEnergyDrift = 0.0;
+    int clusters = 0;              // Gruppen aus mindestens zwei sich beruehrenden Markern
+    int largestCluster = 0;
+    double wallMilliseconds = 0.0;
+};
+
+// baseDirectory loest relative Szenario-Pfade auf; bei einem Fehler bleibt sweep unveraendert
+bool parseSweep(const QJsonObject &description, const QString &baseDirectory, Sweep &sweep, QString *error = nullptr);
+
+Result runVariant(const Sweep &sweep, const Variant &variant);
+// threads: 0 = alle verfuegbaren Kerne; progress wird nach jedem Lauf aufgerufen (serialisiert, beliebiger Thread)
+QVector<Result> run(const Sweep &sweep, int threads = 0,
+                    const std::function<void(int finished, int total, const Result &result)> &progress = {});
+
+QString toCsv(const QVector<Result> &results, float dt);
+
+// Zusammenhangskomponenten mit mindestens zwei Markern, deren Abstand hoechstens contactFactor mal der Summe der
+// Radien betraegt; largest erhaelt die groesste Komponente (0, wenn es keine gibt)
+int clusterCount(const SimulationCore &core, float contactFactor, int *largest = nullptr);
+
+}
+
+#endif // ENSEMBLERUNNER_H
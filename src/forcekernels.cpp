@@ -0,0 +1,332 @@
+#include "forcekernels.h"
+
+#include <QtGlobal>
+#include <QtMath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GRAVITY_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(GRAVITY_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GRAVITY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define GRAVITY_TARGET_AVX2
+#endif
+
+namespace ForceKernels {
+
+namespace {
+constexpr float epsilon = 1e-4f;
+constexpr float fullCircle = static_cast<float>(2.0 * M_PI);
+constexpr float pi = static_cast<float>(M_PI);
+
+// Koeffizienten Abramowitz/Stegun 4.4.46: acos(x) = sqrt(1 - x) * P(x) fuer 0 <= x <= 1
+constexpr float c0 = 1.5707963050f;
+constexpr float c1 = -0.2145988016f;
+constexpr float c2 = 0.0889789874f;
+constexpr float c3 = -0.0501743046f;
+constexpr float c4 = 0.0308918810f;
+constexpr float c5 = -0.0170881256f;
+constexpr float c6 = 0.0066700901f;
+constexpr float c7 = -0.0012624911f;
+
+// Beitrag eines Partners mit acos-Naeherung; fuer den Rest der vektorisierten Schleifen
+inline void accumulateApprox(const Input &in, float pix, float piy, float piz, int j,
+                             float &ax, float &ay, float &az)
+{
+    const float dot = qBound(-1.0f, pix * in.posX[j] + piy * in.posY[j] + piz * in.posZ[j], 1.0f);
+    const float tangentLengthSq = 1.0f - dot * dot;
+    if (tangentLengthSq < epsilon) {
+        return;
+    }
+    const float arc = qMax(acosApprox(dot), epsilon);
+    const float otherArc = qMax(fullCircle - arc, epsilon);
+    const float scale = in.gravityConstant * in.mass[j] * ((1.0f / (arc * arc)) - (1.0f / (otherArc * otherArc)))
+                      / qSqrt(tangentLengthSq);
+    ax += scale * (in.posX[j] - dot * pix);
+    ay += scale * (in.posY[j] - dot * piy);
+    az += scale * (in.posZ[j] - dot * piz);
+}
+
+void accumulateRowsScalar(const Input &in, int begin, int end, float *accX, float *accY, float *accZ)
+{
+    for (int i = begin; i < end; ++i) {
+        const float pix = in.posX[i];
+        const float piy = in.posY[i];
+        const float piz = in.posZ[i];
+        float ax = 0.0f;
+        float ay = 0.0f;
+        float az = 0.0f;
+
+        for (int j = 0; j < in.count; ++j) {
+            // j == i faellt ueber 1 - dot^2 < epsilon heraus
+            const float dot = qBound(-1.0f, pix * in.posX[j] + piy * in.posY[j] + piz * in.posZ[j], 1.0f);
+            const float tangentLengthSq = 1.0f - dot * dot;
+            if (tangentLengthSq < epsilon) {
+                continue;
+            }
+            const float arc = qMax(qAcos(dot), epsilon);
+            const float otherArc = qMax(fullCircle - arc, epsilon);
+            const float scale = in.gravityConstant * in.mass[j] * ((1.0f / (arc * arc)) - (1.0f / (otherArc * otherArc)))
+                              / qSqrt(tangentLengthSq);
+            ax += scale * (in.posX[j] - dot * pix);
+            ay += scale * (in.posY[j] - dot * piy);
+            az += scale * (in.posZ[j] - dot * piz);
+        }
+
+        accX[i] = ax;
+        accY[i] = ay;
+        accZ[i] = az;
+    }
+}
+
+#if defined(GRAVITY_KERNELS_X86)
+void accumulateRowsSse2(const Input &in, int begin, int end, float *accX, float *accY, float *accZ)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 eps = _mm_set1_ps(epsilon);
+    const __m128 piV = _mm_set1_ps(pi);
+    const __m128 circle = _mm_set1_ps(fullCircle);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 gravity = _mm_set1_ps(in.gravityConstant);
+    const int vectorEnd = in.count & ~3;
+
+    for (int i = begin; i < end; ++i) {
+        const float pix = in.posX[i];
+        const float piy = in.posY[i];
+        const float piz = in.posZ[i];
+        const __m128 px = _mm_set1_ps(pix);
+        const __m128 py = _mm_set1_ps(piy);
+        const __m128 pz = _mm_set1_ps(piz);
+        __m128 ax = _mm_setzero_ps();
+        __m128 ay = _mm_setzero_ps();
+        __m128 az = _mm_setzero_ps();
+
+        for (int j = 0; j < vectorEnd; j += 4) {
+            const __m128 qx = _mm_loadu_ps(in.posX + j);
+            const __m128 qy = _mm_loadu_ps(in.posY + j);
+            const __m128 qz = _mm_loadu_ps(in.posZ + j);
+            const __m128 m = _mm_loadu_ps(in.mass + j);
+
+            __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, qx), _mm_mul_ps(py, qy)), _mm_mul_ps(pz, qz));
+            dot = _mm_min_ps(_mm_max_ps(dot, minusOne), one);
+
+            const __m128 tangentLengthSq = _mm_sub_ps(one, _mm_mul_ps(dot, dot));
+            const __m128 valid = _mm_cmpge_ps(tangentLengthSq, eps);
+
+            // acos(|d|) = sqrt(1 - |d|) * P(|d|), fuer d < 0: pi - acos(|d|)
+            const __m128 absDot = _mm_andnot_ps(signMask, dot);
+            __m128 poly = _mm_set1_ps(c7);
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c6));
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c5));
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c4));
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c3));
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c2));
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c1));
+            poly = _mm_add_ps(_mm_mul_ps(poly, absDot), _mm_set1_ps(c0));
+            __m128 angle = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, absDot)), poly);
+            const __m128 negative = _mm_cmplt_ps(dot, _mm_setzero_ps());
+            angle = _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(piV, angle)), _mm_andnot_ps(negative, angle));
+
+            const __m128 arc = _mm_max_ps(angle, eps);
+            const __m128 otherArc = _mm_max_ps(_mm_sub_ps(circle, arc), eps);
+            const __m128 law = _mm_sub_ps(_mm_div_ps(one, _mm_mul_ps(arc, arc)),
+                                          _mm_div_ps(one, _mm_mul_ps(otherArc, otherArc)));
+            __m128 scale = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(gravity, m), law), _mm_sqrt_ps(_mm_max_ps(tangentLengthSq, eps)));
+            scale = _mm_and_ps(scale, valid);
+
+            ax = _mm_add_ps(ax, _mm_mul_ps(scale, _mm_sub_ps(qx, _mm_mul_ps(dot, px))));
+            ay = _mm_add_ps(ay, _mm_mul_ps(scale, _mm_sub_ps(qy, _mm_mul_ps(dot, py))));
+            az = _mm_add_ps(az, _mm_mul_ps(scale, _mm_sub_ps(qz, _mm_mul_ps(dot, pz))));
+        }
+
+        alignas(16) float lanesX[4];
+        alignas(16) float lanesY[4];
+        alignas(16) float lanesZ[4];
+        _mm_store_ps(lanesX, ax);
+        _mm_store_ps(lanesY, ay);
+        _mm_store_ps(lanesZ, az);
+        float sx = (lanesX[0] + lanesX[1]) + (lanesX[2] + lanesX[3]);
+        float sy = (lanesY[0] + lanesY[1]) + (lanesY[2] + lanesY[3]);
+        float sz = (lanesZ[0] + lanesZ[1]) + (lanesZ[2] + lanesZ[3]);
+
+        for (int j = vectorEnd; j < in.count; ++j) {
+            accumulateApprox(in, pix, piy, piz, j, sx, sy, sz);
+        }
+
+        accX[i] = sx;
+        accY[i] = sy;
+        accZ[i] = sz;
+    }
+}
+
+GRAVITY_TARGET_AVX2
+void accumulateRowsAvx2(const Input &in, int begin, int end, float *accX, float *accY, float *accZ)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 eps = _mm256_set1_ps(epsilon);
+    const __m256 piV = _mm256_set1_ps(pi);
+    const __m256 circle = _mm256_set1_ps(fullCircle);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 gravity = _mm256_set1_ps(in.gravityConstant);
+    const int vectorEnd = in.count & ~7;
+
+    for (int i = begin; i < end; ++i) {
+        const float pix = in.posX[i];
+        const float piy = in.posY[i];
+        const float piz = in.posZ[i];
+        const __m256 px = _mm256_set1_ps(pix);
+        const __m256 py = _mm256_set1_ps(piy);
+        const __m256 pz = _mm256_set1_ps(piz);
+        __m256 ax = _mm256_setzero_ps();
+        __m256 ay = _mm256_setzero_ps();
+        __m256 az = _mm256_setzero_ps();
+
+        for (int j = 0; j < vectorEnd; j += 8) {
+            const __m256 qx = _mm256_loadu_ps(in.posX + j);
+            const __m256 qy = _mm256_loadu_ps(in.posY + j);
+            const __m256 qz = _mm256_loadu_ps(in.posZ + j);
+            const __m256 m = _mm256_loadu_ps(in.mass + j);
+
+            __m256 dot = _mm256_fmadd_ps(pz, qz, _mm256_fmadd_ps(py, qy, _mm256_mul_ps(px, qx)));
+            dot = _mm256_min_ps(_mm256_max_ps(dot, minusOne), one);
+
+            const __m256 tangentLengthSq = _mm256_fnmadd_ps(dot, dot, one);
+            const __m256 valid = _mm256_cmp_ps(tangentLengthSq, eps, _CMP_GE_OQ);
+
+            const __m256 absDot = _mm256_andnot_ps(signMask, dot);
+            __m256 poly = _mm256_set1_ps(c7);
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c6));
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c5));
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c4));
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c3));
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c2));
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c1));
+            poly = _mm256_fmadd_ps(poly, absDot, _mm256_set1_ps(c0));
+            __m256 angle = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(one, absDot)), poly);
+            const __m256 negative = _mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ);
+            angle = _mm256_blendv_ps(angle, _mm256_sub_ps(piV, angle), negative);
+
+            const __m256 arc = _mm256_max_ps(angle, eps);
+            const __m256 otherArc = _mm256_max_ps(_mm256_sub_ps(circle, arc), eps);
+            const __m256 law = _mm256_sub_ps(_mm256_div_ps(one, _mm256_mul_ps(arc, arc)),
+                                             _mm256_div_ps(one, _mm256_mul_ps(otherArc, otherArc)));
+            __m256 scale = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(gravity, m), law),
+                                         _mm256_sqrt_ps(_mm256_max_ps(tangentLengthSq, eps)));
+            scale = _mm256_and_ps(scale, valid);
+
+            ax = _mm256_fmadd_ps(scale, _mm256_fnmadd_ps(dot, px, qx), ax);
+            ay = _mm256_fmadd_ps(scale, _mm256_fnmadd_ps(dot, py, qy), ay);
+            az = _mm256_fmadd_ps(scale, _mm256_fnmadd_ps(dot, pz, qz), az);
+        }
+
+        alignas(32) float lanesX[8];
+        alignas(32) float lanesY[8];
+        alignas(32) float lanesZ[8];
+        _mm256_store_ps(lanesX, ax);
+        _mm256_store_ps(lanesY, ay);
+        _mm256_store_ps(lanesZ, az);
+        float sx = ((lanesX[0] + lanesX[1]) + (lanesX[2] + lanesX[3])) + ((lanesX[4] + lanesX[5]) + (lanesX[6] + lanesX[7]));
+        float sy = ((lanesY[0] + lanesY[1]) + (lanesY[2] + lanesY[3])) + ((lanesY[4] + lanesY[5]) + (lanesY[6] + lanesY[7]));
+        float sz = ((lanesZ[0] + lanesZ[1]) + (lanesZ[2] + lanesZ[3])) + ((lanesZ[4] + lanesZ[5]) + (lanesZ[6] + lanesZ[7]));
+
+        for (int j = vectorEnd; j < in.count; ++j) {
+            accumulateApprox(in, pix, piy, piz, j, sx, sy, sz);
+        }
+
+        accX[i] = sx;
+        accY[i] = sy;
+        accZ[i] = sz;
+    }
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif // GRAVITY_KERNELS_X86
+}
+
+float acosApprox(float x)
+{
+    const float a = qAbs(x);
+    float poly = c7;
+    poly = poly * a + c6;
+    poly = poly * a + c5;
+    poly = poly * a + c4;
+    poly = poly * a + c3;
+    poly = poly * a + c2;
+    poly = poly * a + c1;
+    poly = poly * a + c0;
+    const float angle = qSqrt(1.0f - a) * poly;
+    return x < 0.0f ? pi - angle : angle;
+}
+
+InstructionSet detectInstructionSet()
+{
+#if defined(GRAVITY_KERNELS_X86)
+    static const InstructionSet detected = cpuSupportsAvx2() ? InstructionSet::AVX2 : InstructionSet::SSE2;
+    return detected;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+const char *instructionSetName(InstructionSet isa)
+{
+    switch (isa) {
+    case InstructionSet::AVX2:
+        return "avx2";
+    case InstructionSet::SSE2:
+        return "sse2";
+    case InstructionSet::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+void accumulateRows(const Input &input, int begin, int end,
+                    float *accX, float *accY, float *accZ,
+                    InstructionSet isa)
+{
+#if defined(GRAVITY_KERNELS_X86)
+    if (isa == InstructionSet::AVX2 && detectInstructionSet() == InstructionSet::AVX2) {
+        accumulateRowsAvx2(input, begin, end, accX, accY, accZ);
+        return;
+    }
+    if (isa != InstructionSet::Scalar) {
+        accumulateRowsSse2(input, begin, end, accX, accY, accZ);
+        return;
+    }
+#else
+    Q_UNUSED(isa);
+#endif
+    accumulateRowsScalar(input, begin, end, accX, accY, accZ);
+}
+
+}
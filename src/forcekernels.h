@@ -0,0 +1,44 @@
+#ifndef FORCEKERNELS_H
+#define FORCEKERNELS_H
+
+/**
+ * @brief ForceKernels - Vektorisierte direkte Kraftberechnung ueber SoA-Positionsarrays
+ *
+ * Verantwortlichkeiten:
+ * - Zeilenweise Summation der Beschleunigungen (Marker i gegen alle Partner j)
+ * - AVX2/FMA-Kernel (8 Partner pro Schritt) und SSE2-Kernel (4 Partner pro Schritt)
+ * - Vektorisierte acos-Naeherung mit beschraenktem Fehler (|Fehler| <= 2e-8 rad vor Float-Rundung)
+ * - Auswahl des Kernels zur Laufzeit anhand der CPU-Features, skalarer Pfad als Fallback
+ */
+namespace ForceKernels {
+
+enum class InstructionSet {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+struct Input {
+    const float *posX;
+    const float *posY;
+    const float *posZ;
+    const float *mass;
+    int count;
+    float gravityConstant;
+};
+
+// Beste auf dieser CPU verfuegbare Befehlssatzerweiterung (einmalig ermittelt)
+InstructionSet detectInstructionSet();
+const char *instructionSetName(InstructionSet isa);
+
+// Beschleunigungen der Zeilen [begin, end); ueberschreibt accX/accY/accZ an diesen Indizes
+void accumulateRows(const Input &input, int begin, int end,
+                    float *accX, float *accY, float *accZ,
+                    InstructionSet isa);
+
+// acos-Naeherung nach Abramowitz/Stegun 4.4.46, identisch zum vektorisierten Pfad
+float acosApprox(float x);
+
+}
+
+#endif // FORCEKERNELS_H
@@ -0,0 +1,227 @@
+#include "frameprofiler.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+
+std::atomic<bool> FrameProfiler::enabledFlag(false);
+
+namespace {
+const auto profilerEpoch = std::chrono::steady_clock::now();
+
+double percentile(QVector<double> &values, double fraction)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    const int index = qBound(0, static_cast<int>(fraction * (values.size() - 1) + 0.5), static_cast<int>(values.size()) - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+}
+
+FrameProfiler::FrameProfiler()
+    : slots(new Slot[capacity]),
+      head(0)
+{
+}
+
+FrameProfiler &FrameProfiler::instance()
+{
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+    if (enabled) {
+        instance(); // Ringpuffer anlegen, bevor der erste Scope misst
+    }
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+const char *FrameProfiler::phaseName(Phase phase)
+{
+    switch (phase) {
+    case Frame: return "Frame";
+    case TransformSync: return "TransformSync";
+    case ColorSync: return "ColorSync";
+    case InstanceUpload: return "InstanceUpload";
+    case PlaybackDecode: return "PlaybackDecode";
+    case SimulationStep: return "SimulationStep";
+    case Integration: return "Integration";
+    case Force: return "Force";
+    case Collisions: return "Collisions";
+    case SnapshotPublish: return "SnapshotPublish";
+    case PhaseCount: break;
+    }
+    return "?";
+}
+
+qint64 FrameProfiler::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+int FrameProfiler::currentThreadIndex()
+{
+    thread_local int index = -1;
+    if (index < 0) {
+        FrameProfiler &profiler = instance();
+        std::lock_guard<std::mutex> lock(profiler.threadMutex);
+        index = static_cast<int>(profiler.threadNames.size());
+        profiler.threadNames.append(QString("Thread %1").arg(index).toUtf8());
+    }
+    return index;
+}
+
+void FrameProfiler::setThreadName(const char *name)
+{
+    const int index = currentThreadIndex();
+    FrameProfiler &profiler = instance();
+    std::lock_guard<std::mutex> lock(profiler.threadMutex);
+    profiler.threadNames[index] = QByteArray(name);
+}
+
+QVector<QByteArray> FrameProfiler::threadNamesCopy() const
+{
+    std::lock_guard<std::mutex> lock(threadMutex);
+    return threadNames;
+}
+
+void FrameProfiler::record(Phase phase, qint64 startNs, qint64 endNs)
+{
+    const quint64 index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots[index & (capacity - 1)];
+
+    // Seqlock: ungerade Sequenz markiert den Eintrag als unvollstaendig
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs - startNs, std::memory_order_relaxed);
+    slot.phaseAndThread.store(quint32(phase) | (quint32(currentThreadIndex()) << 8), std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+QVector<FrameProfiler::Event> FrameProfiler::events(double lastSeconds) const
+{
+    const quint64 end = head.load(std::memory_order_acquire);
+    const quint64 begin = end > capacity ? end - capacity : 0;
+    const qint64 cutoff = nowNs() - static_cast<qint64>(lastSeconds * 1e9);
+
+    QVector<Event> result;
+    result.reserve(static_cast<int>(end - begin));
+    for (quint64 index = begin; index < end; ++index) {
+        const Slot &slot = slots[index & (capacity - 1)];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2) {
+            continue; // noch im Schreiben oder bereits ueberschrieben
+        }
+        Event event;
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        const quint32 packed = slot.phaseAndThread.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+        event.phase = static_cast<Phase>(packed & 0xff);
+        event.thread = static_cast<int>(packed >> 8);
+        if (event.startNs >= cutoff && event.phase < PhaseCount) {
+            result.append(event);
+        }
+    }
+
+    // Gleicher Start: aeussere (laengere) Phase zuerst, damit die Verschachtelung erhalten bleibt
+    std::sort(result.begin(), result.end(), [](const Event &a, const Event &b) {
+        return a.startNs != b.startNs ? a.startNs < b.startNs : a.durationNs > b.durationNs;
+    });
+    return result;
+}
+
+QVector<FrameProfiler::PhaseStats> FrameProfiler::statistics(double lastSeconds) const
+{
+    const QVector<Event> recorded = events(lastSeconds);
+
+    // Eigenzeit: direkte Kinder auf demselben Thread werden von der Elternphase abgezogen
+    QVector<qint64> selfNs(recorded.size());
+    QVector<QVector<int>> openScopes;
+    for (int i = 0; i < recorded.size(); ++i) {
+        const Event &event = recorded[i];
+        if (event.thread >= openScopes.size()) {
+            openScopes.resize(event.thread + 1);
+        }
+        QVector<int> &stack = openScopes[event.thread];
+        while (!stack.isEmpty()) {
+            const Event &parent = recorded[stack.last()];
+            if (parent.startNs + parent.durationNs > event.startNs) {
+                break;
+            }
+            stack.removeLast();
+        }
+        selfNs[i] = event.durationNs;
+        if (!stack.isEmpty()) {
+            selfNs[stack.last()] -= event.durationNs;
+        }
+        stack.append(i);
+    }
+
+    QVector<double> inclusive[PhaseCount];
+    QVector<double> exclusive[PhaseCount];
+    for (int i = 0; i < recorded.size(); ++i) {
+        inclusive[recorded[i].phase].append(recorded[i].durationNs / 1e6);
+        exclusive[recorded[i].phase].append(qMax<qint64>(0, selfNs[i]) / 1e6);
+    }
+
+    QVector<PhaseStats> result;
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        PhaseStats stats;
+        stats.phase = static_cast<Phase>(phase);
+        stats.count = static_cast<int>(inclusive[phase].size());
+        stats.p50Ms = percentile(inclusive[phase], 0.50);
+        stats.p99Ms = percentile(inclusive[phase], 0.99);
+        stats.selfP50Ms = percentile(exclusive[phase], 0.50);
+        stats.selfP99Ms = percentile(exclusive[phase], 0.99);
+        result.append(stats);
+    }
+    return result;
+}
+
+QByteArray FrameProfiler::chromeTrace(double lastSeconds) const
+{
+    const QVector<Event> recorded = events(lastSeconds);
+    const QVector<QByteArray> names = threadNamesCopy();
+
+    QJsonArray traceEvents;
+    for (int thread = 0; thread < names.size(); ++thread) {
+        QJsonObject args;
+        args["name"] = QString::fromUtf8(names[thread]);
+        QJsonObject metadata;
+        metadata["name"] = "thread_name";
+        metadata["ph"] = "M";
+        metadata["pid"] = 1;
+        metadata["tid"] = thread;
+        metadata["args"] = args;
+        traceEvents.append(metadata);
+    }
+
+    for (const Event &event : recorded) {
+        QJsonObject entry;
+        entry["name"] = phaseName(event.phase);
+        entry["cat"] = "gravity";
+        entry["ph"] = "X";
+        entry["pid"] = 1;
+        entry["tid"] = event.thread;
+        entry["ts"] = event.startNs / 1000.0;   // Mikrosekunden
+        entry["dur"] = event.durationNs / 1000.0;
+        traceEvents.append(entry);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,116 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief FrameProfiler - Zeitmessung einzelner Frame- und Simulationsphasen
+ *
+ * Verantwortlichkeiten:
+ * - Scope-Timer (FrameProfiler::Scope), die im ausgeschalteten Zustand nur ein atomares Flag lesen
+ * - Lock-freier Ringpuffer fuer Messereignisse aus GUI- und Simulations-Thread (Sequenzzaehler je Eintrag)
+ * - Rollierende p50/p99-Statistik je Phase, verschachtelte Phasen werden als Eigenzeit gerechnet
+ * - Export der letzten Sekunden im Chrome-trace_event-Format (chrome://tracing, Perfetto)
+ */
+class FrameProfiler {
+public:
+    enum Phase : quint8 {
+        Frame,           // SphereWidget::updateFrame
+        TransformSync,   // setSurfaceNormals der Einzel-Marker
+        ColorSync,       // Kollisionsfarben (Einzel-Marker oder Instanz-Farbpuffer)
+        InstanceUpload,  // Instanzpuffer des InstancedMarkerRenderer
+        PlaybackDecode,  // Dekodierung eines aufgezeichneten Bildes
+        SimulationStep,  // ein Tick des Simulations-Threads
+        Integration,     // SimulationCore::advance ohne Kraftberechnung
+        Force,           // SimulationCore::computeAccelerations
+        Collisions,      // SimulationCore::handleCollisions
+        SnapshotPublish, // Kopie in den Dreifachpuffer
+        PhaseCount
+    };
+
+    struct Event {
+        Phase phase;
+        int thread;
+        qint64 startNs;
+        qint64 durationNs;
+    };
+
+    struct PhaseStats {
+        Phase phase;
+        int count;
+        double p50Ms;      // inklusive verschachtelter Phasen
+        double p99Ms;
+        double selfP50Ms;  // nur Eigenzeit
+        double selfP99Ms;
+    };
+
+    // Misst vom Konstruktor bis zum Destruktor; ohne aktiven Profiler nur ein relaxed-Load
+    class Scope {
+    public:
+        explicit Scope(Phase phase)
+            : phase(phase),
+              startNs(isEnabled() ? nowNs() : -1)
+        {
+        }
+
+        ~Scope()
+        {
+            if (startNs >= 0) {
+                instance().record(phase, startNs, nowNs());
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Phase phase;
+        qint64 startNs;
+    };
+
+    static FrameProfiler &instance();
+    static bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static const char *phaseName(Phase phase);
+    // Monotone Zeit in Nanosekunden seit Programmstart
+    static qint64 nowNs();
+    // Name des aufrufenden Threads fuer den Trace-Export
+    static void setThreadName(const char *name);
+
+    void record(Phase phase, qint64 startNs, qint64 endNs);
+
+    // Alle vollstaendig geschriebenen Ereignisse der letzten lastSeconds, nach Startzeit sortiert
+    QVector<Event> events(double lastSeconds) const;
+    QVector<PhaseStats> statistics(double lastSeconds) const;
+    QByteArray chromeTrace(double lastSeconds) const;
+
+private:
+    FrameProfiler();
+
+    static constexpr int capacityBits = 16;
+    static constexpr quint64 capacity = quint64(1) << capacityBits;
+
+    struct Slot {
+        std::atomic<quint64> sequence{0};  // 2*i+1 waehrend des Schreibens, 2*i+2 danach
+        std::atomic<qint64> startNs{0};
+        std::atomic<qint64> durationNs{0};
+        std::atomic<quint32> phaseAndThread{0};
+    };
+
+    static int currentThreadIndex();
+    QVector<QByteArray> threadNamesCopy() const;
+
+    static std::atomic<bool> enabledFlag;
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<quint64> head;
+    mutable std::mutex threadMutex;
+    QVector<QByteArray> threadNames;
+};
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,50 @@
+#include "frameprofileroverlay.h"
+#include "frameprofiler.h"
+
+#include <QFontDatabase>
+#include <QTimer>
+
+FrameProfilerOverlay::FrameProfilerOverlay(QWidget *parent)
+    : QLabel(parent),
+      refreshTimer(new QTimer(this))
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setStyleSheet("background-color: rgba(10, 20, 40, 220); color: #d0f0ff; padding: 6px;");
+    setTextFormat(Qt::PlainText);
+    setVisible(false);
+
+    refreshTimer->setInterval(250);
+    connect(refreshTimer, &QTimer::timeout, this, &FrameProfilerOverlay::refresh);
+}
+
+void FrameProfilerOverlay::setProfilingEnabled(bool enabled)
+{
+    FrameProfiler::setEnabled(enabled);
+    setVisible(enabled);
+    if (enabled) {
+        refresh();
+        refreshTimer->start();
+    } else {
+        refreshTimer->stop();
+    }
+}
+
+void FrameProfilerOverlay::refresh()
+{
+    const auto stats = FrameProfiler::instance().statistics(windowSeconds);
+
+    QString text = QString("%1 %2 %3 %4\n").arg(QString("Phase"), -16).arg(QString("n"), 6).arg(QString("p50 ms"), 9).arg(QString("p99 ms"), 9);
+    for (const FrameProfiler::PhaseStats &phase : stats) {
+        if (phase.count == 0) {
+            continue;
+        }
+        const bool topLevel = phase.phase == FrameProfiler::Frame || phase.phase == FrameProfiler::SimulationStep;
+        text += QString("%1 %2 %3 %4\n")
+                    .arg(QString::fromLatin1(FrameProfiler::phaseName(phase.phase)), -16)
+                    .arg(phase.count, 6)
+                    .arg(topLevel ? phase.p50Ms : phase.selfP50Ms, 9, 'f', 3)
+                    .arg(topLevel ? phase.p99Ms : phase.selfP99Ms, 9, 'f', 3);
+    }
+    text += QString("letzte %1 s; Frame und SimulationStep inklusive, sonst Eigenzeit").arg(windowSeconds);
+    setText(text);
+}
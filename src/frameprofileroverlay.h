@@ -0,0 +1,33 @@
+#ifndef FRAMEPROFILEROVERLAY_H
+#define FRAMEPROFILEROVERLAY_H
+
+#include <QLabel>
+
+class QTimer;
+
+/**
+ * @brief FrameProfilerOverlay - Anzeige der rollierenden Phasenzeiten unter dem 3D-Viewport
+ *
+ * Verantwortlichkeiten:
+ * - Schaltet den FrameProfiler beim Ein-/Ausblenden mit ein bzw. aus
+ * - Aktualisiert viermal pro Sekunde eine Tabelle mit p50/p99 je Phase ueber die letzten Sekunden
+ * - Oberste Phasen (Frame, Simulationsschritt) inklusive, alle anderen als Eigenzeit
+ */
+class FrameProfilerOverlay : public QLabel {
+    Q_OBJECT
+
+public:
+    explicit FrameProfilerOverlay(QWidget *parent = nullptr);
+
+    void setProfilingEnabled(bool enabled);
+
+private slots:
+    void refresh();
+
+private:
+    static constexpr double windowSeconds = 3.0;
+
+    QTimer *refreshTimer;
+};
+
+#endif // FRAMEPROFILEROVERLAY_H
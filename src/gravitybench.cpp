@@ -0,0 +1,319 @@
+#include <QCoreApplication>
+#include <QColor>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QVector3D>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "capmesh.h"
+#include "checkpointstore.h"
+#include "forcekernels.h"
+#include "markerstateview.h"
+#include "simulationcore.h"
+#include "simulationsnapshot.h"
+#include "workerpool.h"
+
+namespace {
+constexpr quint32 defaultSeed = 0x6a09e667u;
+
+struct Result {
+    QString name;
+    int markers;
+    int iterations;
+    double minNs;
+    double medianNs;
+    double meanNs;
+};
+
+struct Harness {
+    double minSeconds = 0.25;
+    int maxIterations = 1000;
+    QString filter;
+    std::vector<Result> results;
+
+    // Misst body wiederholt nach einem Aufwaermlauf; setup laeuft vor jeder Messung ausserhalb der Zeitnahme
+    void run(const QString &name, int markers, const std::function<void()> &body,
+             const std::function<void()> &setup = {})
+    {
+        if (!filter.isEmpty() && !name.contains(filter)) {
+            return;
+        }
+        if (setup) {
+            setup();
+        }
+        body();
+
+        std::vector<double> samples;
+        QElapsedTimer total;
+        total.start();
+        QElapsedTimer timer;
+        while (static_cast<int>(samples.size()) < maxIterations
+               && (samples.empty() || total.nsecsElapsed() < qint64(minSeconds * 1e9))) {
+            if (setup) {
+                setup();
+            }
+            timer.start();
+            body();
+            samples.push_back(double(timer.nsecsElapsed()));
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double sample : samples) {
+            sum += sample;
+        }
+        results.push_back({name, markers, static_cast<int>(samples.size()), samples.front(),
+                           samples[samples.size() / 2], sum / samples.size()});
+
+        QTextStream(stderr) << QString("%1 N=%2: %3 us (median, %4 Iterationen)\n")
+                                   .arg(name, -22).arg(markers, 6)
+                                   .arg(samples[samples.size() / 2] / 1000.0, 10, 'f', 1)
+                                   .arg(static_cast<int>(samples.size()));
+    }
+};
+
+// Gleichverteilte Marker aus festem Seed; Radius so gewaehlt, dass die bedeckte Flaeche etwa gleich bleibt
+void generateMarkers(SimulationCore &core, int count, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    const float radius = qMin(0.1f, 0.6f / qSqrt(float(count)));
+
+    core.clear();
+    core.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const float z = float(rng.generateDouble() * 2.0 - 1.0);
+        const float t = float(rng.generateDouble() * 2.0 * M_PI);
+        const float r = qSqrt(qMax(0.0f, 1.0f - z * z));
+        const Vec3 position = Vec3(r * qCos(t), z, r * qSin(t)).normalized();
+
+        Vec3 tangent = Vec3::cross(position, Vec3(0.0f, 1.0f, 0.0f));
+        if (tangent.lengthSquared() < 1e-6f) {
+            tangent = Vec3(1.0f, 0.0f, 0.0f);
+        }
+        const float speed = float(rng.generateDouble() * 0.5);
+        core.addMarker(position, tangent.normalized() * speed, radius, 1.0f, 0x78beff);
+    }
+}
+
+// Entspricht SphereWidget::getMarkersInfo(), das ohne Qt3D-Fenster nicht aufrufbar ist
+struct MarkerInfo {
+    int index;
+    float radius;
+    float density;
+    QColor color;
+    QVector3D position;
+    QVector3D velocity;
+};
+
+QVector<MarkerInfo> markersInfo(const SimulationSnapshot &snapshot)
+{
+    QVector<MarkerInfo> result;
+    for (int i = 0; i < snapshot.size(); ++i) {
+        const Vec3 position = snapshot.position(i);
+        const Vec3 velocity = snapshot.velocity(i);
+        result.append({
+            i,
+            snapshot.radii[i],
+            snapshot.densities[i],
+            QColor::fromRgb(snapshot.colors[i]),
+            QVector3D(position.x, position.y, position.z),
+            QVector3D(velocity.x, velocity.y, velocity.z)
+        });
+    }
+    return result;
+}
+
+QVector<int> parseSizes(const QString &text)
+{
+    QVector<int> sizes;
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int value = part.trimmed().toInt(&ok);
+        if (ok && value > 0) {
+            sizes.append(value);
+        }
+    }
+    return sizes;
+}
+}
+
+// gravity_bench: Mikrobenchmarks der Physik- und Geometrie-Hotpaths, Ergebnisse als JSON
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gravity_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mikrobenchmarks fuer Kraftberechnung, Kollisionen, Marker-Erzeugung, Kappen-Geometrie, Checkpoints und Szenario-Export.");
+    parser.addHelpOption();
+    const QCommandLineOption outputOption({"o", "output"}, "JSON-Ergebnis in <file> statt auf stdout.", "file");
+    const QCommandLineOption sizesOption("sizes", "Markeranzahlen, kommagetrennt (Standard 10,100,1000,10000,100000).",
+                                         "list", "10,100,1000,10000,100000");
+    const QCommandLineOption filterOption("filter", "Nur Benchmarks, deren Name <text> enthaelt.", "text");
+    const QCommandLineOption seedOption("seed", "Seed der erzeugten Eingaben.", "seed", QString::number(defaultSeed));
+    const QCommandLineOption minTimeOption("min-time", "Mindestmessdauer je Benchmark in Sekunden (Standard 0.25).", "seconds", "0.25");
+    const QCommandLineOption threadsOption("threads", "Threads der Kraftberechnung, 0 = alle Kerne (Standard 0).", "count", "0");
+    const QCommandLineOption maxDirectOption("max-direct", "Groesste Markeranzahl fuer die direkte O(N^2)-Kraftberechnung.",
+                                             "count", "100000");
+    parser.addOptions({outputOption, sizesOption, filterOption, seedOption, minTimeOption, threadsOption, maxDirectOption});
+    parser.process(app);
+
+    const QVector<int> sizes = parseSizes(parser.value(sizesOption));
+    const quint32 seed = parser.value(seedOption).toUInt();
+    const int threads = parser.value(threadsOption).toInt();
+    const int maxDirect = parser.value(maxDirectOption).toInt();
+
+    Harness harness;
+    harness.filter = parser.value(filterOption);
+    harness.minSeconds = qMax(0.0, parser.value(minTimeOption).toDouble());
+
+    // Kappen-Geometrie haengt nicht von N ab
+    harness.run("capmesh.build", 1, []() {
+        const CapMesh::Data data = CapMesh::build(SimulationCore::sphereRadius, 0.05f);
+        Q_UNUSED(data);
+    });
+    harness.run("capmesh.buildUnit", 1, []() {
+        const CapMesh::Data data = CapMesh::buildUnit();
+        Q_UNUSED(data);
+    });
+
+    for (int n : sizes) {
+        SimulationCore core;
+        core.setThreadCount(threads);
+        generateMarkers(core, n, seed);
+        const SimulationCore initial = core;
+
+        if (n <= maxDirect) {
+            core.setForceSolver(SimulationCore::ForceSolver::BruteForce);
+            harness.run("force.direct", n, [&core]() { core.computeAccelerations(); });
+        }
+        core.setForceSolver(SimulationCore::ForceSolver::BarnesHut);
+        harness.run("force.barnesHut", n, [&core]() { core.computeAccelerations(); });
+
+        // Jede Messung startet vom selben Zustand, sonst trennen sich die Marker nach dem ersten Lauf
+        harness.run("collisions", n, [&core]() { core.handleCollisions(); },
+                    [&core, &initial]() { core = initial; });
+        // Nach einem grossen Schritt (Zeitskalierung ~10x) mit kontinuierlicher Kollisionserkennung
+        harness.run("collisions.swept", n, [&core]() { core.handleCollisions(); },
+                    [&core, &initial]() { core = initial; core.advance(0.16f); });
+        // Verschmelzen inklusive Swap-Remove aller aufgenommenen Marker
+        harness.run("collisions.merge", n, [&core]() { core.handleCollisions(); },
+                    [&core, &initial]() {
+                        core = initial;
+                        core.setCollisionMode(SimulationCore::CollisionMode::Merge);
+                    });
+
+        // Schrittkern (Euler-Drehung ohne Kraftberechnung) je Rechengenauigkeit; Genauigkeit siehe IntegratorReport
+        for (auto precision : {SimulationCore::Precision::Float, SimulationCore::Precision::Mixed,
+                               SimulationCore::Precision::Double}) {
+            core = initial;
+            core.setPrecision(precision);
+            harness.run(QString("integrate.%1").arg(SimulationCore::precisionName(precision)), n,
+                        [&core]() { core.integrate(0.01f); });
+        }
+        core = initial;
+
+        // Checkpoint nach einem Schritt (Beschleunigungen belegt): Spalten umsortieren und komprimieren, sowie
+        // Zuruecksetzen genau auf diesen Checkpoint (dekomprimieren, ohne wiederholte Schritte)
+        SimulationCore stepped = initial;
+        stepped.setForceSolver(SimulationCore::ForceSolver::BarnesHut);
+        stepped.step(0.01f);
+        CheckpointStore checkpoints;
+        harness.run("checkpoint.capture", n, [&checkpoints, &stepped]() {
+            checkpoints.recordStep(stepped, 0.0, 0, 0.01f);
+        }, [&checkpoints]() { checkpoints.clear(); });
+        SimulationCore restored;
+        double restoredTime = 0.0;
+        harness.run("checkpoint.restore", n, [&checkpoints, &restored, &restoredTime]() {
+            checkpoints.seek(0, restored, restoredTime);
+        });
+
+        QJsonObject scenario;
+        harness.run("scenario.export", n, [&core, &scenario]() { scenario = core.exportScenario(); });
+        harness.run("scenario.apply", n, [&core, &scenario]() { core.applyScenario(scenario); });
+        harness.run("scenario.roundTrip", n, [&core]() {
+            const QByteArray json = QJsonDocument(core.exportScenario()).toJson(QJsonDocument::Compact);
+            core.applyScenario(QJsonDocument::fromJson(json).object());
+        });
+
+        // Erzeugung der Startverteilung; setup leert den Kern, damit jede Messung n Marker anlegt
+        SimulationCore generated;
+        generated.setThreadCount(threads);
+        MarkerGenerator::Settings settings;
+        settings.count = n;
+        settings.size = qMin(0.1f, 0.6f / qSqrt(float(n)));
+        settings.seed = seed;
+        settings.velocityDispersion = 0.1f;
+        for (auto distribution : {MarkerGenerator::Distribution::Uniform, MarkerGenerator::Distribution::Clustered}) {
+            settings.distribution = distribution;
+            harness.run(QString("generate.%1").arg(MarkerGenerator::distributionName(distribution)), n,
+                        [&generated, &settings]() { generated.generateMarkers(settings); },
+                        [&generated]() { generated.clear(); });
+        }
+
+        SimulationSnapshot snapshot;
+        harness.run("snapshot.capture", n, [&]() { snapshot.capture(core, 0.0, 0); });
+        harness.run("markersInfo", n, [&snapshot]() {
+            const QVector<MarkerInfo> info = markersInfo(snapshot);
+            Q_UNUSED(info);
+        });
+        // Gleiche Abfrage ueber den kopierfreien View (Panels lesen nur die betroffenen Indizes)
+        float speedSum = 0.0f;
+        harness.run("markerState", n, [&snapshot, &speedSum]() {
+            const MarkerStateView markers(snapshot);
+            for (int i = 0; i < markers.size(); ++i) {
+                speedSum += markers.speed(i) + markers.radius(i) + markers.density(i);
+            }
+        });
+        Q_UNUSED(speedSum);
+    }
+
+    QJsonArray results;
+    for (const Result &result : harness.results) {
+        QJsonObject entry;
+        entry["name"] = result.name;
+        entry["markers"] = result.markers;
+        entry["iterations"] = result.iterations;
+        entry["minNs"] = result.minNs;
+        entry["medianNs"] = result.medianNs;
+        entry["meanNs"] = result.meanNs;
+        entry["medianNsPerMarker"] = result.medianNs / result.markers;
+        results.append(entry);
+    }
+
+    QJsonObject host;
+    host["cpu"] = QSysInfo::currentCpuArchitecture();
+    host["os"] = QSysInfo::prettyProductName();
+    host["threads"] = WorkerPool::idealThreadCount();
+    host["instructionSet"] = ForceKernels::instructionSetName(ForceKernels::detectInstructionSet());
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["seed"] = qint64(seed);
+    root["forceThreads"] = threads;
+    root["host"] = host;
+    root["results"] = results;
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "Datei konnte nicht geschrieben werden: " << file.errorString() << "\n";
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+
+#include "scenariofile.h"
+#include "simulationcore.h"
+#include "trajectoryrecorder.h"
+
+namespace {
+int collidingCount(const SimulationCore &core)
+{
+    const QVector<bool> &flags = core.collidingFlags();
+    return static_cast<int>(std::count(flags.cbegin(), flags.cend(), true));
+}
+}
+
+// gravity-cli: rechnet ein Szenario ohne GUI und OpenGL mit festem Zeitschritt und schreibt das Ergebnis
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gravity-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless-Simulation eines Gravity-Szenarios mit festem Zeitschritt.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Startszenario (.grv oder .grvb)");
+
+    const QCommandLineOption outputOption({"o", "output"}, "Endzustand in <file> schreiben (.grv oder .grvb).", "file");
+    const QCommandLineOption stepsOption({"n", "steps"}, "Anzahl der Schritte.", "count");
+    const QCommandLineOption secondsOption({"s", "seconds"}, "Simulationsdauer in Sekunden (statt --steps).", "seconds");
+    const QCommandLineOption dtOption("dt", "Fester Zeitschritt in Sekunden (Standard 1/60).", "seconds", QString::number(1.0 / 60.0));
+    const QCommandLineOption integratorOption("integrator", "euler, leapfrog, yoshida4, rk4 oder block (Standard leapfrog).", "name", "leapfrog");
+    const QCommandLineOption blockLevelsOption("block-levels", "Block-Integrator: hoechstens 2^k Teilschritte je Schritt (Standard 8).", "k");
+    const QCommandLineOption blockAccuracyOption("block-accuracy", "Block-Integrator: Genauigkeitsfaktor eta (Standard 0.1).", "eta");
+    const QCommandLineOption precisionOption("precision", "Rechengenauigkeit der Integration: float, mixed oder double (Standard float).",
+                                             "type", "float");
+    const QCommandLineOption solverOption("solver", "direct oder barnes-hut (Standard direct).", "name", "direct");
+    const QCommandLineOption thetaOption("theta", "Oeffnungswinkel fuer Barnes-Hut.", "angle");
+    const QCommandLineOption threadsOption("threads", "Anzahl Threads, 0 = alle Kerne (Standard 0).", "count", "0");
+    const QCommandLineOption collisionsOption("collisions", "elastic oder merge (Standard elastic).", "mode", "elastic");
+    const QCommandLineOption discreteOption("discrete-collisions", "Nur Ueberlappungen am Schrittende pruefen (ohne kontinuierliche Erkennung).");
+    const QCommandLineOption energyOption("energy", "Gesamtenergie am Anfang und Ende berechnen (O(N^2)).");
+    const QCommandLineOption recordOption("record", "Trajektorie in <file> (.grvt) aufzeichnen.", "file");
+    const QCommandLineOption recordIntervalOption("record-interval", "Jeden k-ten Schritt aufzeichnen (Standard 1).", "k", "1");
+    const QCommandLineOption jsonOption("json", "Zusammenfassung als JSON auf stdout ausgeben.");
+    parser.addOptions({outputOption, stepsOption, secondsOption, dtOption, integratorOption, blockLevelsOption,
+                       blockAccuracyOption, precisionOption, solverOption, thetaOption, threadsOption, collisionsOption, discreteOption, energyOption, recordOption,
+                       recordIntervalOption, jsonOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1) {
+        err << "Aufruf: gravity-cli <input> (--steps N | --seconds T) [--dt DT] [-o output]\n";
+        return 2;
+    }
+
+    bool ok = false;
+    const double dt = parser.value(dtOption).toDouble(&ok);
+    if (!ok || dt <= 0.0) {
+        err << "Ungueltiger Zeitschritt: " << parser.value(dtOption) << "\n";
+        return 2;
+    }
+
+    qint64 steps = 0;
+    if (parser.isSet(stepsOption) == parser.isSet(secondsOption)) {
+        err << "Genau eine der Optionen --steps oder --seconds angeben\n";
+        return 2;
+    }
+    if (parser.isSet(stepsOption)) {
+        steps = parser.value(stepsOption).toLongLong(&ok);
+    } else {
+        const double seconds = parser.value(secondsOption).toDouble(&ok);
+        steps = ok ? qRound64(seconds / dt) : 0;
+    }
+    if (!ok || steps < 0) {
+        err << "Ungueltige Schrittanzahl\n";
+        return 2;
+    }
+
+    SimulationCore core;
+
+    SimulationCore::Integrator integrator;
+    if (!SimulationCore::parseIntegrator(parser.value(integratorOption), integrator)) {
+        err << "Unbekannter Integrator: " << parser.value(integratorOption) << "\n";
+        return 2;
+    }
+    core.setIntegrator(integrator);
+    if (parser.isSet(blockLevelsOption)) {
+        core.setBlockMaxLevel(parser.value(blockLevelsOption).toInt());
+    }
+    if (parser.isSet(blockAccuracyOption)) {
+        core.setBlockAccuracy(parser.value(blockAccuracyOption).toFloat());
+    }
+
+    SimulationCore::Precision precision;
+    if (!SimulationCore::parsePrecision(parser.value(precisionOption), precision)) {
+        err << "Unbekannte Genauigkeit: " << parser.value(precisionOption) << "\n";
+        return 2;
+    }
+    core.setPrecision(precision);
+
+    SimulationCore::ForceSolver solver;
+    if (!SimulationCore::parseForceSolver(parser.value(solverOption), solver)) {
+        err << "Unbekannter Kraftloeser: " << parser.value(solverOption) << "\n";
+        return 2;
+    }
+    core.setForceSolver(solver);
+    if (parser.isSet(thetaOption)) {
+        core.setOpeningAngle(parser.value(thetaOption).toFloat());
+    }
+    core.setThreadCount(parser.value(threadsOption).toInt());
+    core.setContinuousCollisions(!parser.isSet(discreteOption));
+
+    SimulationCore::CollisionMode collisionMode;
+    if (!SimulationCore::parseCollisionMode(parser.value(collisionsOption), collisionMode)) {
+        err << "Unbekannter Kollisionsmodus: " << parser.value(collisionsOption) << "\n";
+        return 2;
+    }
+    core.setCollisionMode(collisionMode);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    bool animationEnabled = true;
+    if (!ScenarioFile::load(arguments[0], core, &animationEnabled, &error)) {
+        err << "Laden fehlgeschlagen: " << error << "\n";
+        return 1;
+    }
+    const qint64 loadMs = timer.restart();
+    const int initialMarkers = core.size();
+
+    TrajectoryRecorder recorder;
+    if (parser.isSet(recordOption)) {
+        TrajectoryRecorder::Options options;
+        options.stepInterval = parser.value(recordIntervalOption).toInt();
+        // Ohne Bildrate gibt es keinen Grund, Bilder zu verwerfen
+        options.blockWhenFull = true;
+        if (!recorder.start(parser.value(recordOption), options, &error)) {
+            err << "Aufzeichnung fehlgeschlagen: " << error << "\n";
+            return 1;
+        }
+    }
+
+    const double initialEnergy = parser.isSet(energyOption) ? core.totalEnergy() : 0.0;
+
+    // Bewegung und Kollisionen getrennt messen; zusammen entspricht das SimulationCore::step()
+    const float stepSeconds = static_cast<float>(dt);
+    qint64 advanceNs = 0;
+    qint64 collisionNs = 0;
+    qint64 contactSteps = 0;
+    qint64 sweptContacts = 0;
+    qint64 merges = 0;
+    QElapsedTimer stepTimer;
+    for (qint64 s = 0; s < steps; ++s) {
+        stepTimer.start();
+        core.advance(stepSeconds);
+        advanceNs += stepTimer.nsecsElapsed();
+
+        stepTimer.start();
+        core.handleCollisions();
+        collisionNs += stepTimer.nsecsElapsed();
+        sweptContacts += core.sweptContactCount();
+        merges += core.mergeCount();
+
+        if (collidingCount(core) > 0) {
+            ++contactSteps;
+        }
+        recorder.record(core, (s + 1) * dt, quint64(s + 1));
+    }
+    const qint64 simulateMs = timer.restart();
+    recorder.stop();
+    // Die Zusammenfassung wird trotzdem ausgegeben, der Exit-Code meldet die unvollstaendige Aufzeichnung
+    const int exitCode = recorder.hasError() ? 1 : 0;
+    if (recorder.hasError()) {
+        err << "Aufzeichnung fehlgeschlagen: " << recorder.errorString() << " (" << recorder.framesWritten()
+            << " Bilder geschrieben, " << recorder.framesDropped() << " verworfen)\n";
+        err.flush();
+    }
+
+    const double finalEnergy = parser.isSet(energyOption) ? core.totalEnergy() : 0.0;
+
+    qint64 saveMs = 0;
+    if (parser.isSet(outputOption)) {
+        timer.restart();
+        if (!ScenarioFile::save(parser.value(outputOption), core, animationEnabled, &error)) {
+            err << "Speichern fehlgeschlagen: " << error << "\n";
+            return 1;
+        }
+        saveMs = timer.elapsed();
+    }
+
+    const double msPerStep = steps > 0 ? (advanceNs + collisionNs) / 1e6 / steps : 0.0;
+    // In vollen Kraftauswertungen; beim Block-Integrator kleiner als Schritte mal Stufen
+    const double forceEvaluations = core.size() > 0 ? double(core.accelerationEvaluations()) / core.size() : 0.0;
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject summary;
+        summary["input"] = arguments[0];
+        summary["markers"] = core.size();
+        summary["initialMarkers"] = initialMarkers;
+        summary["steps"] = steps;
+        summary["dt"] = dt;
+        summary["simulatedSeconds"] = steps * dt;
+        summary["integrator"] = SimulationCore::integratorName(integrator);
+        summary["precision"] = SimulationCore::precisionName(precision);
+        summary["solver"] = parser.value(solverOption);
+        summary["threads"] = core.effectiveThreadCount();
+        summary["loadMs"] = loadMs;
+        summary["simulateMs"] = simulateMs;
+        summary["advanceMs"] = advanceNs / 1e6;
+        summary["collisionMs"] = collisionNs / 1e6;
+        summary["saveMs"] = saveMs;
+        summary["msPerStep"] = msPerStep;
+        summary["stepsWithContacts"] = contactSteps;
+        summary["sweptContacts"] = sweptContacts;
+        summary["collisionMode"] = SimulationCore::collisionModeName(collisionMode);
+        summary["merges"] = merges;
+        summary["forceEvaluations"] = forceEvaluations;
+        if (parser.isSet(energyOption)) {
+            summary["initialEnergy"] = initialEnergy;
+            summary["finalEnergy"] = finalEnergy;
+        }
+        if (parser.isSet(recordOption)) {
+            summary["recordedFrames"] = qint64(recorder.framesWritten());
+            summary["recordedBytes"] = recorder.bytesWritten();
+            summary["recordedDropped"] = qint64(recorder.framesDropped());
+            if (recorder.hasError()) {
+                summary["recordingError"] = recorder.errorString();
+            }
+        }
+        out << QJsonDocument(summary).toJson(QJsonDocument::Indented);
+        return exitCode;
+    }
+
+    out << "Szenario:       " << arguments[0] << " (" << core.size() << " Marker)\n";
+    out << "Schritte:       " << steps << " x " << dt << " s = " << steps * dt << " s Simulationszeit\n";
+    out << "Integrator:     " << SimulationCore::integratorName(integrator)
+        << " (" << SimulationCore::precisionName(precision) << ")"
+        << ", Kraftloeser " << parser.value(solverOption) << ", " << core.effectiveThreadCount() << " Threads\n";
+    out << "Laden:          " << loadMs << " ms\n";
+    out << "Simulation:     " << simulateMs << " ms (" << QString::number(msPerStep, 'f', 3) << " ms/Schritt)\n";
+    out << "  Bewegung:     " << QString::number(advanceNs / 1e6, 'f', 1) << " ms\n";
+    out << "  Kraftausw.:   " << QString::number(forceEvaluations, 'f', 1) << "\n";
+    out << "  Kollisionen:  " << QString::number(collisionNs / 1e6, 'f', 1) << " ms, "
+        << contactSteps << " Schritte mit Kontakten, " << sweptContacts << " Kontakte waehrend des Schritts\n";
+    if (collisionMode == SimulationCore::CollisionMode::Merge) {
+        out << "  Verschmolzen: " << merges << " Paare, " << initialMarkers << " -> " << core.size() << " Marker\n";
+    }
+    if (parser.isSet(energyOption)) {
+        const double drift = initialEnergy != 0.0 ? (finalEnergy - initialEnergy) / qAbs(initialEnergy) : 0.0;
+        out << "Energie:        " << initialEnergy << " -> " << finalEnergy
+            << " (relativ " << QString::number(drift, 'e', 3) << ")\n";
+    }
+    if (parser.isSet(recordOption)) {
+        out << "Aufzeichnung:   " << recorder.framesWritten() << " Bilder, " << recorder.bytesWritten() << " Bytes";
+        if (recorder.hasError()) {
+            out << ", unvollstaendig: " << recorder.errorString();
+        }
+        out << "\n";
+    }
+    if (parser.isSet(outputOption)) {
+        out << "Speichern:      " << parser.value(outputOption) << " (" << saveMs << " ms)\n";
+    }
+    return exitCode;
+}
@@ -0,0 +1,40 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include "scenariofile.h"
+
+// gravity-convert: wandelt Szenarien zwischen .grv (JSON) und .grvb (binaer) um; Format nach Dateiendung
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gravity-convert");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Konvertiert Gravity-Szenarien zwischen .grv (JSON) und .grvb (binaer).");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Quelldatei (.grv oder .grvb)");
+    parser.addPositionalArgument("output", "Zieldatei (.grv oder .grvb)");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 2) {
+        err << "Aufruf: gravity-convert <input> <output>\n";
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    if (!ScenarioFile::convert(arguments[0], arguments[1], &error)) {
+        err << "Konvertierung fehlgeschlagen: " << error << "\n";
+        return 1;
+    }
+
+    out << arguments[0] << " -> " << arguments[1] << " (" << timer.elapsed() << " ms)\n";
+    return 0;
+}
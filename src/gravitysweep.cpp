@@ -0,0 +1,102 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include "ensemblerunner.h"
+#include "scenariofile.h"
+#include "workerpool.h"
+
+// gravity-sweep: rechnet alle Varianten einer Sweep-Beschreibung parallel und schreibt die Kennzahlen als CSV
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gravity-sweep");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Parameterstudie: Varianten eines Gravity-Szenarios parallel rechnen, "
+                                     "Kennzahlen je Lauf als CSV.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("sweep", "Sweep-Beschreibung (JSON)");
+
+    const QCommandLineOption outputOption({"o", "output"}, "CSV in <file> schreiben (Standard stdout).", "file");
+    const QCommandLineOption threadsOption("threads", "Gleichzeitige Laeufe, 0 = alle Kerne (Standard 0).", "count", "0");
+    const QCommandLineOption quietOption({"q", "quiet"}, "Keinen Fortschritt auf stderr ausgeben.");
+    parser.addOptions({outputOption, threadsOption, quietOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1) {
+        err << "Aufruf: gravity-sweep <sweep.json> [-o results.csv] [--threads N]\n";
+        return 2;
+    }
+
+    bool ok = false;
+    const int threads = parser.value(threadsOption).toInt(&ok);
+    if (!ok || threads < 0) {
+        err << "Ungueltige Thread-Anzahl: " << parser.value(threadsOption) << "\n";
+        return 2;
+    }
+
+    QString error;
+    QJsonObject description;
+    if (!ScenarioFile::readJson(arguments[0], description, &error)) {
+        err << "Laden fehlgeschlagen: " << error << "\n";
+        return 1;
+    }
+    EnsembleRunner::Sweep sweep;
+    if (!EnsembleRunner::parseSweep(description, QFileInfo(arguments[0]).absolutePath(), sweep, &error)) {
+        err << "Ungueltige Sweep-Beschreibung: " << error << "\n";
+        return 2;
+    }
+
+    const int variants = static_cast<int>(sweep.variants().size());
+    const int workers = qMin(threads > 0 ? threads : WorkerPool::idealThreadCount(), qMax(1, variants));
+    const bool verbose = !parser.isSet(quietOption);
+    if (verbose) {
+        err << variants << " Varianten, " << sweep.steps << " Schritte x " << sweep.dt << " s, "
+            << workers << " Threads\n";
+        err.flush();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<EnsembleRunner::Result> results = EnsembleRunner::run(sweep, threads,
+        [&err, verbose](int finished, int total, const EnsembleRunner::Result &result) {
+            if (!verbose) {
+                return;
+            }
+            err << "[" << finished << "/" << total << "] Dichte x" << result.variant.densityScale
+                << ", Geschw. x" << result.variant.speedScale << ", G " << result.variant.gravityConstant
+                << ", seed " << result.variant.seed << ": " << result.collisions << " Stoesse, "
+                << result.clusters << " Cluster, |dE/E| " << QString::number(result.finalEnergyDrift, 'e', 2)
+                << " (" << QString::number(result.wallMilliseconds, 'f', 0) << " ms)\n";
+            err.flush();
+        });
+    const qint64 elapsedMs = timer.elapsed();
+
+    const QString csv = EnsembleRunner::toCsv(results, sweep.dt);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << "Speichern fehlgeschlagen: " << file.errorString() << "\n";
+            return 1;
+        }
+        file.write(csv.toUtf8());
+    } else {
+        out << csv;
+    }
+
+    if (verbose) {
+        double runMs = 0.0;
+        for (const EnsembleRunner::Result &result : results) {
+            runMs += result.wallMilliseconds;
+        }
+        err << "Fertig: " << elapsedMs << " ms Wall-Clock, " << qRound64(runMs) << " ms Rechenzeit aller Laeufe\n";
+    }
+    return 0;
+}
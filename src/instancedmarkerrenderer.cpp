@@ -0,0 +1,330 @@
+#include "instancedmarkerrenderer.h"
+#include "capmesh.h"
+
+
+#include <Qt3DCore/QAttribute>
+#include <Qt3DCore/QBoundingVolume>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DCore/QGeometry>
+#include <Qt3DRender/QCullFace>
+#include <Qt3DRender/QDepthTest>
+#include <Qt3DRender/QEffect>
+#include <Qt3DRender/QFilterKey>
+#include <Qt3DRender/QGeometryRenderer>
+#include <Qt3DRender/QGraphicsApiFilter>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QParameter>
+#include <Qt3DRender/QRenderPass>
+#include <Qt3DRender/QShaderProgram>
+#include <Qt3DRender/QTechnique>
+#include <QUrl>
+#include <QtMath>
+
+namespace {
+const int floatsPerInstance = 5; // Quaternion (x, y, z, w), Radius
+const int bytesPerColor = 4;     // RGBA8, im Shader normiert
+// Ab so vielen getrennten Farbbereichen lohnt ein einzelner Upload des ganzen Puffers mehr
+const int maxColorRanges = 64;
+
+Qt3DCore::QGeometry *createUnitCapGeometry(int &indexCount)
+{
+    auto *geometry = new Qt3DCore::QGeometry();
+    const CapMesh::Data mesh = CapMesh::buildUnit();
+    indexCount = mesh.indexCount;
+
+    auto *vertexBuffer = new Qt3DCore::QBuffer(geometry);
+    vertexBuffer->setData(mesh.vertices);
+
+    auto *indexBuffer = new Qt3DCore::QBuffer(geometry);
+    indexBuffer->setData(mesh.indices);
+
+    auto *capAttribute = new Qt3DCore::QAttribute();
+    capAttribute->setName("capParameter");
+    capAttribute->setVertexBaseType(Qt3DCore::QAttribute::Float);
+    capAttribute->setVertexSize(4);
+    capAttribute->setAttributeType(Qt3DCore::QAttribute::VertexAttribute);
+    capAttribute->setBuffer(vertexBuffer);
+    capAttribute->setByteStride(mesh.floatsPerVertex * sizeof(float));
+    capAttribute->setByteOffset(0);
+    capAttribute->setCount(mesh.vertexCount);
+
+    auto *indexAttribute = new Qt3DCore::QAttribute();
+    indexAttribute->setAttributeType(Qt3DCore::QAttribute::IndexAttribute);
+    indexAttribute->setVertexBaseType(Qt3DCore::QAttribute::UnsignedInt);
+    indexAttribute->setBuffer(indexBuffer);
+    indexAttribute->setCount(mesh.indexCount);
+
+    geometry->addAttribute(capAttribute);
+    geometry->addAttribute(indexAttribute);
+    return geometry;
+}
+
+Qt3DCore::QAttribute *createInstanceAttribute(const char *name, Qt3DCore::QBuffer *buffer,
+                                              Qt3DCore::QAttribute::VertexBaseType type, int size,
+                                              int byteStride, int byteOffset)
+{
+    auto *attribute = new Qt3DCore::QAttribute();
+    attribute->setName(name);
+    attribute->setVertexBaseType(type);
+    attribute->setVertexSize(size);
+    attribute->setAttributeType(Qt3DCore::QAttribute::VertexAttribute);
+    attribute->setBuffer(buffer);
+    attribute->setByteStride(byteStride);
+    attribute->setByteOffset(byteOffset);
+    attribute->setDivisor(1);
+    attribute->setCount(0);
+    return attribute;
+}
+
+Qt3DRender::QMaterial *createInstancedMaterial()
+{
+    auto *shader = new Qt3DRender::QShaderProgram();
+    shader->setVertexShaderCode(Qt3DRender::QShaderProgram::loadSource(QUrl("qrc:/shaders/instancedmarker.vert")));
+    shader->setFragmentShaderCode(Qt3DRender::QShaderProgram::loadSource(QUrl("qrc:/shaders/instancedmarker.frag")));
+
+    auto *renderPass = new Qt3DRender::QRenderPass();
+    renderPass->setShaderProgram(shader);
+
+    auto *cullFace = new Qt3DRender::QCullFace(renderPass);
+    cullFace->setMode(Qt3DRender::QCullFace::NoCulling);
+    renderPass->addRenderState(cullFace);
+
+    auto *depthTest = new Qt3DRender::QDepthTest(renderPass);
+    depthTest->setDepthFunction(Qt3DRender::QDepthTest::Less);
+    renderPass->addRenderState(depthTest);
+
+    // Passend zum Filter des QForwardRenderer aus Qt3DWindow
+    auto *filterKey = new Qt3DRender::QFilterKey();
+    filterKey->setName("renderingStyle");
+    filterKey->setValue("forward");
+
+    auto *technique = new Qt3DRender::QTechnique();
+    technique->graphicsApiFilter()->setApi(Qt3DRender::QGraphicsApiFilter::OpenGL);
+    technique->graphicsApiFilter()->setProfile(Qt3DRender::QGraphicsApiFilter::CoreProfile);
+    technique->graphicsApiFilter()->setMajorVersion(3);
+    technique->graphicsApiFilter()->setMinorVersion(2);
+    technique->addFilterKey(filterKey);
+    technique->addRenderPass(renderPass);
+
+    auto *effect = new Qt3DRender::QEffect();
+    effect->addTechnique(technique);
+
+    auto *material = new Qt3DRender::QMaterial();
+    material->setEffect(effect);
+    return material;
+}
+}
+
+InstancedMarkerRenderer::InstancedMarkerRenderer(Qt3DCore::QEntity *parent, float surfaceRadius)
+    : rendererEntity(new Qt3DCore::QEntity(parent)),
+      geometryRenderer(new Qt3DRender::QGeometryRenderer()),
+      transformBuffer(nullptr),
+      colorBuffer(nullptr),
+      rotationAttribute(nullptr),
+      radiusAttribute(nullptr),
+      colorAttribute(nullptr),
+      lightParameter(new Qt3DRender::QParameter("lightPosition", QVector3D(3.0f, 3.0f, 3.0f))),
+      dirtyColorCount(0),
+      transformsDirty(false),
+      colorBufferResized(false),
+      count(0)
+{
+    int indexCount = 0;
+    auto *geometry = createUnitCapGeometry(indexCount);
+
+    const int transformStride = floatsPerInstance * sizeof(float);
+    transformBuffer = new Qt3DCore::QBuffer(geometry);
+    colorBuffer = new Qt3DCore::QBuffer(geometry);
+    rotationAttribute = createInstanceAttribute("instanceRotation", transformBuffer, Qt3DCore::QAttribute::Float,
+                                                4, transformStride, 0);
+    radiusAttribute = createInstanceAttribute("instanceRadius", transformBuffer, Qt3DCore::QAttribute::Float,
+                                              1, transformStride, 4 * sizeof(float));
+    colorAttribute = createInstanceAttribute("instanceRgba", colorBuffer, Qt3DCore::QAttribute::UnsignedByte,
+                                             4, bytesPerColor, 0);
+    geometry->addAttribute(rotationAttribute);
+    geometry->addAttribute(radiusAttribute);
+    geometry->addAttribute(colorAttribute);
+
+    geometryRenderer->setGeometry(geometry);
+    geometryRenderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Triangles);
+    geometryRenderer->setVertexCount(indexCount);
+    geometryRenderer->setInstanceCount(0);
+
+    auto *material = createInstancedMaterial();
+    material->addParameter(new Qt3DRender::QParameter("surfaceRadius", surfaceRadius));
+    material->addParameter(new Qt3DRender::QParameter("shininess", 16.0f));
+    material->addParameter(lightParameter);
+
+    // Die Kappen-Parameter sind keine Positionen; Huellvolumen daher explizit um die ganze Kugel legen
+    auto *boundingVolume = new Qt3DCore::QBoundingVolume();
+    const float extent = surfaceRadius * 2.0f;
+    boundingVolume->setMinPoint(QVector3D(-extent, -extent, -extent));
+    boundingVolume->setMaxPoint(QVector3D(extent, extent, extent));
+
+    rendererEntity->addComponent(geometryRenderer);
+    rendererEntity->addComponent(material);
+    rendererEntity->addComponent(boundingVolume);
+}
+
+void InstancedMarkerRenderer::resize(int instanceCount)
+{
+    instanceCount = qMax(0, instanceCount);
+    if (instanceCount == count) {
+        return;
+    }
+    count = instanceCount;
+    transformData.resize(count * floatsPerInstance * sizeof(float));
+    colorData.resize(count * bytesPerColor);
+    dirtyColors.fill(0, (count + 63) / 64);
+    dirtyColorCount = 0;
+    colorBufferResized = true;
+    transformsDirty = true;
+}
+
+void InstancedMarkerRenderer::setTransforms(const float *posX, const float *posY, const float *posZ, const float *radii)
+{
+    float *out = reinterpret_cast<float *>(transformData.data());
+
+    for (int i = 0; i < count; ++i) {
+        // Drehung von +Y auf die Markernormale: q = (1 + ny, nz, 0, -nx), normiert
+        float w = 1.0f + posY[i];
+        float x = posZ[i];
+        float y = 0.0f;
+        float z = -posX[i];
+        float norm = qSqrt(w * w + x * x + z * z);
+        if (norm < 1e-6f) {
+            // Gegenpol: halbe Umdrehung um die X-Achse
+            w = 0.0f; x = 1.0f; z = 0.0f;
+            norm = 1.0f;
+        }
+
+        *out++ = x / norm;
+        *out++ = y;
+        *out++ = z / norm;
+        *out++ = w / norm;
+        *out++ = radii[i];
+    }
+    transformsDirty = true;
+}
+
+void InstancedMarkerRenderer::setColor(int index, const QColor &color)
+{
+    if (index < 0 || index >= count) {
+        return;
+    }
+    uchar *rgba = reinterpret_cast<uchar *>(colorData.data()) + index * bytesPerColor;
+    const uchar r = static_cast<uchar>(color.red());
+    const uchar g = static_cast<uchar>(color.green());
+    const uchar b = static_cast<uchar>(color.blue());
+    if (rgba[0] == r && rgba[1] == g && rgba[2] == b && rgba[3] == 255) {
+        return;
+    }
+    rgba[0] = r;
+    rgba[1] = g;
+    rgba[2] = b;
+    rgba[3] = 255;
+
+    quint64 &word = dirtyColors[index >> 6];
+    const quint64 bit = quint64(1) << (index & 63);
+    if (!(word & bit)) {
+        word |= bit;
+        ++dirtyColorCount;
+    }
+}
+
+void InstancedMarkerRenderer::upload()
+{
+    if (transformsDirty) {
+        // Orientierungen aendern sich mit jedem Schritt; ein Upload fuer alle Instanzen
+        transformBuffer->setData(transformData);
+        transformsDirty = false;
+    }
+    uploadColors();
+
+    rotationAttribute->setCount(count);
+    radiusAttribute->setCount(count);
+    colorAttribute->setCount(count);
+    geometryRenderer->setInstanceCount(count);
+}
+
+void InstancedMarkerRenderer::uploadColors()
+{
+    if (colorBufferResized) {
+        colorBuffer->setData(colorData);
+        colorBufferResized = false;
+        dirtyColors.fill(0);
+        dirtyColorCount = 0;
+        return;
+    }
+    if (dirtyColorCount == 0) {
+        return;
+    }
+
+    // Zusammenhaengende Dirty-Bits zu Bereichen zusammenfassen
+    QVector<QPair<int, int>> ranges;
+    int rangeStart = -1;
+    for (int word = 0; word < dirtyColors.size(); ++word) {
+        quint64 bits = dirtyColors[word];
+        if (bits == 0) {
+            if (rangeStart >= 0) {
+                ranges.append({rangeStart, word * 64});
+                rangeStart = -1;
+            }
+            continue;
+        }
+        for (int bit = 0; bit < 64; ++bit) {
+            const int index = word * 64 + bit;
+            const bool dirty = (bits >> bit) & 1;
+            if (dirty && rangeStart < 0) {
+                rangeStart = index;
+            } else if (!dirty && rangeStart >= 0) {
+                ranges.append({rangeStart, index});
+                rangeStart = -1;
+            }
+        }
+        if (ranges.size() > maxColorRanges) {
+            break;
+        }
+    }
+    if (rangeStart >= 0) {
+        ranges.append({rangeStart, qMin(count, dirtyColors.size() * 64)});
+    }
+
+    if (ranges.size() > maxColorRanges) {
+        colorBuffer->setData(colorData);
+    } else {
+        for (const auto &range : ranges) {
+            const int offset = range.first * bytesPerColor;
+            colorBuffer->updateData(offset, colorData.mid(offset, (range.second - range.first) * bytesPerColor));
+        }
+    }
+    dirtyColors.fill(0);
+    dirtyColorCount = 0;
+}
+
+void InstancedMarkerRenderer::clear()
+{
+    count = 0;
+    transformData.clear();
+    colorData.clear();
+    dirtyColors.clear();
+    dirtyColorCount = 0;
+    transformsDirty = false;
+    colorBufferResized = false;
+    transformBuffer->setData(QByteArray());
+    colorBuffer->setData(QByteArray());
+    rotationAttribute->setCount(0);
+    radiusAttribute->setCount(0);
+    colorAttribute->setCount(0);
+    geometryRenderer->setInstanceCount(0);
+}
+
+void InstancedMarkerRenderer::setEnabled(bool enabled)
+{
+    rendererEntity->setEnabled(enabled);
+}
+
+void InstancedMarkerRenderer::setLightPosition(const QVector3D &position)
+{
+    lightParameter->setValue(position);
+}
@@ -0,0 +1,74 @@
+#ifndef INSTANCEDMARKERRENDERER_H
+#define INSTANCEDMARKERRENDERER_H
+
+#include <Qt3DCore/QEntity>
+#include <QByteArray>
+#include <QColor>
+#include <QVector>
+#include <QVector3D>
+
+QT_BEGIN_NAMESPACE
+namespace Qt3DCore {
+    class QAttribute;
+    class QBuffer;
+}
+namespace Qt3DRender {
+    class QGeometryRenderer;
+    class QParameter;
+}
+QT_END_NAMESPACE
+
+/**
+ * @brief InstancedMarkerRenderer - Zeichnet alle Marker mit einem einzigen instanzierten Draw-Call
+ *
+ * Verantwortlichkeiten:
+ * - Ein gemeinsames Kappen-Mesh mit Einheitsparametern; Oeffnungswinkel und Dicke berechnet der Vertex-Shader
+ *   aus dem Markerradius, genau wie SurfaceMarker
+ * - Transformationspuffer (Quaternion und Radius) mit einem Upload je Bild
+ * - Getrennter, kompakter Farbpuffer (RGBA8 je Instanz) mit Dirty-Bitset: nur geaenderte Bereiche werden
+ *   hochgeladen, Kollisions- und Auswahlfarben kosten O(geaenderte Marker)
+ * - Shader (GLSL 1.50 core) werden aus den Qt-Ressourcen geladen (shaders.qrc)
+ * - Alternative zu den Einzel-Entities von SurfaceMarker fuer grosse Markeranzahlen
+ */
+class InstancedMarkerRenderer {
+public:
+    InstancedMarkerRenderer(Qt3DCore::QEntity *parent, float surfaceRadius);
+    ~InstancedMarkerRenderer() = default;
+
+    // Passt die Instanzanzahl an; neue Instanzen sind schwarz, bis setColor sie setzt
+    void resize(int count);
+    // Ersetzt alle Orientierungen und Radien; Positionen sind Einheitsvektoren
+    void setTransforms(const float *posX, const float *posY, const float *posZ, const float *radii);
+    // Markiert die Instanz nur als geaendert, wenn sich die Farbe tatsaechlich aendert
+    void setColor(int index, const QColor &color);
+    // Laedt ausstehende Transformationen und geaenderte Farbbereiche hoch
+    void upload();
+    void clear();
+    int instanceCount() const { return count; }
+
+    void setEnabled(bool enabled);
+    void setLightPosition(const QVector3D &position);
+
+    Qt3DCore::QEntity *entity() const { return rendererEntity; }
+
+private:
+    void uploadColors();
+
+    Qt3DCore::QEntity *rendererEntity;
+    Qt3DRender::QGeometryRenderer *geometryRenderer;
+    Qt3DCore::QBuffer *transformBuffer;
+    Qt3DCore::QBuffer *colorBuffer;
+    Qt3DCore::QAttribute *rotationAttribute;
+    Qt3DCore::QAttribute *radiusAttribute;
+    Qt3DCore::QAttribute *colorAttribute;
+    Qt3DRender::QParameter *lightParameter;
+    QByteArray transformData;
+    QByteArray colorData;            // r, g, b, a je Instanz
+    QVector<quint64> dirtyColors;    // ein Bit je Instanz
+    int dirtyColorCount;
+    bool transformsDirty;
+    bool colorBufferResized;         // Groesse geaendert: ganzer Puffer statt Teilbereichen
+    int count;
+};
+
+#endif // INSTANCEDMARKERRENDERER_H
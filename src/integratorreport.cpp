@@ -0,0 +1,137 @@
+#include "integratorreport.h"
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QtMath>
+
+namespace IntegratorReport {
+
+namespace {
+double relativeError(double energy, double reference)
+{
+    const double scale = qAbs(reference);
+    return scale > 0.0 ? qAbs(energy - reference) / scale : qAbs(energy - reference);
+}
+}
+
+int runCount(const Options &options)
+{
+    int timeSteps = 0;
+    for (float timeStep : options.timeSteps) {
+        if (timeStep > 0.0f) {
+            ++timeSteps;
+        }
+    }
+    return static_cast<int>(options.integrators.size() * options.precisions.size()) * timeSteps;
+}
+
+QVector<Entry> run(const SimulationCore &initial, const Options &options, const std::atomic<bool> *cancelled,
+                   const std::function<void(int, int)> &progress)
+{
+    QVector<Entry> entries;
+    auto isCancelled = [cancelled]() { return cancelled && cancelled->load(std::memory_order_relaxed); };
+    if (isCancelled()) {
+        return entries;
+    }
+    const double referenceEnergy = initial.totalEnergy();
+    const int samples = qMax(1, options.energySamples);
+    const int total = runCount(options);
+
+    for (SimulationCore::Integrator integrator : options.integrators) {
+        for (SimulationCore::Precision precision : options.precisions) {
+            for (float timeStep : options.timeSteps) {
+                if (timeStep <= 0.0f) {
+                    continue;
+                }
+
+                SimulationCore core = initial;
+                core.setIntegrator(integrator);
+                core.setPrecision(precision);
+                const quint64 initialEvaluations = core.accelerationEvaluations();
+
+                const int steps = qMax(1, qRound(options.duration / timeStep));
+                double maxError = 0.0;
+                double lastError = 0.0;
+                qint64 elapsedNs = 0;
+                QElapsedTimer timer;
+
+                int done = 0;
+                for (int sample = 1; sample <= samples; ++sample) {
+                    const int target = static_cast<int>((qint64(steps) * sample) / samples);
+                    timer.start();
+                    for (; done < target; ++done) {
+                        if (isCancelled()) {
+                            return entries;
+                        }
+                        core.advance(timeStep);
+                    }
+                    elapsedNs += timer.nsecsElapsed();
+
+                    lastError = relativeError(core.totalEnergy(), referenceEnergy);
+                    maxError = qMax(maxError, lastError);
+                }
+
+                entries.append({
+                    integrator,
+                    precision,
+                    timeStep,
+                    steps,
+                    static_cast<int>(qRound64(double(core.accelerationEvaluations() - initialEvaluations)
+                                              / qMax(1, core.size()))),
+                    maxError,
+                    lastError,
+                    elapsedNs / 1.0e6
+                });
+                if (progress) {
+                    progress(static_cast<int>(entries.size()), total);
+                }
+            }
+        }
+    }
+
+    return entries;
+}
+
+QString formatTable(const QVector<Entry> &entries)
+{
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7\n")
+        .arg(QString("Integrator"), -10)
+        .arg(QString("Genauigk."), -9)
+        .arg(QString("dt"), 9)
+        .arg(QString("Kraft-Ausw."), 11)
+        .arg(QString("max |dE/E|"), 12)
+        .arg(QString("End |dE/E|"), 12)
+        .arg(QString("Zeit [ms]"), 10);
+
+    for (const Entry &entry : entries) {
+        text += QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg(QString::fromLatin1(SimulationCore::integratorName(entry.integrator)), -10)
+            .arg(QString::fromLatin1(SimulationCore::precisionName(entry.precision)), -9)
+            .arg(entry.timeStep, 9, 'f', 5)
+            .arg(entry.forceEvaluations, 11)
+            .arg(entry.maxRelativeEnergyError, 12, 'e', 2)
+            .arg(entry.finalRelativeEnergyError, 12, 'e', 2)
+            .arg(entry.wallMilliseconds, 10, 'f', 1);
+    }
+    return text;
+}
+
+QJsonArray toJson(const QVector<Entry> &entries)
+{
+    QJsonArray array;
+    for (const Entry &entry : entries) {
+        QJsonObject obj;
+        obj["integrator"] = SimulationCore::integratorName(entry.integrator);
+        obj["precision"] = SimulationCore::precisionName(entry.precision);
+        obj["timeStep"] = entry.timeStep;
+        obj["steps"] = entry.steps;
+        obj["forceEvaluations"] = entry.forceEvaluations;
+        obj["maxRelativeEnergyError"] = entry.maxRelativeEnergyError;
+        obj["finalRelativeEnergyError"] = entry.finalRelativeEnergyError;
+        obj["wallMilliseconds"] = entry.wallMilliseconds;
+        array.append(obj);
+    }
+    return array;
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef INTEGRATORREPORT_H
+#define INTEGRATORREPORT_H
+
+#include <QJsonArray>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+#include "simulationcore.h"
+
+/**
+ * @brief IntegratorReport - Vergleich der Integratoren nach Energiefehler und Rechenzeit
+ *
+ * Verantwortlichkeiten:
+ * - Integriert Kopien eines Ausgangszustands mit jedem Integrator, mehreren Schrittweiten und jeder
+ *   gewaehlten Rechengenauigkeit (ohne Kollisionen)
+ * - Misst den maximalen und den End-Fehler der Gesamtenergie relativ zum Startwert
+ * - Misst die reine Integrationszeit (Wall-Clock, ohne die Energieauswertung)
+ * - Ausgabe als Texttabelle oder JSON
+ * - Abbruch ueber ein Flag (je Schritt geprueft) und Fortschritt je Lauf, z. B. fuer einen Hintergrund-Thread
+ */
+namespace IntegratorReport {
+
+struct Options {
+    double duration = 1.0;                                          // simulierte Sekunden je Lauf
+    QVector<float> timeSteps{1.0f / 15.0f, 1.0f / 30.0f, 1.0f / 60.0f, 1.0f / 120.0f};
+    int energySamples = 8;                                          // Energieauswertungen je Lauf
+    QVector<SimulationCore::Integrator> integrators{
+        SimulationCore::Integrator::Euler,
+        SimulationCore::Integrator::Leapfrog,
+        SimulationCore::Integrator::Yoshida4,
+        SimulationCore::Integrator::RK4,
+        SimulationCore::Integrator::Block
+    };
+    QVector<SimulationCore::Precision> precisions{
+        SimulationCore::Precision::Float,
+        SimulationCore::Precision::Double
+    };
+};
+
+struct Entry {
+    SimulationCore::Integrator integrator;
+    SimulationCore::Precision precision;
+    float timeStep;
+    int steps;
+    int forceEvaluations;          // gemessen, in vollen Auswertungen (Block-Integrator wertet nur faellige Marker aus)
+    double maxRelativeEnergyError;
+    double finalRelativeEnergyError;
+    double wallMilliseconds;
+};
+
+// Anzahl der Laeufe, die run() mit diesen Optionen rechnet
+int runCount(const Options &options = Options());
+// cancelled: wird vor jedem Schritt gelesen, bei true endet run() sofort mit den bis dahin fertigen Eintraegen.
+// progress(finished, total) nach jedem Lauf, im aufrufenden Thread
+QVector<Entry> run(const SimulationCore &initial, const Options &options = Options(),
+                   const std::atomic<bool> *cancelled = nullptr,
+                   const std::function<void(int finished, int total)> &progress = {});
+QString formatTable(const QVector<Entry> &entries);
+QJsonArray toJson(const QVector<Entry> &entries);
+
+}
+
+#endif // INTEGRATORREPORT_H
@@ -3,7 +3,11 @@
 #include "spherewidget.h"
 #include "markersettingspanel.h"
 #include "markerlistpanel.h"
+#include "recordingpanel.h"
+#include "frameprofiler.h"
+#include "frameprofileroverlay.h"
 #include "scenariomanager.h"
+#include "integratorreport.h"
 
 #include <QColor>
 #include <QHBoxLayout>
@@ -11,6 +15,10 @@
 #include <QLabel>
 #include <QWidget>
 #include <QTabWidget>
+#include <QMessageBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QProgressDialog>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent) {
@@ -69,6 +77,10 @@ MainWindow::MainWindow(QWidget *parent)
 
     tabWidget->addTab(objectsTab, "Objekte");
 
+    // Tab 3: Trajektorien-Aufzeichnung und Wiedergabe
+    recordingPanel = new RecordingPanel(viewportController->getSphereWidget());
+    tabWidget->addTab(recordingPanel, "Aufnahme");
+
     panelLayout->addWidget(tabWidget, 1);
     layout->addWidget(settingsPanel, 0);
 
@@ -76,8 +88,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Connect marker settings signals
     connect(markerSettingsPanel, &MarkerSettingsPanel::generateRequested, this,
-            [this](int count, float speed, float size, float density) {
-                viewportController->getSphereWidget()->generateMarkers(count, speed, size, density);
+            [this](const MarkerGenerator::Settings &settings) {
+                viewportController->getSphereWidget()->generateMarkers(settings);
                 markerListPanel->refreshMarkersTree();
             });
 
@@ -118,8 +130,136 @@ MainWindow::MainWindow(QWidget *parent)
                 viewportController->getSphereWidget()->setTimeScale(scale);
             });
 
+    connect(markerSettingsPanel, &MarkerSettingsPanel::forceSolverChanged, this,
+            [this](int solver) {
+                viewportController->getSphereWidget()->setForceSolver(
+                    solver == 1 ? SimulationCore::ForceSolver::BarnesHut : SimulationCore::ForceSolver::BruteForce);
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::openingAngleChanged, this,
+            [this](float angle) {
+                viewportController->getSphereWidget()->setOpeningAngle(angle);
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::threadCountChanged, this,
+            [this](int threads) {
+                viewportController->getSphereWidget()->setThreadCount(threads);
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::integratorChanged, this,
+            [this](int integrator) {
+                viewportController->getSphereWidget()->setIntegrator(
+                    static_cast<SimulationCore::Integrator>(integrator));
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::precisionChanged, this,
+            [this](int precision) {
+                viewportController->getSphereWidget()->setPrecision(
+                    static_cast<SimulationCore::Precision>(precision));
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::collisionModeChanged, this,
+            [this](int mode) {
+                viewportController->getSphereWidget()->setCollisionMode(
+                    static_cast<SimulationCore::CollisionMode>(mode));
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::instancingThresholdChanged, this,
+            [this](int markers) {
+                viewportController->getSphereWidget()->setInstancingThreshold(markers);
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::profilerToggled, this,
+            [this](bool enabled) {
+                viewportController->getProfilerOverlay()->setProfilingEnabled(enabled);
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::traceExportRequested, this,
+            [this]() {
+                // Momentaufnahme sofort, damit der Dateidialog die exportierten Sekunden nicht verschiebt
+                const QByteArray trace = FrameProfiler::instance().chromeTrace(10.0);
+                const QString path = QFileDialog::getSaveFileName(this, "Chrome-Trace exportieren", "gravity-trace.json",
+                                                                  "Chrome Trace (*.json)");
+                if (path.isEmpty()) {
+                    return;
+                }
+                QFile file(path);
+                if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(trace) != trace.size()) {
+                    QMessageBox::warning(this, "Chrome-Trace exportieren",
+                                         QString("Datei konnte nicht geschrieben werden: %1").arg(file.errorString()));
+                }
+            });
+
+    connect(markerSettingsPanel, &MarkerSettingsPanel::integratorReportRequested, this,
+            &MainWindow::startIntegratorReport);
+
+    // Die Wiedergabe zeigt einen anderen Markerbestand als die Live-Simulation
+    connect(viewportController->getSphereWidget(), &SphereWidget::playbackStateChanged, this,
+            [this]() {
+                markerListPanel->refreshMarkersTree();
+            });
+
     // Initial population of markers list
     markerListPanel->refreshMarkersTree();
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    reportCancelled = true;
+    if (reportThread.joinable()) {
+        reportThread.join();
+    }
+}
+
+void MainWindow::startIntegratorReport()
+{
+    if (reportThread.joinable()) {
+        return;
+    }
+
+    // Laeuft auf einer Kopie des aktuellen Zustands in einem eigenen Thread; Simulation und Darstellung laufen weiter
+    auto state = std::make_shared<const SimulationCore>(viewportController->getSphereWidget()->simulationCopy());
+    const IntegratorReport::Options options;
+    const int markers = state->size();
+    reportCancelled = false;
+
+    // Ohne autoClose/autoReset: setValue() darf den Dialog nicht schliessen, das Aufraeumen passiert unten
+    reportProgress = new QProgressDialog(QString("Integrator-Bericht fuer %1 Marker wird berechnet ...").arg(markers),
+                                         "Abbrechen", 0, IntegratorReport::runCount(options), this);
+    reportProgress->setWindowTitle("Integrator-Bericht");
+    reportProgress->setWindowModality(Qt::WindowModal);
+    reportProgress->setAutoClose(false);
+    reportProgress->setAutoReset(false);
+    reportProgress->setMinimumDuration(0);
+    reportProgress->setValue(0);
+    connect(reportProgress, &QProgressDialog::canceled, this, [this]() {
+        reportCancelled = true;
+    });
+
+    reportThread = std::thread([this, state, options, markers]() {
+        const auto entries = IntegratorReport::run(*state, options, &reportCancelled, [this](int finished, int) {
+            QMetaObject::invokeMethod(this, [this, finished]() {
+                if (reportProgress) {
+                    reportProgress->setValue(finished);
+                }
+            }, Qt::QueuedConnection);
+        });
+
+        QMetaObject::invokeMethod(this, [this, entries, markers]() {
+            reportThread.join();
+            if (reportProgress) {
+                reportProgress->deleteLater();
+            }
+            if (reportCancelled) {
+                return;
+            }
+
+            QMessageBox box(this);
+            box.setWindowTitle("Integrator-Bericht");
+            box.setText(QString("Energiefehler und Rechenzeit fuer %1 Marker ueber 1 s Simulationszeit je Integrator und Genauigkeit (ohne Kollisionen):")
+                            .arg(markers));
+            box.setInformativeText("<pre>" + IntegratorReport::formatTable(entries).toHtmlEscaped() + "</pre>");
+            box.exec();
+        }, Qt::QueuedConnection);
+    });
+}
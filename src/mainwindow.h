@@ -2,21 +2,27 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QPointer>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 class ViewportController;
 class MarkerSettingsPanel;
 class MarkerListPanel;
+class RecordingPanel;
 class ScenarioManager;
 class QTabWidget;
+class QProgressDialog;
 
 /**
  * @brief MainWindow - Hauptfenster der Anwendung
  * 
  * Verantwortlichkeiten:
  * - Verwaltung der Gesamtoberflaeche und des Fenster-Layouts
- * - Koordination zwischen den Komponenten (ViewportController, MarkerSettingsPanel, MarkerListPanel, ScenarioManager)
+ * - Koordination zwischen den Komponenten (ViewportController, MarkerSettingsPanel, MarkerListPanel, RecordingPanel, ScenarioManager)
  * - Verbindung der Signale zwischen den GUI-Komponenten und dem 3D-Widget
+ * - Integrator-Bericht in einem Hintergrund-Thread mit Fortschrittsdialog und Abbruch
  */
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -26,13 +32,20 @@ public:
     ~MainWindow();
 
 private:
+    void startIntegratorReport();
+
     std::unique_ptr<ViewportController> viewportController;
     std::unique_ptr<ScenarioManager> scenarioManager;
     
     QWidget *settingsPanel;
     MarkerSettingsPanel *markerSettingsPanel;
     MarkerListPanel *markerListPanel;
+    RecordingPanel *recordingPanel;
     QTabWidget *tabWidget;
+
+    std::thread reportThread;              // laufender Integrator-Bericht, wird im GUI-Thread eingesammelt
+    std::atomic<bool> reportCancelled{false};
+    QPointer<QProgressDialog> reportProgress;
 };
 
 #endif // MAINWINDOW_H
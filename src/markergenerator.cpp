@@ -0,0 +1,151 @@
+#include "markergenerator.h"
+
+namespace {
+// Strom fuer die Anordnung (Clusterzentren, Ringachse); Marker verwenden die Stroeme 0..count-1
+constexpr quint64 layoutStream = ~quint64(0);
+
+Vec3 randomUnitVector(CounterRng &rng)
+{
+    const float z = static_cast<float>(rng.uniform(-1.0, 1.0));
+    const float t = static_cast<float>(rng.uniform(0.0, 2.0 * M_PI));
+    const float r = qSqrt(qMax(0.0f, 1.0f - z * z));
+    return Vec3(r * qCos(t), z, r * qSin(t)).normalized();
+}
+
+// Zwei orthonormale Tangentialvektoren an die Einheitsnormale n
+void tangentBasis(const Vec3 &n, Vec3 &e1, Vec3 &e2)
+{
+    e1 = Vec3::cross(n, qAbs(n.y) < 0.9f ? Vec3(0.0f, 1.0f, 0.0f) : Vec3(1.0f, 0.0f, 0.0f)).normalized();
+    e2 = Vec3::cross(n, e1);
+}
+
+Vec3 tangentDirection(const Vec3 &pos, const Vec3 &dir)
+{
+    Vec3 tangent = dir - Vec3::dot(dir, pos) * pos;
+    if (tangent.lengthSquared() < 1e-6f) {
+        tangent = Vec3::cross(pos, Vec3(0.0f, 1.0f, 0.0f));
+        if (tangent.lengthSquared() < 1e-6f) {
+            tangent = Vec3::cross(pos, Vec3(1.0f, 0.0f, 0.0f));
+        }
+    }
+    return tangent.normalized();
+}
+
+// Punkt im Winkelabstand angle von center in Richtung bearing (geodaetisch)
+Vec3 offsetOnSphere(const Vec3 &center, float angle, float bearing)
+{
+    Vec3 e1;
+    Vec3 e2;
+    tangentBasis(center, e1, e2);
+    const Vec3 direction = e1 * qCos(bearing) + e2 * qSin(bearing);
+    return (center * qCos(angle) + direction * qSin(angle)).normalized();
+}
+}
+
+double CounterRng::normal()
+{
+    // 1 - u statt u, damit log(0) ausgeschlossen ist
+    const double u1 = 1.0 - uniform();
+    const double u2 = uniform();
+    return qSqrt(-2.0 * qLn(u1)) * qCos(2.0 * M_PI * u2);
+}
+
+const char *MarkerGenerator::distributionName(Distribution distribution)
+{
+    switch (distribution) {
+    case Distribution::Uniform:
+        return "uniform";
+    case Distribution::Clustered:
+        return "clustered";
+    case Distribution::Band:
+        return "band";
+    case Distribution::Ring:
+        return "ring";
+    }
+    return "unknown";
+}
+
+bool MarkerGenerator::parseDistribution(const QString &name, Distribution &distribution)
+{
+    for (auto candidate : {Distribution::Uniform, Distribution::Clustered, Distribution::Band, Distribution::Ring}) {
+        if (name.compare(distributionName(candidate), Qt::CaseInsensitive) == 0) {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+MarkerGenerator::MarkerGenerator(const Settings &settings)
+    : config(settings),
+      ringAxis(0.0f, 1.0f, 0.0f)
+{
+    CounterRng rng(config.seed, layoutStream);
+    if (config.distribution == Distribution::Clustered) {
+        const int clusters = qMax(1, config.clusterCount);
+        clusterCenters.reserve(clusters);
+        for (int c = 0; c < clusters; ++c) {
+            clusterCenters.append(randomUnitVector(rng));
+        }
+    } else if (config.distribution == Distribution::Ring) {
+        ringAxis = randomUnitVector(rng);
+    }
+}
+
+Vec3 MarkerGenerator::samplePosition(CounterRng &rng) const
+{
+    const float spread = qMax(0.0f, config.spread);
+
+    switch (config.distribution) {
+    case Distribution::Uniform:
+        break;
+    case Distribution::Clustered: {
+        const int cluster = qMin(static_cast<int>(rng.uniform() * clusterCenters.size()), static_cast<int>(clusterCenters.size()) - 1);
+        // Zweidimensionale Normalverteilung in der Tangentialebene: Betrag Rayleigh-, Richtung gleichverteilt
+        const float angle = spread * static_cast<float>(qSqrt(-2.0 * qLn(1.0 - rng.uniform())));
+        const float bearing = static_cast<float>(rng.uniform(0.0, 2.0 * M_PI));
+        return offsetOnSphere(clusterCenters[cluster], qMin(angle, float(M_PI)), bearing);
+    }
+    case Distribution::Band: {
+        // Flaechentreu: z = sin(Breite) gleichverteilt zwischen den Bandgrenzen
+        const float low = qMax(-float(M_PI_2), config.bandLatitude - spread);
+        const float high = qMin(float(M_PI_2), config.bandLatitude + spread);
+        const float y = static_cast<float>(rng.uniform(qSin(low), qSin(high)));
+        const float t = static_cast<float>(rng.uniform(0.0, 2.0 * M_PI));
+        const float r = qSqrt(qMax(0.0f, 1.0f - y * y));
+        return Vec3(r * qCos(t), y, r * qSin(t)).normalized();
+    }
+    case Distribution::Ring: {
+        Vec3 e1;
+        Vec3 e2;
+        tangentBasis(ringAxis, e1, e2);
+        const float t = static_cast<float>(rng.uniform(0.0, 2.0 * M_PI));
+        const float offset = spread * static_cast<float>(rng.normal());
+        const Vec3 onRing = e1 * qCos(t) + e2 * qSin(t);
+        return (onRing * qCos(offset) + ringAxis * qSin(offset)).normalized();
+    }
+    }
+    return randomUnitVector(rng);
+}
+
+void MarkerGenerator::sample(quint64 index, Vec3 &position, Vec3 &velocity) const
+{
+    CounterRng rng(config.seed, index);
+    position = samplePosition(rng);
+
+    Vec3 direction;
+    if (config.distribution == Distribution::Ring) {
+        direction = tangentDirection(position, Vec3::cross(ringAxis, position));
+    } else {
+        direction = tangentDirection(position, randomUnitVector(rng));
+    }
+    velocity = direction * config.speed;
+
+    if (config.velocityDispersion > 0.0f) {
+        Vec3 e1;
+        Vec3 e2;
+        tangentBasis(position, e1, e2);
+        velocity += e1 * (config.velocityDispersion * static_cast<float>(rng.normal()))
+                  + e2 * (config.velocityDispersion * static_cast<float>(rng.normal()));
+    }
+}
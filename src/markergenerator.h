@@ -0,0 +1,92 @@
+#ifndef MARKERGENERATOR_H
+#define MARKERGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "spheremath.h"
+
+/**
+ * @brief CounterRng - Zaehlerbasierter Zufallsgenerator (SplitMix64-Mischfunktion)
+ *
+ * Jede Zahl ist eine reine Funktion von (Seed, Strom, Zaehler); Strom ist z. B. der Markerindex.
+ * Dadurch kann jeder Thread beliebige Indexbereiche erzeugen, ohne einen gemeinsamen Zustand zu teilen,
+ * und das Ergebnis ist unabhaengig von Thread-Anzahl und Aufteilung.
+ */
+class CounterRng {
+public:
+    CounterRng(quint64 seed, quint64 stream)
+        : key(mix(seed ^ mix(stream + 0x632be59bd9b4e019ull))),
+          counter(0)
+    {
+    }
+
+    quint64 next() { return mix(key + (++counter) * 0x9e3779b97f4a7c15ull); }
+    // Gleichverteilt in [0, 1)
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    double uniform(double minValue, double maxValue) { return minValue + (maxValue - minValue) * uniform(); }
+    // Standardnormalverteilt (Box-Muller)
+    double normal();
+
+    static quint64 mix(quint64 z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    quint64 key;
+    quint64 counter;
+};
+
+/**
+ * @brief MarkerGenerator - Reproduzierbare Startverteilungen fuer SimulationCore::generateMarkers
+ *
+ * Verantwortlichkeiten:
+ * - Positionen gleichverteilt, in Clustern, in einem Breitenband oder entlang eines gekippten Rings
+ * - Geschwindigkeiten: tangential mit zufaelliger Richtung (im Ring mitlaufend) plus normalverteilte Streuung
+ * - Marker i haengt nur von Seed, Einstellungen und i ab (CounterRng-Strom i), daher beliebig parallelisierbar;
+ *   SimulationCore::generateMarkers verwendet die Marker-ID als i
+ */
+class MarkerGenerator {
+public:
+    enum class Distribution {
+        Uniform,    // gleichverteilt auf der Kugel
+        Clustered,  // clusterCount Zentren, Winkelabstand normalverteilt mit spread
+        Band,       // Breitenband um bandLatitude mit Halbbreite spread
+        Ring        // Grosskreis mit zufaelliger Achse, Abstand normalverteilt mit spread, Umlauf in Ringrichtung
+    };
+    static const char *distributionName(Distribution distribution);
+    static bool parseDistribution(const QString &name, Distribution &distribution);
+
+    struct Settings {
+        int count = 0;
+        float speed = 0.5f;
+        float size = 0.1f;
+        float density = 1.0f;
+        quint32 color = 0x78beff;
+        quint64 seed = 1;
+        Distribution distribution = Distribution::Uniform;
+        int clusterCount = 4;
+        float spread = 0.2f;              // Bogenmass
+        float bandLatitude = 0.0f;        // Bogenmass
+        float velocityDispersion = 0.0f;  // Standardabweichung je Tangentialrichtung
+    };
+
+    explicit MarkerGenerator(const Settings &settings);
+
+    const Settings &settings() const { return config; }
+    // Marker index der Erzeugung; Position ist ein Einheitsvektor, Geschwindigkeit tangential
+    void sample(quint64 index, Vec3 &position, Vec3 &velocity) const;
+
+private:
+    Vec3 samplePosition(CounterRng &rng) const;
+
+    Settings config;
+    QVector<Vec3> clusterCenters;
+    Vec3 ringAxis;
+};
+
+#endif // MARKERGENERATOR_H
@@ -0,0 +1,103 @@
+#include "markerlistmodel.h"
+#include "spherewidget.h"
+#include "markerstateview.h"
+
+MarkerListModel::MarkerListModel(SphereWidget *sphereWidget, QObject *parent)
+    : QAbstractListModel(parent),
+      sphereWidget(sphereWidget),
+      rows(sphereWidget->markerCount())
+{
+    connect(sphereWidget, &SphereWidget::markerCountChanged, this, &MarkerListModel::setMarkerCount);
+    connect(sphereWidget, &SphereWidget::markerStructureChanged, this, &MarkerListModel::applyStructureChanges);
+}
+
+int MarkerListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+QVariant MarkerListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows) {
+        return {};
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole: {
+        const MarkerStateView markers = sphereWidget->markerState();
+        // Waehrend einer Verkleinerung kann die Zeile bis zum folgenden markerCountChanged ueberstehen
+        return markers.contains(index.row()) ? markerName(markers.id(index.row())) : QVariant();
+    }
+    default:
+        return {};
+    }
+}
+
+QString MarkerListModel::markerName(quint32 markerId)
+{
+    return QString("Marker %1").arg(quint64(markerId) + 1);
+}
+
+void MarkerListModel::setMarkerCount(int count)
+{
+    if (count > rows) {
+        beginInsertRows(QModelIndex(), rows, count - 1);
+        rows = count;
+        endInsertRows();
+    } else if (count < rows) {
+        beginRemoveRows(QModelIndex(), count, rows - 1);
+        rows = count;
+        endRemoveRows();
+    }
+}
+
+void MarkerListModel::applyStructureChanges(const QVector<SimulationCore::StructureChange> &changes)
+{
+    const QModelIndexList persistent = persistentIndexList();
+    if (persistent.isEmpty()) {
+        // Nur die Namen der nachgerueckten Zeilen haben sich geaendert
+        if (rows > 0) {
+            emit dataChanged(index(0), index(rows - 1), {Qt::DisplayRole, Qt::EditRole});
+        }
+        return;
+    }
+
+    // Persistente Zeilen (Auswahl, aktuelle Zeile, ComboBox) durch alle Swap-Removes verfolgen;
+    // die Zeilenanzahl selbst passt erst das folgende markerCountChanged am Ende an
+    emit layoutAboutToBeChanged();
+    QVector<int> tracked(persistent.size());
+    QVector<quint32> followedIds(persistent.size(), SimulationCore::invalidMarkerId);
+    for (int k = 0; k < persistent.size(); ++k) {
+        tracked[k] = persistent[k].row();
+    }
+    for (const SimulationCore::StructureChange &change : changes) {
+        if (change.kind != SimulationCore::StructureChange::Remove) {
+            continue;
+        }
+        for (int k = 0; k < tracked.size(); ++k) {
+            if (tracked[k] == change.index) {
+                tracked[k] = -1;
+                followedIds[k] = change.mergedInto;
+            } else if (tracked[k] >= 0 && tracked[k] == change.movedFrom) {
+                tracked[k] = change.index;
+            } else if (tracked[k] < 0 && followedIds[k] == change.id) {
+                followedIds[k] = change.mergedInto;
+            }
+        }
+    }
+
+    const MarkerStateView markers = sphereWidget->markerState();
+    const int validRows = qMin(rows, markers.size());
+    QModelIndexList moved;
+    moved.reserve(persistent.size());
+    for (int k = 0; k < tracked.size(); ++k) {
+        int row = tracked[k];
+        if (row < 0 && followedIds[k] != SimulationCore::invalidMarkerId) {
+            row = markers.indexOfId(followedIds[k]);
+        }
+        moved.append(row >= 0 && row < validRows ? index(row) : QModelIndex());
+    }
+    changePersistentIndexList(persistent, moved);
+    emit layoutChanged();
+}
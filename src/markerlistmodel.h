@@ -0,0 +1,41 @@
+#ifndef MARKERLISTMODEL_H
+#define MARKERLISTMODEL_H
+
+#include <QAbstractListModel>
+
+#include "simulationcore.h"
+
+class SphereWidget;
+
+/**
+ * @brief MarkerListModel - Listenmodell der Marker direkt ueber dem Zustand des SphereWidgets
+ *
+ * Verantwortlichkeiten:
+ * - Zeilenanzahl folgt SphereWidget::markerCountChanged, gemeldet als zusammenhaengende
+ *   Einfuege-/Entfernbereiche statt eines kompletten Neuaufbaus
+ * - Swap-Remove (SphereWidget::markerStructureChanged) als Layout-Aenderung: Auswahl und aktuelle Zeile
+ *   wandern mit ihrem Marker, die eines aufgenommenen Markers zum aufnehmenden
+ * - Namen nach der stabilen Marker-ID, damit ein Marker beim Nachruecken seinen Namen behaelt
+ * - Anzeigetexte werden erst bei Abfrage durch die View erzeugt (keine Kopie des Zustands)
+ * - Gemeinsame Quelle fuer Markerliste und Auswahl-ComboBox
+ */
+class MarkerListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit MarkerListModel(SphereWidget *sphereWidget, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    static QString markerName(quint32 markerId);
+
+private:
+    void setMarkerCount(int count);
+    void applyStructureChanges(const QVector<SimulationCore::StructureChange> &changes);
+
+    SphereWidget *sphereWidget;
+    int rows;
+};
+
+#endif // MARKERLISTMODEL_H
@@ -1,25 +1,30 @@
 #include "markerlistpanel.h"
 #include "spherewidget.h"
 #include "editablepropertywidget.h"
+#include "markerlistmodel.h"
 
-#include <QListWidget>
+#include <QListView>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QCompleter>
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QVBoxLayout>
-#include <QDebug>
 
 MarkerListPanel::MarkerListPanel(SphereWidget *sphereWidget, QWidget *parent)
-    : QWidget(parent), sphereWidget(sphereWidget)
+    : QWidget(parent), sphereWidget(sphereWidget), followMarkerIndex(0)
 {
     auto *layout = new QVBoxLayout(this);
     layout->setContentsMargins(0, 0, 0, 0);
     layout->setSpacing(12);
 
-    markersListWidget = new QListWidget(this);
-    markersListWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
-    layout->addWidget(markersListWidget);
+    // Gleich hohe Zeilen: die View fragt nur die sichtbaren Eintraege ab
+    markerListModel = new MarkerListModel(sphereWidget, this);
+    markersListView = new QListView(this);
+    markersListView->setModel(markerListModel);
+    markersListView->setUniformItemSizes(true);
+    markersListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    layout->addWidget(markersListView);
 
     // Gruppe für ausgewählten Marker
     selectedMarkerGroup = new QGroupBox("Ausgewählter Marker", this);
@@ -81,8 +86,22 @@ MarkerListPanel::MarkerListPanel(SphereWidget *sphereWidget, QWidget *parent)
     markerActionCheckBox = new QCheckBox(markerControlsGroup);
     markerActionCheckBox->setChecked(false);
 
+    // Teilt sich das Modell mit der Liste; Eingabe filtert per Completer statt alle Eintraege aufzuklappen
     markerSelectionCombo = new QComboBox(markerControlsGroup);
-    markerSelectionCombo->addItem("Keine Marker vorhanden");
+    auto *comboView = new QListView(markerSelectionCombo);
+    comboView->setUniformItemSizes(true);
+    markerSelectionCombo->setView(comboView);
+    markerSelectionCombo->setModel(markerListModel);
+    markerSelectionCombo->setEditable(true);
+    markerSelectionCombo->setInsertPolicy(QComboBox::NoInsert);
+    markerSelectionCombo->setPlaceholderText("Keine Marker vorhanden");
+    markerSelectionCombo->setMaxVisibleItems(15);
+    markerSelectionCombo->completer()->setCompletionMode(QCompleter::PopupCompletion);
+    markerSelectionCombo->completer()->setFilterMode(Qt::MatchContains);
+    markerSelectionCombo->completer()->setCaseSensitivity(Qt::CaseInsensitive);
+    if (auto *popup = qobject_cast<QListView *>(markerSelectionCombo->completer()->popup())) {
+        popup->setUniformItemSizes(true);
+    }
 
     markerControlsForm->addRow("Aktiv", markerActionCheckBox);
     markerControlsForm->addRow("Marker wählen", markerSelectionCombo);
@@ -96,6 +115,9 @@ MarkerListPanel::MarkerListPanel(SphereWidget *sphereWidget, QWidget *parent)
 
     connect(markerSelectionCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
             [this](int index) {
+                if (index >= 0) {
+                    followMarkerIndex = index;
+                }
                 this->sphereWidget->setSelectedMarker(index);
             });
 
@@ -104,57 +126,52 @@ MarkerListPanel::MarkerListPanel(SphereWidget *sphereWidget, QWidget *parent)
                 this->sphereWidget->setFollowMarker(checked);
             });
 
-    connect(markersListWidget, &QListWidget::itemSelectionChanged, this, &MarkerListPanel::onMarkerSelectionChanged);
+    connect(markersListView->selectionModel(), &QItemSelectionModel::selectionChanged, this,
+            &MarkerListPanel::onMarkerSelectionChanged);
+    // Entfernte Zeilen verlassen die Auswahl ohne selectionChanged; nach einem Swap-Remove stehen
+    // ausgewaehlte Marker in anderen Zeilen
+    connect(markerListModel, &QAbstractItemModel::rowsRemoved, this, &MarkerListPanel::onMarkerSelectionChanged);
+    connect(markerListModel, &QAbstractItemModel::layoutChanged, this, &MarkerListPanel::onMarkerSelectionChanged);
+    connect(sphereWidget, &SphereWidget::markersChanged, this, &MarkerListPanel::onMarkersChanged);
 }
 
-void MarkerListPanel::refreshMarkersTree()
+void MarkerListPanel::onMarkersChanged(int first, int last, SphereWidget::MarkerFields fields)
 {
-    markersListWidget->clear();
-    const int previousComboIndex = markerSelectionCombo ? markerSelectionCombo->currentIndex() : -1;
-    if (markerSelectionCombo) {
-        markerSelectionCombo->clear();
+    // Geschwindigkeiten aendern sich mit jedem Schritt; angezeigt wird der Wert bei Auswahl bzw. nach einer Eingabe
+    const bool edited = (fields & (SphereWidget::Radius | SphereWidget::Density))
+                        || fields == SphereWidget::MarkerFields(SphereWidget::Velocity);
+    if (!edited || selectedMarkerIndices.isEmpty()) {
+        return;
     }
-
-    const auto markers = sphereWidget->getMarkersInfo();
-
-    if (markerSelectionCombo) {
-        if (markers.isEmpty()) {
-            markerSelectionCombo->addItem("Keine Marker vorhanden");
-            markerSelectionCombo->setEnabled(false);
-        } else {
-            markerSelectionCombo->setEnabled(true);
+    for (int index : selectedMarkerIndices) {
+        if (index >= first && index <= last) {
+            updateSelectedMarkerProperties();
+            return;
         }
     }
+}
 
-    for (const auto &markerInfo : markers) {
-        markersListWidget->addItem(QString("Marker %1").arg(markerInfo.index + 1));
+void MarkerListPanel::refreshMarkersTree()
+{
+    const int count = markerListModel->rowCount();
+    markerSelectionCombo->setEnabled(count > 0);
 
-        if (markerSelectionCombo) {
-            markerSelectionCombo->addItem(QString("Marker %1").arg(markerInfo.index + 1));
-        }
+    if (count == 0) {
+        markerSelectionCombo->setCurrentIndex(-1);
+        sphereWidget->setSelectedMarker(-1);
+        return;
     }
 
-    if (markerSelectionCombo) {
-        if (markers.isEmpty()) {
-            markerSelectionCombo->setCurrentIndex(0);
-            sphereWidget->setSelectedMarker(-1);
-        } else {
-            const int maxIndex = markers.size() - 1;
-            const int nextIndex = qBound(0, previousComboIndex, maxIndex);
-            markerSelectionCombo->setCurrentIndex(nextIndex);
-            sphereWidget->setSelectedMarker(nextIndex);
-        }
-    }
+    const int nextIndex = qBound(0, followMarkerIndex, count - 1);
+    markerSelectionCombo->setCurrentIndex(nextIndex);
+    sphereWidget->setSelectedMarker(nextIndex);
 }
 
 void MarkerListPanel::onMarkerSelectionChanged()
 {
-    qDebug() << "onMarkerSelectionChanged called";
-
-    auto selectedItems = markersListWidget->selectedItems();
+    const QModelIndexList selectedRows = markersListView->selectionModel()->selectedRows();
 
-    if (selectedItems.isEmpty()) {
-        qDebug() << "No items selected";
+    if (selectedRows.isEmpty()) {
         sphereWidget->clearHighlightedMarker();
         selectedMarkerIndices.clear();
         selectedMarkerGroup->setVisible(false);
@@ -163,15 +180,11 @@ void MarkerListPanel::onMarkerSelectionChanged()
 
     // Sammle alle ausgewählten Marker-Indizes
     selectedMarkerIndices.clear();
-    for (auto *item : selectedItems) {
-        int markerIndex = markersListWidget->row(item);
-        if (markerIndex >= 0) {
-            selectedMarkerIndices.append(markerIndex);
-        }
+    selectedMarkerIndices.reserve(selectedRows.size());
+    for (const QModelIndex &row : selectedRows) {
+        selectedMarkerIndices.append(row.row());
     }
 
-    qDebug() << "Selected marker indices:" << selectedMarkerIndices;
-
     // Highlighte den ersten ausgewählten Marker
     if (!selectedMarkerIndices.isEmpty()) {
         sphereWidget->highlightMarker(selectedMarkerIndices.first());
@@ -186,11 +199,11 @@ void MarkerListPanel::updateSelectedMarkerProperties()
         return;
     }
 
-    const auto markers = sphereWidget->getMarkersInfo();
+    const MarkerStateView markers = sphereWidget->markerState();
     
     // Prüfe ob alle Indizes gültig sind
     for (int index : selectedMarkerIndices) {
-        if (index >= markers.size()) {
+        if (!markers.contains(index)) {
             selectedMarkerGroup->setVisible(false);
             return;
         }
@@ -198,16 +211,16 @@ void MarkerListPanel::updateSelectedMarkerProperties()
 
     // Titel setzen
     if (selectedMarkerIndices.size() == 1) {
-        selectedMarkerGroup->setTitle(QString("Marker %1").arg(selectedMarkerIndices.first() + 1));
+        selectedMarkerGroup->setTitle(MarkerListModel::markerName(markers.id(selectedMarkerIndices.first())));
     } else {
         selectedMarkerGroup->setTitle(QString("%1 Marker ausgewählt").arg(selectedMarkerIndices.size()));
     }
 
     // Prüfe ob alle ausgewählten Marker den gleichen Radius haben
     bool sameRadius = true;
-    float firstRadius = markers[selectedMarkerIndices.first()].radius;
+    float firstRadius = markers.radius(selectedMarkerIndices.first());
     for (int i = 1; i < selectedMarkerIndices.size(); ++i) {
-        if (qAbs(markers[selectedMarkerIndices[i]].radius - firstRadius) > 0.0001f) {
+        if (qAbs(markers.radius(selectedMarkerIndices[i]) - firstRadius) > 0.0001f) {
             sameRadius = false;
             break;
         }
@@ -221,9 +234,9 @@ void MarkerListPanel::updateSelectedMarkerProperties()
 
     // Prüfe ob alle ausgewählten Marker die gleiche Dichte haben
     bool sameDensity = true;
-    float firstDensity = markers[selectedMarkerIndices.first()].density;
+    float firstDensity = markers.density(selectedMarkerIndices.first());
     for (int i = 1; i < selectedMarkerIndices.size(); ++i) {
-        if (qAbs(markers[selectedMarkerIndices[i]].density - firstDensity) > 0.0001f) {
+        if (qAbs(markers.density(selectedMarkerIndices[i]) - firstDensity) > 0.0001f) {
             sameDensity = false;
             break;
         }
@@ -237,9 +250,9 @@ void MarkerListPanel::updateSelectedMarkerProperties()
 
     // Prüfe ob alle ausgewählten Marker die gleiche Geschwindigkeit haben
     bool sameVelocity = true;
-    float firstVelocityMagnitude = markers[selectedMarkerIndices.first()].velocity.length();
+    float firstVelocityMagnitude = markers.speed(selectedMarkerIndices.first());
     for (int i = 1; i < selectedMarkerIndices.size(); ++i) {
-        float velocityMagnitude = markers[selectedMarkerIndices[i]].velocity.length();
+        float velocityMagnitude = markers.speed(selectedMarkerIndices[i]);
         if (qAbs(velocityMagnitude - firstVelocityMagnitude) > 0.0001f) {
             sameVelocity = false;
             break;
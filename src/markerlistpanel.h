@@ -3,21 +3,24 @@
 
 #include <QWidget>
 
-class QListWidget;
+#include "spherewidget.h"
+
+class QListView;
 class QCheckBox;
 class QComboBox;
 class QGroupBox;
-class SphereWidget;
 class EditablePropertyWidget;
+class MarkerListModel;
 
 /**
  * @brief MarkerListPanel - Verwaltet Marker-Uebersicht und Verfolgungssteuerung
  * 
  * Verantwortlichkeiten:
- * - Anzeige aller Marker in einer Baumansicht mit Details (Radius, Farbe, Position, Geschwindigkeit)
- * - Verwaltung der Marker-Verfolgungssteuerung (aktiv/inaktiv und Marker-Auswahl)
- * - Aktualisierung der Baumansicht nach Generierung oder Aenderung von Markern
- * - Handling von Marker-Auswahl durch die Baumansicht
+ * - Anzeige aller Marker in einer virtualisierten Listenansicht ueber MarkerListModel
+ * - Verwaltung der Marker-Verfolgungssteuerung (aktiv/inaktiv und durchsuchbare Marker-Auswahl)
+ * - Abgleich der Verfolgungsauswahl nach Generierung oder Aenderung von Markern
+ * - Handling von Marker-Auswahl durch die Listenansicht
+ * - Eigenschaften der Auswahl direkt aus SphereWidget::markerState(), neu gelesen nur bei passenden markersChanged-Bereichen
  */
 class MarkerListPanel : public QWidget {
     Q_OBJECT
@@ -25,15 +28,18 @@ class MarkerListPanel : public QWidget {
 public:
     explicit MarkerListPanel(SphereWidget *sphereWidget, QWidget *parent = nullptr);
 
+    // Die Liste aktualisiert sich selbst; hier wird nur die Verfolgungsauswahl nachgezogen
     void refreshMarkersTree();
 
 private slots:
     void onMarkerSelectionChanged();
     void updateSelectedMarkerProperties();
+    void onMarkersChanged(int first, int last, SphereWidget::MarkerFields fields);
 
 private:
     SphereWidget *sphereWidget;
-    QListWidget *markersListWidget;
+    MarkerListModel *markerListModel;
+    QListView *markersListView;
     QCheckBox *markerActionCheckBox;
     QComboBox *markerSelectionCombo;
     
@@ -43,6 +49,7 @@ private:
     EditablePropertyWidget *selectedDensityWidget;
     EditablePropertyWidget *selectedVelocityWidget;
     QVector<int> selectedMarkerIndices;
+    int followMarkerIndex;
 };
 
 #endif // MARKERLISTPANEL_H
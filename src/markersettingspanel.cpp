@@ -1,5 +1,7 @@
 #include "markersettingspanel.h"
 
+#include <QCheckBox>
+#include <QComboBox>
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QLineEdit>
@@ -11,6 +13,10 @@
 #include <QLocale>
 #include <QSlider>
 #include <QLabel>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QRegularExpressionValidator>
+#include <QtMath>
 
 MarkerSettingsPanel::MarkerSettingsPanel(QWidget *parent)
     : QWidget(parent)
@@ -27,7 +33,7 @@ MarkerSettingsPanel::MarkerSettingsPanel(QWidget *parent)
     countEdit = new QLineEdit(markerGroup);
     countEdit->setText("8");
     countEdit->setPlaceholderText("z. B. 8");
-    countEdit->setValidator(new QIntValidator(0, 10000, countEdit));
+    countEdit->setValidator(new QIntValidator(0, 1000000, countEdit));
 
     auto *doubleValidator = new QDoubleValidator(0.0, 100.0, 4, this);
     doubleValidator->setLocale(QLocale::c());
@@ -47,10 +53,47 @@ MarkerSettingsPanel::MarkerSettingsPanel(QWidget *parent)
     densityEdit->setPlaceholderText("z. B. 1.0");
     densityEdit->setValidator(doubleValidator);
 
+    distributionCombo = new QComboBox(markerGroup);
+    distributionCombo->addItem("Gleichverteilt");
+    distributionCombo->addItem("Cluster");
+    distributionCombo->addItem("Band");
+    distributionCombo->addItem("Ring");
+
+    // Clusterradius, Halbbreite des Bandes bzw. Breite des Rings
+    spreadEdit = new QLineEdit(markerGroup);
+    spreadEdit->setText("10");
+    spreadEdit->setPlaceholderText("Grad, z. B. 10");
+    spreadEdit->setValidator(doubleValidator);
+    spreadEdit->setEnabled(false);
+
+    clusterCountEdit = new QLineEdit(markerGroup);
+    clusterCountEdit->setText("4");
+    clusterCountEdit->setValidator(new QIntValidator(1, 1000, clusterCountEdit));
+    clusterCountEdit->setEnabled(false);
+
+    velocityDispersionEdit = new QLineEdit(markerGroup);
+    velocityDispersionEdit->setText("0.0");
+    velocityDispersionEdit->setPlaceholderText("z. B. 0.1");
+    velocityDispersionEdit->setValidator(doubleValidator);
+
+    // Gleicher Seed und gleiche Parameter ergeben dieselben Marker, unabhaengig von der Thread-Anzahl
+    auto *seedLayout = new QHBoxLayout();
+    seedEdit = new QLineEdit(markerGroup);
+    seedEdit->setText("1");
+    seedEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("\\d{1,20}"), seedEdit));
+    seedLayout->addWidget(seedEdit, 1);
+    randomSeedButton = new QPushButton("Zufall", markerGroup);
+    seedLayout->addWidget(randomSeedButton);
+
     markerForm->addRow("Anzahl", countEdit);
     markerForm->addRow("Geschwindigkeit", speedEdit);
     markerForm->addRow("Größe", sizeEdit);
     markerForm->addRow("Dichte", densityEdit);
+    markerForm->addRow("Verteilung", distributionCombo);
+    markerForm->addRow("Streuung (°)", spreadEdit);
+    markerForm->addRow("Cluster", clusterCountEdit);
+    markerForm->addRow("Geschw.-Streuung", velocityDispersionEdit);
+    markerForm->addRow("Seed", seedLayout);
 
     layout->addWidget(markerGroup);
 
@@ -100,11 +143,13 @@ MarkerSettingsPanel::MarkerSettingsPanel(QWidget *parent)
     sliderLayout->addWidget(slowLabel);
     
     timeScaleSlider = new QSlider(Qt::Horizontal, this);
-    timeScaleSlider->setMinimum(1);  // 0.01x
-    timeScaleSlider->setMaximum(50);  // 5.0x
-    timeScaleSlider->setValue(25);    // 2.5x (Mitte zwischen 0.01 und 5.0 auf log-Skala wäre ~0.7, aber linear Mitte ist 2.55)
+    // Logarithmisch: 20 Stufen je Zehnerpotenz von 0.1x bis 100x (kontinuierliche Kollisionen verhindern
+    // bei grossen Schritten das Durchtunneln)
+    timeScaleSlider->setMinimum(0);   // 0.1x
+    timeScaleSlider->setMaximum(60);  // 100x
+    timeScaleSlider->setValue(28);    // ~2.5x
     timeScaleSlider->setTickPosition(QSlider::TicksBelow);
-    timeScaleSlider->setTickInterval(10);
+    timeScaleSlider->setTickInterval(20);
     sliderLayout->addWidget(timeScaleSlider, 1);
     
     auto *fastLabel = new QLabel("Schnell", this);
@@ -113,9 +158,98 @@ MarkerSettingsPanel::MarkerSettingsPanel(QWidget *parent)
     timeScaleLayout->addLayout(sliderLayout);
     layout->addWidget(timeScaleGroup);
 
+    // Kraftberechnung: direkte Paarsumme oder Barnes-Hut-Baum
+    auto *solverGroup = new QGroupBox("Kraftberechnung", this);
+    auto *solverForm = new QFormLayout(solverGroup);
+    solverForm->setLabelAlignment(Qt::AlignLeft);
+    solverForm->setFormAlignment(Qt::AlignTop);
+
+    forceSolverCombo = new QComboBox(solverGroup);
+    forceSolverCombo->addItem("Direkt (N²)");
+    forceSolverCombo->addItem("Barnes-Hut");
+
+    auto *angleValidator = new QDoubleValidator(0.0, 2.0, 3, this);
+    angleValidator->setLocale(QLocale::c());
+
+    openingAngleEdit = new QLineEdit(solverGroup);
+    openingAngleEdit->setText("0.5");
+    openingAngleEdit->setPlaceholderText("z. B. 0.5");
+    openingAngleEdit->setValidator(angleValidator);
+    openingAngleEdit->setEnabled(false);
+
+    threadCountEdit = new QLineEdit(solverGroup);
+    threadCountEdit->setText("0");
+    threadCountEdit->setPlaceholderText("0 = alle Kerne");
+    threadCountEdit->setValidator(new QIntValidator(0, 256, threadCountEdit));
+
+    solverForm->addRow("Verfahren", forceSolverCombo);
+    solverForm->addRow("Öffnungswinkel", openingAngleEdit);
+    // Reihenfolge entspricht SimulationCore::Integrator
+    integratorCombo = new QComboBox(solverGroup);
+    integratorCombo->addItem("Euler (semi-implizit)");
+    integratorCombo->addItem("Leapfrog");
+    integratorCombo->addItem("Yoshida (4. Ordnung)");
+    integratorCombo->addItem("Runge-Kutta 4");
+    integratorCombo->addItem("Block-Leapfrog (adaptiv)");
+    integratorCombo->setCurrentIndex(1);
+
+    // Reihenfolge entspricht SimulationCore::Precision
+    precisionCombo = new QComboBox(solverGroup);
+    precisionCombo->addItem("float");
+    precisionCombo->addItem("gemischt (double-Arithmetik)");
+    precisionCombo->addItem("double");
+    precisionCombo->setToolTip("Rechengenauigkeit der Integration; double fuer lange, genaue Laeufe");
+
+    integratorReportButton = new QPushButton("Integrator-Bericht", solverGroup);
+
+    solverForm->addRow("Threads", threadCountEdit);
+    solverForm->addRow("Integrator", integratorCombo);
+    solverForm->addRow("Genauigkeit", precisionCombo);
+    solverForm->addRow(integratorReportButton);
+
+    // Reihenfolge entspricht SimulationCore::CollisionMode
+    collisionModeCombo = new QComboBox(solverGroup);
+    collisionModeCombo->addItem("Elastisch");
+    collisionModeCombo->addItem("Verschmelzen");
+    collisionModeCombo->setToolTip("Beim Verschmelzen nimmt der schwerere Marker den leichteren auf "
+                                   "(Masse und Drehimpuls bleiben erhalten)");
+    solverForm->addRow("Kollisionen", collisionModeCombo);
+    layout->addWidget(solverGroup);
+
+    // Darstellung: ab dieser Markeranzahl ein instanzierter Draw-Call statt einer Entity pro Marker
+    auto *renderGroup = new QGroupBox("Darstellung", this);
+    auto *renderForm = new QFormLayout(renderGroup);
+    renderForm->setLabelAlignment(Qt::AlignLeft);
+    renderForm->setFormAlignment(Qt::AlignTop);
+
+    instancingThresholdEdit = new QLineEdit(renderGroup);
+    instancingThresholdEdit->setText("500");
+    instancingThresholdEdit->setPlaceholderText("0 = immer instanziert");
+    instancingThresholdEdit->setValidator(new QIntValidator(0, 1000000, instancingThresholdEdit));
+
+    renderForm->addRow("Instanzierung ab", instancingThresholdEdit);
+
+    // Frame-Profiler: Overlay mit p50/p99 je Phase und Trace-Export
+    profilerCheckBox = new QCheckBox("Frame-Profiler anzeigen", renderGroup);
+    renderForm->addRow(profilerCheckBox);
+
+    traceExportButton = new QPushButton("Chrome-Trace exportieren", renderGroup);
+    traceExportButton->setEnabled(false);
+    renderForm->addRow(traceExportButton);
+
+    layout->addWidget(renderGroup);
+
     layout->addStretch(1);
 
     connect(generateButton, &QPushButton::clicked, this, &MarkerSettingsPanel::emitGenerate);
+    connect(distributionCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        const auto distribution = static_cast<MarkerGenerator::Distribution>(index);
+        spreadEdit->setEnabled(distribution != MarkerGenerator::Distribution::Uniform);
+        clusterCountEdit->setEnabled(distribution == MarkerGenerator::Distribution::Clustered);
+    });
+    connect(randomSeedButton, &QPushButton::clicked, this, [this]() {
+        seedEdit->setText(QString::number(QRandomGenerator::global()->generate64()));
+    });
     connect(toggleAnimationButton, &QPushButton::toggled, this, [this](bool checked) {
         toggleAnimationButton->setText(checked ? "Animation stoppen" : "Animation starten");
         emit animationToggled(checked);
@@ -126,10 +260,48 @@ MarkerSettingsPanel::MarkerSettingsPanel(QWidget *parent)
     connect(zoomInButton, &QPushButton::clicked, this, &MarkerSettingsPanel::zoomInRequested);
     connect(zoomOutButton, &QPushButton::clicked, this, &MarkerSettingsPanel::zoomOutRequested);
     connect(timeScaleSlider, &QSlider::valueChanged, this, [this](int value) {
-        // Konvertiere von 10-50 zu 0.1-5.0
-        float scale = value / 10.0f;
+        // Konvertiere von 0-60 zu 0.1-100 (logarithmisch)
+        const float scale = qPow(10.0f, value / 20.0f - 1.0f);
+        timeScaleSlider->setToolTip(QString("%1x").arg(scale, 0, 'g', 3));
         emit timeScaleChanged(scale);
     });
+    connect(forceSolverCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        openingAngleEdit->setEnabled(index == 1);
+        emit forceSolverChanged(index);
+    });
+    connect(openingAngleEdit, &QLineEdit::editingFinished, this, [this]() {
+        bool ok = false;
+        const float angle = openingAngleEdit->text().toFloat(&ok);
+        if (ok) {
+            emit openingAngleChanged(angle);
+        }
+    });
+    connect(threadCountEdit, &QLineEdit::editingFinished, this, [this]() {
+        bool ok = false;
+        const int threads = threadCountEdit->text().toInt(&ok);
+        if (ok) {
+            emit threadCountChanged(threads);
+        }
+    });
+    connect(integratorCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &MarkerSettingsPanel::integratorChanged);
+    connect(precisionCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &MarkerSettingsPanel::precisionChanged);
+    connect(integratorReportButton, &QPushButton::clicked, this, &MarkerSettingsPanel::integratorReportRequested);
+    connect(collisionModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &MarkerSettingsPanel::collisionModeChanged);
+    connect(instancingThresholdEdit, &QLineEdit::editingFinished, this, [this]() {
+        bool ok = false;
+        const int markers = instancingThresholdEdit->text().toInt(&ok);
+        if (ok) {
+            emit instancingThresholdChanged(markers);
+        }
+    });
+    connect(profilerCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        traceExportButton->setEnabled(checked);
+        emit profilerToggled(checked);
+    });
+    connect(traceExportButton, &QPushButton::clicked, this, &MarkerSettingsPanel::traceExportRequested);
     
     // Initial time scale setzen
     emit timeScaleChanged(2.5f);
@@ -151,5 +323,30 @@ void MarkerSettingsPanel::emitGenerate()
         return;
     }
 
-    emit generateRequested(count, speed, size, density);
+    MarkerGenerator::Settings settings;
+    settings.count = count;
+    settings.speed = speed;
+    settings.size = size;
+    settings.density = density;
+    settings.distribution = static_cast<MarkerGenerator::Distribution>(distributionCombo->currentIndex());
+
+    bool ok = false;
+    const quint64 seed = seedEdit->text().toULongLong(&ok);
+    if (ok) {
+        settings.seed = seed;
+    }
+    const float spreadDeg = spreadEdit->text().toFloat(&ok);
+    if (ok) {
+        settings.spread = qDegreesToRadians(spreadDeg);
+    }
+    const int clusters = clusterCountEdit->text().toInt(&ok);
+    if (ok) {
+        settings.clusterCount = clusters;
+    }
+    const float dispersion = velocityDispersionEdit->text().toFloat(&ok);
+    if (ok) {
+        settings.velocityDispersion = dispersion;
+    }
+
+    emit generateRequested(settings);
 }
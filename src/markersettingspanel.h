@@ -3,6 +3,10 @@
 
 #include <QWidget>
 
+#include "markergenerator.h"
+
+class QCheckBox;
+class QComboBox;
 class QLineEdit;
 class QPushButton;
 class QSlider;
@@ -11,8 +15,15 @@ class QSlider;
  * @brief MarkerSettingsPanel - Steuerung fuer Marker-Generierung und Szenarios-Verwaltung
  * 
  * Verantwortlichkeiten:
- * - Eingabeformulare fuer Marker-Generierungsparameter (Anzahl, Geschwindigkeit, Groesse, Dichte)
+ * - Eingabeformulare fuer Marker-Generierungsparameter (Anzahl, Geschwindigkeit, Groesse, Dichte,
+ *   Verteilung, Streuung, Seed)
  * - Steuerknoepfe fuer Animation, Szenarios-Verwaltung (Speichern/Laden) und Zoom
+ * - Auswahl des Kraftberechnungsverfahrens (direkt oder Barnes-Hut), des Oeffnungswinkels und der Thread-Anzahl
+ * - Auswahl des Integrators, seiner Rechengenauigkeit und Anforderung des Integrator-Berichts
+ *   (Energiefehler gegen Rechenzeit)
+ * - Auswahl des Kollisionsverhaltens (elastisch oder Verschmelzen)
+ * - Schwelle fuer das instanzierte Zeichnen der Marker
+ * - Ein-/Ausschalten des Frame-Profilers und Export des Chrome-Traces
  * - Emission von Signalen bei Benutzerinteraktionen
  * - Verwaltung des Animationsstatus und der UI-Zustandsaenderungen
  */
@@ -23,7 +34,7 @@ public:
     explicit MarkerSettingsPanel(QWidget *parent = nullptr);
 
 signals:
-    void generateRequested(int count, float speed, float size, float density);
+    void generateRequested(const MarkerGenerator::Settings &settings);
     void animationToggled(bool running);
     void saveRequested();
     void loadRequested();
@@ -31,6 +42,16 @@ signals:
     void zoomInRequested();
     void zoomOutRequested();
     void timeScaleChanged(float scale);
+    void forceSolverChanged(int solver);
+    void openingAngleChanged(float angle);
+    void threadCountChanged(int threads);
+    void integratorChanged(int integrator);
+    void precisionChanged(int precision);
+    void integratorReportRequested();
+    void collisionModeChanged(int mode);
+    void instancingThresholdChanged(int markers);
+    void profilerToggled(bool enabled);
+    void traceExportRequested();
 
 private:
     void emitGenerate();
@@ -39,6 +60,12 @@ private:
     QLineEdit *speedEdit;
     QLineEdit *sizeEdit;
     QLineEdit *densityEdit;
+    QComboBox *distributionCombo;
+    QLineEdit *spreadEdit;
+    QLineEdit *clusterCountEdit;
+    QLineEdit *velocityDispersionEdit;
+    QLineEdit *seedEdit;
+    QPushButton *randomSeedButton;
     QPushButton *generateButton;
     QPushButton *toggleAnimationButton;
     QPushButton *saveButton;
@@ -47,6 +74,16 @@ private:
     QPushButton *zoomInButton;
     QPushButton *zoomOutButton;
     QSlider *timeScaleSlider;
+    QComboBox *forceSolverCombo;
+    QLineEdit *openingAngleEdit;
+    QLineEdit *threadCountEdit;
+    QComboBox *integratorCombo;
+    QComboBox *precisionCombo;
+    QPushButton *integratorReportButton;
+    QComboBox *collisionModeCombo;
+    QLineEdit *instancingThresholdEdit;
+    QCheckBox *profilerCheckBox;
+    QPushButton *traceExportButton;
 };
 
 #endif // MARKERSETTINGSPANEL_H
@@ -0,0 +1,88 @@
+#ifndef MARKERSTATEVIEW_H
+#define MARKERSTATEVIEW_H
+
+#include <QtGlobal>
+#include <algorithm>
+
+#include "simulationsnapshot.h"
+#include "spheremath.h"
+
+/**
+ * @brief ColumnView - Nur lesender, nicht besitzender Blick auf eine zusammenhaengende Spalte
+ */
+template <typename T>
+class ColumnView {
+public:
+    ColumnView(const T *data, int size) : ptr(data), count(size) {}
+
+    const T *data() const { return ptr; }
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    const T &operator[](int index) const { return ptr[index]; }
+    const T *begin() const { return ptr; }
+    const T *end() const { return ptr + count; }
+
+private:
+    const T *ptr;
+    int count;
+};
+
+/**
+ * @brief MarkerStateView - Kopierfreier Lesezugriff auf den aktuell angezeigten Markerzustand
+ *
+ * Verantwortlichkeiten:
+ * - Spaltenweiser Zugriff (ColumnView) und Einzelzugriffe je Index auf einen SimulationSnapshot
+ * - Keine Allokation: der View verweist nur auf den Snapshot
+ * - Gueltig bis zur naechsten Snapshot-Uebernahme im GUI-Thread (also innerhalb eines Event-Handlers);
+ *   der View darf weder gespeichert noch an andere Threads weitergegeben werden
+ */
+class MarkerStateView {
+public:
+    explicit MarkerStateView(const SimulationSnapshot &snapshot) : state(&snapshot) {}
+
+    int size() const { return state->size(); }
+    bool isEmpty() const { return state->size() == 0; }
+    bool contains(int index) const { return index >= 0 && index < state->size(); }
+
+    ColumnView<float> positionsX() const { return column(state->posX); }
+    ColumnView<float> positionsY() const { return column(state->posY); }
+    ColumnView<float> positionsZ() const { return column(state->posZ); }
+    ColumnView<float> velocitiesX() const { return column(state->velX); }
+    ColumnView<float> velocitiesY() const { return column(state->velY); }
+    ColumnView<float> velocitiesZ() const { return column(state->velZ); }
+    ColumnView<float> radii() const { return column(state->radii); }
+    ColumnView<float> densities() const { return column(state->densities); }
+    ColumnView<quint32> colors() const { return column(state->colors); }
+
+    Vec3 position(int index) const { return state->position(index); }
+    Vec3 velocity(int index) const { return state->velocity(index); }
+    float speed(int index) const { return state->velocity(index).length(); }
+    float radius(int index) const { return state->radii[index]; }
+    float density(int index) const { return state->densities[index]; }
+    quint32 color(int index) const { return state->colors[index]; }
+    bool isColliding(int index) const { return state->colliding[index]; }
+    // Stabile Marker-ID; Wiedergabebilder haben keine IDs, dort gilt der Index
+    quint32 id(int index) const { return state->ids.isEmpty() ? quint32(index) : state->ids[index]; }
+    // Index des Markers mit dieser ID oder -1 (lineare Suche)
+    int indexOfId(quint32 markerId) const
+    {
+        if (state->ids.isEmpty()) {
+            return markerId < quint32(state->size()) ? int(markerId) : -1;
+        }
+        const quint32 *begin = state->ids.constData();
+        const quint32 *end = begin + state->ids.size();
+        const quint32 *found = std::find(begin, end, markerId);
+        return found == end ? -1 : int(found - begin);
+    }
+
+    double simulationTime() const { return state->simulationTime; }
+    quint64 stepCount() const { return state->stepCount; }
+
+private:
+    template <typename T>
+    static ColumnView<T> column(const QVector<T> &values) { return ColumnView<T>(values.constData(), static_cast<int>(values.size())); }
+
+    const SimulationSnapshot *state;
+};
+
+#endif // MARKERSTATEVIEW_H
@@ -0,0 +1,282 @@
+#include "recordingpanel.h"
+#include "spherewidget.h"
+#include "trajectoryrecorder.h"
+
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QIntValidator>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSlider>
+#include <QTimer>
+#include <QVBoxLayout>
+
+RecordingPanel::RecordingPanel(SphereWidget *sphereWidget, QWidget *parent)
+    : QWidget(parent),
+      sphereWidget(sphereWidget),
+      sliderUpdating(false),
+      checkpointSliderUpdating(false)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(12);
+
+    // Aufzeichnung
+    auto *recordGroup = new QGroupBox("Aufzeichnung", this);
+    auto *recordForm = new QFormLayout(recordGroup);
+    recordForm->setLabelAlignment(Qt::AlignLeft);
+    recordForm->setFormAlignment(Qt::AlignTop);
+
+    stepIntervalEdit = new QLineEdit(recordGroup);
+    stepIntervalEdit->setText("1");
+    stepIntervalEdit->setValidator(new QIntValidator(1, 1000, stepIntervalEdit));
+    stepIntervalEdit->setToolTip("Jeder k-te Simulationsschritt wird aufgezeichnet");
+    recordForm->addRow("Jeder k-te Schritt:", stepIntervalEdit);
+
+    recordButton = new QPushButton("Aufnahme starten", recordGroup);
+    recordForm->addRow(recordButton);
+
+    recordingStatusLabel = new QLabel("Keine Aufnahme", recordGroup);
+    recordForm->addRow(recordingStatusLabel);
+
+    layout->addWidget(recordGroup);
+
+    // Wiedergabe
+    auto *playbackGroup = new QGroupBox("Wiedergabe", this);
+    auto *playbackLayout = new QVBoxLayout(playbackGroup);
+
+    openPlaybackButton = new QPushButton("Aufzeichnung öffnen", playbackGroup);
+    playbackLayout->addWidget(openPlaybackButton);
+
+    timeSlider = new QSlider(Qt::Horizontal, playbackGroup);
+    timeSlider->setRange(0, sliderSteps);
+    playbackLayout->addWidget(timeSlider);
+
+    playbackTimeLabel = new QLabel(playbackGroup);
+    playbackLayout->addWidget(playbackTimeLabel);
+
+    auto *buttonLayout = new QHBoxLayout();
+    playPauseButton = new QPushButton("Abspielen", playbackGroup);
+    buttonLayout->addWidget(playPauseButton);
+    closePlaybackButton = new QPushButton("Beenden", playbackGroup);
+    buttonLayout->addWidget(closePlaybackButton);
+    playbackLayout->addLayout(buttonLayout);
+
+    layout->addWidget(playbackGroup);
+
+    // Checkpoints der Live-Simulation
+    auto *checkpointGroup = new QGroupBox("Checkpoints", this);
+    auto *checkpointForm = new QFormLayout(checkpointGroup);
+    checkpointForm->setLabelAlignment(Qt::AlignLeft);
+    checkpointForm->setFormAlignment(Qt::AlignTop);
+
+    checkpointBudgetEdit = new QLineEdit(checkpointGroup);
+    checkpointBudgetEdit->setText(QString::number(CheckpointStore::Options().memoryBudget >> 20));
+    checkpointBudgetEdit->setValidator(new QIntValidator(0, 65536, checkpointBudgetEdit));
+    checkpointBudgetEdit->setToolTip("Speicher für Checkpoints; ältere werden ausgedünnt, 0 schaltet sie ab");
+    checkpointForm->addRow("Budget (MB):", checkpointBudgetEdit);
+
+    checkpointSlider = new QSlider(Qt::Horizontal, checkpointGroup);
+    checkpointSlider->setRange(0, sliderSteps);
+    checkpointSlider->setToolTip("Zurücksetzen auf einen früheren Schritt; danach laufen die aufgezeichneten "
+                                 "Schritte bitgleich nach, bis eine Änderung sie verwirft");
+    checkpointForm->addRow(checkpointSlider);
+
+    checkpointStatusLabel = new QLabel(checkpointGroup);
+    checkpointForm->addRow(checkpointStatusLabel);
+
+    layout->addWidget(checkpointGroup);
+    layout->addStretch(1);
+
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(500);
+
+    connect(recordButton, &QPushButton::clicked, this, &RecordingPanel::toggleRecording);
+    connect(statusTimer, &QTimer::timeout, this, &RecordingPanel::updateRecordingStatus);
+    connect(openPlaybackButton, &QPushButton::clicked, this, &RecordingPanel::openPlayback);
+    connect(playPauseButton, &QPushButton::clicked, this, [this]() {
+        this->sphereWidget->setPlaybackRunning(!this->sphereWidget->isPlaybackRunning());
+        playPauseButton->setText(this->sphereWidget->isPlaybackRunning() ? "Pause" : "Abspielen");
+    });
+    connect(closePlaybackButton, &QPushButton::clicked, this, [this]() {
+        this->sphereWidget->stopPlayback();
+    });
+    connect(timeSlider, &QSlider::valueChanged, this, [this](int value) {
+        if (sliderUpdating) {
+            return;
+        }
+        const double start = this->sphereWidget->playbackStartTime();
+        const double end = this->sphereWidget->playbackEndTime();
+        this->sphereWidget->seekPlayback(start + (end - start) * value / sliderSteps);
+    });
+    connect(sphereWidget, &SphereWidget::playbackStateChanged, this, &RecordingPanel::onPlaybackStateChanged);
+    connect(sphereWidget, &SphereWidget::playbackTimeChanged, this, &RecordingPanel::onPlaybackTimeChanged);
+
+    checkpointTimer = new QTimer(this);
+    checkpointTimer->setInterval(250);
+    connect(checkpointTimer, &QTimer::timeout, this, &RecordingPanel::updateCheckpointStatus);
+    connect(checkpointBudgetEdit, &QLineEdit::editingFinished, this, &RecordingPanel::applyCheckpointBudget);
+    // Beim Ziehen erst nach dem Loslassen zuruecksetzen (jeder Sprung wiederholt bis zu einem Intervall Schritte)
+    connect(checkpointSlider, &QSlider::sliderReleased, this, &RecordingPanel::seekCheckpoint);
+    connect(checkpointSlider, &QSlider::valueChanged, this, [this]() {
+        if (!checkpointSliderUpdating && !checkpointSlider->isSliderDown()) {
+            seekCheckpoint();
+        }
+    });
+    checkpointTimer->start();
+
+    onPlaybackStateChanged(sphereWidget->isPlaybackActive());
+    updateCheckpointStatus();
+}
+
+void RecordingPanel::toggleRecording()
+{
+    if (sphereWidget->isRecording()) {
+        sphereWidget->stopRecording();
+        statusTimer->stop();
+        recordButton->setText("Aufnahme starten");
+        stepIntervalEdit->setEnabled(true);
+        recordingStatusLabel->setText(recordingStatusLabel->text() + " (beendet)");
+        return;
+    }
+
+    QString path = QFileDialog::getSaveFileName(this, "Aufnahme speichern", {}, "Gravity Trajektorie (*.grvt)");
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!path.endsWith(".grvt", Qt::CaseInsensitive)) {
+        path += ".grvt";
+    }
+
+    QString error;
+    if (!sphereWidget->startRecording(path, stepIntervalEdit->text().toInt(), &error)) {
+        QMessageBox::warning(this, "Aufnahme starten", error);
+        return;
+    }
+    recordButton->setText("Aufnahme stoppen");
+    stepIntervalEdit->setEnabled(false);
+    statusTimer->start();
+    updateRecordingStatus();
+}
+
+void RecordingPanel::updateRecordingStatus()
+{
+    const TrajectoryRecorder *recorder = sphereWidget->trajectoryRecorder();
+    if (!recorder) {
+        // Aufnahme wurde z. B. durch das Oeffnen einer Wiedergabe beendet
+        statusTimer->stop();
+        recordButton->setText("Aufnahme starten");
+        stepIntervalEdit->setEnabled(true);
+        return;
+    }
+
+    QString status = QString("%1 Bilder, %2 MB")
+                         .arg(recorder->framesWritten())
+                         .arg(recorder->bytesWritten() / (1024.0 * 1024.0), 0, 'f', 1);
+    if (recorder->framesDropped() > 0) {
+        status += QString(", %1 verworfen").arg(recorder->framesDropped());
+    }
+    if (recorder->hasError()) {
+        // Die Datei endet mit dem letzten vollstaendigen Bild; alles danach fehlt
+        status = QString("Schreibfehler: %1, Aufzeichnung unvollständig (%2)").arg(recorder->errorString(), status);
+    }
+    recordingStatusLabel->setText(status);
+}
+
+void RecordingPanel::openPlayback()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Aufzeichnung öffnen", {}, "Gravity Trajektorie (*.grvt)");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    if (!sphereWidget->startPlayback(path, &error)) {
+        QMessageBox::warning(this, "Aufzeichnung öffnen", error);
+        return;
+    }
+    updateRecordingStatus();
+}
+
+void RecordingPanel::onPlaybackStateChanged(bool active)
+{
+    timeSlider->setEnabled(active);
+    playPauseButton->setEnabled(active);
+    closePlaybackButton->setEnabled(active);
+    playPauseButton->setText("Abspielen");
+    if (!active) {
+        sliderUpdating = true;
+        timeSlider->setValue(0);
+        sliderUpdating = false;
+        playbackTimeLabel->setText("Keine Wiedergabe");
+    }
+}
+
+void RecordingPanel::onPlaybackTimeChanged(double time)
+{
+    const double start = sphereWidget->playbackStartTime();
+    const double end = sphereWidget->playbackEndTime();
+    const double span = end - start;
+
+    sliderUpdating = true;
+    timeSlider->setValue(span > 0.0 ? qRound((time - start) / span * sliderSteps) : 0);
+    sliderUpdating = false;
+
+    playbackTimeLabel->setText(QString("t = %1 s / %2 s").arg(time, 0, 'f', 2).arg(end, 0, 'f', 2));
+    if (!sphereWidget->isPlaybackRunning()) {
+        playPauseButton->setText("Abspielen");
+    }
+}
+
+void RecordingPanel::applyCheckpointBudget()
+{
+    sphereWidget->setCheckpointBudget(qint64(checkpointBudgetEdit->text().toInt()) << 20);
+}
+
+void RecordingPanel::updateCheckpointStatus()
+{
+    const SimulationSnapshot::CheckpointRange &range = sphereWidget->checkpointRange();
+    const bool available = range.count > 0 && !sphereWidget->isRecording() && !sphereWidget->isPlaybackActive();
+    checkpointSlider->setEnabled(available && range.lastStep > range.firstStep);
+    if (range.count == 0) {
+        checkpointStatusLabel->setText("Keine Checkpoints");
+        return;
+    }
+
+    if (!checkpointSlider->isSliderDown()) {
+        const quint64 span = range.lastStep - range.firstStep;
+        const quint64 step = qBound(range.firstStep, sphereWidget->simulationStep(), range.lastStep);
+        checkpointSliderUpdating = true;
+        checkpointSlider->setValue(span > 0 ? int((step - range.firstStep) * sliderSteps / span) : sliderSteps);
+        checkpointSliderUpdating = false;
+    }
+
+    QString status = QString("t = %1 s, abgedeckt %2 s bis %3 s\n%4 Checkpoints, %5 MB")
+                         .arg(sphereWidget->simulationTime(), 0, 'f', 2)
+                         .arg(range.firstTime, 0, 'f', 2)
+                         .arg(range.lastTime, 0, 'f', 2)
+                         .arg(range.count)
+                         .arg(range.bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    if (range.replaying) {
+        status += ", Wiederholung";
+    }
+    checkpointStatusLabel->setText(status);
+}
+
+void RecordingPanel::seekCheckpoint()
+{
+    const SimulationSnapshot::CheckpointRange range = sphereWidget->checkpointRange();
+    if (range.count == 0 || !checkpointSlider->isEnabled()) {
+        return;
+    }
+    const quint64 span = range.lastStep - range.firstStep;
+    const quint64 step = range.firstStep + span * quint64(checkpointSlider->value()) / sliderSteps;
+    if (!sphereWidget->seekCheckpoint(step)) {
+        QMessageBox::warning(this, "Checkpoint", "Zurücksetzen ist während Aufnahme und Wiedergabe nicht möglich.");
+    }
+    updateCheckpointStatus();
+}
@@ -0,0 +1,61 @@
+#ifndef RECORDINGPANEL_H
+#define RECORDINGPANEL_H
+
+#include <QWidget>
+
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSlider;
+class QTimer;
+class SphereWidget;
+
+/**
+ * @brief RecordingPanel - Steuert Trajektorien-Aufzeichnung und Wiedergabe
+ *
+ * Verantwortlichkeiten:
+ * - Starten und Stoppen der Aufzeichnung in eine .grvt-Datei mit waehlbarem Schrittintervall
+ * - Anzeige des Aufnahmefortschritts (Bilder, Dateigroesse, verworfene Bilder)
+ * - Oeffnen einer Aufzeichnung, Abspielen/Pausieren und Spulen ueber einen Zeitschieber
+ * - Checkpoints der Live-Simulation: Speicherbudget, Zuruecksetzen ueber einen Schieber im abgedeckten Bereich
+ */
+class RecordingPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit RecordingPanel(SphereWidget *sphereWidget, QWidget *parent = nullptr);
+
+private slots:
+    void toggleRecording();
+    void openPlayback();
+    void updateRecordingStatus();
+    void onPlaybackStateChanged(bool active);
+    void onPlaybackTimeChanged(double time);
+    void applyCheckpointBudget();
+    void updateCheckpointStatus();
+    void seekCheckpoint();
+
+private:
+    static constexpr int sliderSteps = 1000;
+
+    SphereWidget *sphereWidget;
+    QLineEdit *stepIntervalEdit;
+    QPushButton *recordButton;
+    QLabel *recordingStatusLabel;
+    QTimer *statusTimer;
+
+    QPushButton *openPlaybackButton;
+    QPushButton *playPauseButton;
+    QPushButton *closePlaybackButton;
+    QSlider *timeSlider;
+    QLabel *playbackTimeLabel;
+    bool sliderUpdating;
+
+    QLineEdit *checkpointBudgetEdit;
+    QSlider *checkpointSlider;
+    QLabel *checkpointStatusLabel;
+    QTimer *checkpointTimer;
+    bool checkpointSliderUpdating;
+};
+
+#endif // RECORDINGPANEL_H
@@ -0,0 +1,299 @@
+#include "scenariofile.h"
+#include "simulationcore.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QVector>
+#include <QtEndian>
+#include <QtNumeric>
+#include <cstring>
+#include <limits>
+
+namespace ScenarioFile {
+
+namespace {
+constexpr char magic[4] = {'G', 'R', 'V', 'B'};
+constexpr quint32 headerSize = 64;
+constexpr quint32 columnCount = 9;
+constexpr quint32 flagAnimationEnabled = 0x1;
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+// Jede Zeile braucht endliche Werte, eine Position ungleich 0 (wird beim Import normiert) und einen positiven Radius;
+// geprueft wird vor dem Import, damit der Kern bei einem Fehler unveraendert bleibt
+bool validateColumns(const SimulationCore::ColumnData &columns, int count, QString *error)
+{
+    for (int i = 0; i < count; ++i) {
+        const float values[8] = {columns.posX[i], columns.posY[i], columns.posZ[i],
+                                 columns.velX[i], columns.velY[i], columns.velZ[i],
+                                 columns.radii[i], columns.densities[i]};
+        for (float value : values) {
+            if (!qIsFinite(value)) {
+                setError(error, QString("Marker %1: ungueltiger Wert (NaN oder unendlich)").arg(i));
+                return false;
+            }
+        }
+        const float lengthSquared = values[0] * values[0] + values[1] * values[1] + values[2] * values[2];
+        if (!(lengthSquared > 0.0f) || !qIsFinite(lengthSquared)) {
+            setError(error, QString("Marker %1: Position liegt nicht auf der Kugel").arg(i));
+            return false;
+        }
+        if (!(values[6] > 0.0f)) {
+            setError(error, QString("Marker %1: Radius muss groesser als 0 sein").arg(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+T readLittle(const uchar *data, int offset)
+{
+    return qFromLittleEndian<T>(data + offset);
+}
+
+template <typename T>
+void writeLittle(uchar *data, int offset, T value)
+{
+    qToLittleEndian<T>(value, data + offset);
+}
+
+// Schreibt eine Spalte als Little-Endian; auf Little-Endian-Systemen ohne Zwischenkopie
+template <typename T>
+bool writeColumn(QFile &file, const T *values, int count)
+{
+    const qint64 bytes = qint64(count) * sizeof(T);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return file.write(reinterpret_cast<const char *>(values), bytes) == bytes;
+#else
+    QByteArray buffer(bytes, Qt::Uninitialized);
+    qToLittleEndian<T>(values, count, buffer.data());
+    return file.write(buffer) == bytes;
+#endif
+}
+}
+
+Format formatForPath(const QString &path)
+{
+    return QFileInfo(path).suffix().compare("grvb", Qt::CaseInsensitive) == 0 ? Format::Binary : Format::Json;
+}
+
+bool readJson(const QString &path, QJsonObject &scenario, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(error, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        setError(error, parseError.errorString());
+        return false;
+    }
+
+    scenario = doc.object();
+    return true;
+}
+
+bool writeJson(const QString &path, const QJsonObject &scenario, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(error, file.errorString());
+        return false;
+    }
+
+    const QJsonDocument doc(scenario);
+    const QByteArray data = doc.toJson(QJsonDocument::Indented);
+    if (file.write(data) != data.size()) {
+        setError(error, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool readBinary(const QString &path, SimulationCore &core, bool *animationEnabled, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(error, file.errorString());
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    if (fileSize < headerSize) {
+        setError(error, "Datei zu kurz fuer einen .grvb-Kopf");
+        return false;
+    }
+
+    const uchar *data = file.map(0, fileSize);
+    if (!data) {
+        setError(error, file.errorString());
+        return false;
+    }
+
+    if (std::memcmp(data, magic, sizeof(magic)) != 0) {
+        setError(error, "Keine .grvb-Datei");
+        return false;
+    }
+
+    const quint32 version = readLittle<quint32>(data, 4);
+    const quint32 columnsOffset = readLittle<quint32>(data, 8);
+    const quint32 flags = readLittle<quint32>(data, 12);
+    const quint64 markerCount = readLittle<quint64>(data, 16);
+    const float sphereRadius = readLittle<float>(data, 24);
+    const quint32 columns = readLittle<quint32>(data, 28);
+
+    if (version != binaryVersion || columns != columnCount || columnsOffset < headerSize || columnsOffset % 4 != 0) {
+        setError(error, QString("Nicht unterstuetzte .grvb-Version %1").arg(version));
+        return false;
+    }
+
+    // Positionen sind Einheitsvektoren; ein anderer Kugelradius wuerde beim Import stillschweigend verloren gehen
+    if (!(qAbs(sphereRadius - SimulationCore::sphereRadius) <= 1e-6f)) {
+        setError(error, QString("Nicht unterstuetzter Kugelradius %1 (erwartet %2)")
+                            .arg(sphereRadius).arg(SimulationCore::sphereRadius));
+        return false;
+    }
+
+    const quint64 columnBytes = markerCount * sizeof(float);
+    if (markerCount > quint64(std::numeric_limits<int>::max())
+        || quint64(fileSize) < columnsOffset + columnBytes * columnCount) {
+        setError(error, "Unvollstaendige .grvb-Datei");
+        return false;
+    }
+
+    const int count = static_cast<int>(markerCount);
+    const uchar *column = data + columnsOffset;
+    auto nextColumn = [&column, columnBytes]() {
+        const uchar *current = column;
+        column += columnBytes;
+        return current;
+    };
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // Spalten liegen bereits im Speicherformat vor und werden direkt aus der Abbildung kopiert
+    SimulationCore::ColumnData source;
+    source.posX = reinterpret_cast<const float *>(nextColumn());
+    source.posY = reinterpret_cast<const float *>(nextColumn());
+    source.posZ = reinterpret_cast<const float *>(nextColumn());
+    source.velX = reinterpret_cast<const float *>(nextColumn());
+    source.velY = reinterpret_cast<const float *>(nextColumn());
+    source.velZ = reinterpret_cast<const float *>(nextColumn());
+    source.radii = reinterpret_cast<const float *>(nextColumn());
+    source.densities = reinterpret_cast<const float *>(nextColumn());
+    source.colors = reinterpret_cast<const quint32 *>(nextColumn());
+    if (!validateColumns(source, count, error)) {
+        return false;
+    }
+    core.assignColumns(count, source);
+#else
+    QVector<float> floats[8];
+    for (QVector<float> &target : floats) {
+        target.resize(count);
+        qFromLittleEndian<float>(nextColumn(), count, target.data());
+    }
+    QVector<quint32> colors(count);
+    qFromLittleEndian<quint32>(nextColumn(), count, colors.data());
+
+    SimulationCore::ColumnData source{floats[0].constData(), floats[1].constData(), floats[2].constData(),
+                                      floats[3].constData(), floats[4].constData(), floats[5].constData(),
+                                      floats[6].constData(), floats[7].constData(), colors.constData()};
+    if (!validateColumns(source, count, error)) {
+        return false;
+    }
+    core.assignColumns(count, source);
+#endif
+
+    if (animationEnabled) {
+        *animationEnabled = (flags & flagAnimationEnabled) != 0;
+    }
+    return true;
+}
+
+bool writeBinary(const QString &path, const SimulationCore &core, bool animationEnabled, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(error, file.errorString());
+        return false;
+    }
+
+    uchar header[headerSize];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, magic, sizeof(magic));
+    writeLittle<quint32>(header, 4, binaryVersion);
+    writeLittle<quint32>(header, 8, headerSize);
+    writeLittle<quint32>(header, 12, animationEnabled ? flagAnimationEnabled : 0u);
+    writeLittle<quint64>(header, 16, quint64(core.size()));
+    writeLittle<float>(header, 24, SimulationCore::sphereRadius);
+    writeLittle<quint32>(header, 28, columnCount);
+
+    const int n = core.size();
+    const bool ok = file.write(reinterpret_cast<const char *>(header), headerSize) == headerSize
+        && writeColumn(file, core.positionsX(), n)
+        && writeColumn(file, core.positionsY(), n)
+        && writeColumn(file, core.positionsZ(), n)
+        && writeColumn(file, core.velocitiesX(), n)
+        && writeColumn(file, core.velocitiesY(), n)
+        && writeColumn(file, core.velocitiesZ(), n)
+        && writeColumn(file, core.radiusData(), n)
+        && writeColumn(file, core.densityData(), n)
+        && writeColumn(file, core.colorData(), n);
+
+    if (!ok) {
+        setError(error, file.errorString());
+    }
+    return ok;
+}
+
+bool load(const QString &path, SimulationCore &core, bool *animationEnabled, QString *error)
+{
+    if (formatForPath(path) == Format::Binary) {
+        return readBinary(path, core, animationEnabled, error);
+    }
+
+    QJsonObject scenario;
+    if (!readJson(path, scenario, error)) {
+        return false;
+    }
+    if (!core.applyScenario(scenario)) {
+        setError(error, "Szenario enthaelt kein Marker-Array");
+        return false;
+    }
+    if (animationEnabled) {
+        *animationEnabled = scenario["animationEnabled"].toBool(true);
+    }
+    return true;
+}
+
+bool save(const QString &path, const SimulationCore &core, bool animationEnabled, QString *error)
+{
+    if (formatForPath(path) == Format::Binary) {
+        return writeBinary(path, core, animationEnabled, error);
+    }
+
+    QJsonObject scenario = core.exportScenario();
+    scenario["animationEnabled"] = animationEnabled;
+    return writeJson(path, scenario, error);
+}
+
+bool convert(const QString &inputPath, const QString &outputPath, QString *error)
+{
+    SimulationCore core;
+    bool animationEnabled = true;
+    if (!load(inputPath, core, &animationEnabled, error)) {
+        return false;
+    }
+    return save(outputPath, core, animationEnabled, error);
+}
+
+}
@@ -0,0 +1,56 @@
+#ifndef SCENARIOFILE_H
+#define SCENARIOFILE_H
+
+#include <QJsonObject>
+#include <QString>
+
+class SimulationCore;
+
+/**
+ * @brief ScenarioFile - Lesen und Schreiben von Szenario-Dateien im JSON- (.grv) und Binaerformat (.grvb)
+ *
+ * Verantwortlichkeiten:
+ * - .grv: JSON-Dokument wie bisher (Version, Kugelradius, Marker-Array, Animationsstatus)
+ * - .grvb: 64-Byte-Kopf und gepackte Little-Endian-SoA-Spalten (Position, Geschwindigkeit, Radius, Dichte, Farbe)
+ * - Laden von .grvb ueber QFile::map; die Spalten werden direkt in den SimulationCore kopiert
+ * - .grvb: Kugelradius und jede Zeile (endliche Werte, Position ungleich 0, Radius > 0) werden vor dem Import geprueft
+ * - Konvertierung zwischen beiden Formaten anhand der Dateiendung
+ *
+ * Aufbau von .grvb (Version 1):
+ *   0  char[4]  "GRVB"
+ *   4  quint32  Formatversion
+ *   8  quint32  Kopfgroesse in Bytes (Beginn der Spalten)
+ *  12  quint32  Flags (Bit 0: Animation aktiv)
+ *  16  quint64  Markeranzahl N
+ *  24  float    Kugelradius
+ *  28  quint32  Spaltenanzahl (9)
+ *  32  ...      reserviert (0) bis zur Kopfgroesse
+ *  danach je N Werte: posX, posY, posZ, velX, velY, velZ, radius, density (float32), color (quint32 0xRRGGBB)
+ */
+namespace ScenarioFile {
+
+enum class Format {
+    Json,
+    Binary
+};
+
+constexpr quint32 binaryVersion = 1;
+
+// .grvb -> Binary, alles andere -> Json
+Format formatForPath(const QString &path);
+
+bool readJson(const QString &path, QJsonObject &scenario, QString *error = nullptr);
+bool writeJson(const QString &path, const QJsonObject &scenario, QString *error = nullptr);
+
+bool readBinary(const QString &path, SimulationCore &core, bool *animationEnabled = nullptr, QString *error = nullptr);
+bool writeBinary(const QString &path, const SimulationCore &core, bool animationEnabled, QString *error = nullptr);
+
+// Liest eine Datei beliebigen Formats in den Kern bzw. schreibt ihn im Format der Zieldatei
+bool load(const QString &path, SimulationCore &core, bool *animationEnabled = nullptr, QString *error = nullptr);
+bool save(const QString &path, const SimulationCore &core, bool animationEnabled, QString *error = nullptr);
+
+bool convert(const QString &inputPath, const QString &outputPath, QString *error = nullptr);
+
+}
+
+#endif // SCENARIOFILE_H
@@ -2,11 +2,13 @@
 #include "spherewidget.h"
 
 #include <QFileDialog>
-#include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QMessageBox>
 #include <QWidget>
 
+namespace {
+const char *scenarioFilter = "Gravity Scenario (*.grv *.grvb);;Gravity Scenario JSON (*.grv);;Gravity Scenario binaer (*.grvb)";
+}
+
 ScenarioManager::ScenarioManager(SphereWidget *sphereWidget)
     : sphereWidget(sphereWidget)
 {
@@ -16,8 +18,11 @@ void ScenarioManager::saveScenario(QWidget *parentWidget)
 {
     QFileDialog dialog(parentWidget, "Szenario speichern");
     dialog.setAcceptMode(QFileDialog::AcceptSave);
-    dialog.setNameFilter("Gravity Scenario (*.grv)");
+    dialog.setNameFilter("Gravity Scenario JSON (*.grv);;Gravity Scenario binaer (*.grvb)");
     dialog.setDefaultSuffix("grv");
+    QObject::connect(&dialog, &QFileDialog::filterSelected, &dialog, [&dialog](const QString &filter) {
+        dialog.setDefaultSuffix(filter.contains("*.grvb") ? "grvb" : "grv");
+    });
     if (!dialog.exec()) {
         return;
     }
@@ -26,33 +31,21 @@ void ScenarioManager::saveScenario(QWidget *parentWidget)
         return;
     }
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        return;
+    QString error;
+    if (!sphereWidget->saveScenarioFile(path, &error)) {
+        QMessageBox::warning(parentWidget, "Szenario speichern", QString("Speichern fehlgeschlagen: %1").arg(error));
     }
-
-    const QJsonObject scenario = sphereWidget->exportScenario();
-    const QJsonDocument doc(scenario);
-    file.write(doc.toJson(QJsonDocument::Indented));
 }
 
 void ScenarioManager::loadScenario(QWidget *parentWidget)
 {
-    const QString path = QFileDialog::getOpenFileName(parentWidget, "Szenario laden", {}, "Gravity Scenario (*.grv)");
+    const QString path = QFileDialog::getOpenFileName(parentWidget, "Szenario laden", {}, scenarioFilter);
     if (path.isEmpty()) {
         return;
     }
 
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return;
+    QString error;
+    if (!sphereWidget->loadScenarioFile(path, &error)) {
+        QMessageBox::warning(parentWidget, "Szenario laden", QString("Laden fehlgeschlagen: %1").arg(error));
     }
-
-    const QByteArray data = file.readAll();
-    const QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        return;
-    }
-
-    sphereWidget->applyScenario(doc.object());
 }
@@ -11,8 +11,8 @@ class QWidget;
  * @brief ScenarioManager - Verwaltung von Szenarios-Operationen
  * 
  * Verantwortlichkeiten:
- * - Speichern von Szenarien in JSON-Format (.grv-Dateien)
- * - Laden von gespeicherten Szenarien aus JSON-Dateien
+ * - Speichern von Szenarien im JSON-Format (.grv) oder im Binaerformat (.grvb)
+ * - Laden von gespeicherten Szenarien beider Formate (Dateiformat ueber ScenarioFile)
  * - Bereitstellung von Dateidialog-Interaktionen fuer den Benutzer
  * - Serialisierung und Deserialisierung von Simulations-Szenarien
  */
@@ -0,0 +1,29 @@
+#version 150 core
+
+in vec3 worldPosition;
+in vec3 worldNormal;
+in vec3 instanceColor;
+
+out vec4 fragColor;
+
+uniform vec3 eyePosition;
+uniform vec3 lightPosition;
+uniform float shininess;
+
+void main()
+{
+    // Beidseitig beleuchtet, da die Kappe ohne Backface-Culling gezeichnet wird
+    vec3 n = normalize(worldNormal);
+    vec3 viewDirection = normalize(eyePosition - worldPosition);
+    if (dot(n, viewDirection) < 0.0) {
+        n = -n;
+    }
+
+    vec3 lightDirection = normalize(lightPosition - worldPosition);
+    float diffuse = max(dot(n, lightDirection), 0.0);
+    vec3 reflected = reflect(-lightDirection, n);
+    float specular = diffuse > 0.0 ? pow(max(dot(reflected, viewDirection), 0.0), shininess) : 0.0;
+
+    vec3 color = instanceColor * (0.45 + 0.55 * diffuse) + vec3(0.78) * specular;
+    fragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,55 @@
+#version 150 core
+
+// Einheits-Kappe: (t, cos phi, sin phi, Art) mit t in [0, 1] vom Pol bis zum Rand der Kappe.
+// Art: 0 = Aussenseite, 1 = Innenseite, 2 = Randring aussen, 3 = Randring innen
+in vec4 capParameter;
+
+// Pro Instanz: Orientierung (Quaternion x, y, z, w) und Markerradius aus dem Transformationspuffer,
+// Farbe als normiertes RGBA8 aus dem getrennten Farbpuffer
+in vec4 instanceRotation;
+in float instanceRadius;
+in vec4 instanceRgba;
+
+out vec3 worldPosition;
+out vec3 worldNormal;
+out vec3 instanceColor;
+
+uniform mat4 modelMatrix;
+uniform mat3 modelNormalMatrix;
+uniform mat4 mvp;
+uniform float surfaceRadius;
+
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    // Gleiche Abmessungen wie die Einzel-Marker in SurfaceMarker
+    float markerRadius = max(instanceRadius, 0.0001);
+    float capAngle = min(markerRadius / surfaceRadius, 3.14159265 - 0.01);
+    float renderRadius = surfaceRadius + max(markerRadius * 0.12, 0.02);
+    float innerRadius = max(renderRadius - max(markerRadius * 0.15, 0.01), 0.0001);
+
+    float theta = capAngle * capParameter.x;
+    vec3 direction = vec3(sin(theta) * capParameter.y, cos(theta), sin(theta) * capParameter.z);
+
+    int kind = int(capParameter.w + 0.5);
+    float radius = (kind == 1 || kind == 3) ? innerRadius : renderRadius;
+    vec3 normal = direction;
+    if (kind == 1) {
+        normal = -direction;
+    } else if (kind >= 2) {
+        normal = vec3(capParameter.y, 0.0, capParameter.z);
+    }
+
+    vec3 position = rotateByQuaternion(instanceRotation, direction * radius);
+    normal = rotateByQuaternion(instanceRotation, normal);
+
+    worldPosition = vec3(modelMatrix * vec4(position, 1.0));
+    worldNormal = normalize(modelNormalMatrix * normal);
+    instanceColor = instanceRgba.rgb;
+
+    gl_Position = mvp * vec4(position, 1.0);
+}
@@ -0,0 +1,1779 @@
+#include "simulationcore.h"
+#include "frameprofiler.h"
+
+#include <QJsonArray>
+#include <QPair>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+constexpr float pairEpsilon = 1e-4f; // wie in ForceKernels: nahezu deckungsgleiche/antipodale Paare tragen nicht bei
+const float pairCutoffAngle = std::sqrt(pairEpsilon);
+
+// Yoshida (1990): symmetrische Komposition w1, w0, w1 eines Verfahrens 2. Ordnung ergibt 4. Ordnung
+const double yoshidaW1 = 1.0 / (2.0 - std::cbrt(2.0));
+const double yoshidaW0 = 1.0 - 2.0 * yoshidaW1;
+
+// Kontinuierliche Kollisionen: hoechstens so viele Durchlaeufe (Folgekontakte nach einem Aufprall) je Schritt
+constexpr int maxSweepPasses = 4;
+// Kappen bis zu diesem Vielfachen der mittleren Kappe kommen ins Gitter, groessere werden einzeln geprueft
+constexpr float gridCapFactor = 4.0f;
+constexpr float maxGridContactAngle = 0.5f;
+// Abbruch der konservativen Annaeherung, relativ zum Kontaktabstand
+constexpr float contactTolerance = 1e-3f;
+constexpr int maxAdvancementSteps = 32;
+
+template <typename T>
+void swapRemoveColumn(QVector<T> &column, int index)
+{
+    column[index] = column.last();
+    column.removeLast();
+}
+
+// Winkel zwischen zwei Einheitsvektoren, auch fuer kleine Winkel genau
+float arcBetween(const Vec3 &a, const Vec3 &b)
+{
+    return qAtan2(Vec3::cross(a, b).length(), Vec3::dot(a, b));
+}
+
+// Exakter geodaetischer Fluss: Position und Geschwindigkeit gemeinsam um die Achse pos x vel drehen
+template <typename Real>
+void geodesicFlow(Vec3T<Real> &pos, Vec3T<Real> &vel, Real deltaSeconds)
+{
+    const Real speed = vel.length();
+    if (speed <= Real(1e-6f)) {
+        return;
+    }
+
+    const Vec3T<Real> axis = Vec3T<Real>::cross(pos, vel).normalized();
+    const Real angleRad = speed * deltaSeconds;
+    pos = rotateAroundAxis(pos, axis, angleRad).normalized();
+    vel = rotateAroundAxis(vel, axis, angleRad);
+}
+
+// Rechentyp und Speicherform der Schrittkerne je SimulationCore::Precision
+template <typename RealType, bool WithResiduals>
+struct PrecisionTraits {
+    using Real = RealType;
+    static constexpr bool residuals = WithResiduals;
+};
+
+// Drei Zustandsspalten (Position oder Geschwindigkeit) in der Rechengenauigkeit Real. Mit Restspalten gilt
+// Wert = float + Rest exakt, denn d - float(d) ist fuer jedes double d wieder als double darstellbar.
+// Zeiger werden vor dem parallelen Bereich geholt (siehe integrateAs).
+template <typename Traits>
+struct StateColumns {
+    using Real = typename Traits::Real;
+
+    float *x;
+    float *y;
+    float *z;
+    double *restX;
+    double *restY;
+    double *restZ;
+
+    StateColumns(QVector<float> &columnX, QVector<float> &columnY, QVector<float> &columnZ,
+                 QVector<double> &residualX, QVector<double> &residualY, QVector<double> &residualZ)
+        : x(columnX.data()), y(columnY.data()), z(columnZ.data()),
+          restX(Traits::residuals ? residualX.data() : nullptr),
+          restY(Traits::residuals ? residualY.data() : nullptr),
+          restZ(Traits::residuals ? residualZ.data() : nullptr)
+    {
+    }
+
+    Vec3T<Real> load(int i) const
+    {
+        if constexpr (Traits::residuals) {
+            return Vec3T<Real>(double(x[i]) + restX[i], double(y[i]) + restY[i], double(z[i]) + restZ[i]);
+        } else {
+            return Vec3T<Real>(x[i], y[i], z[i]);
+        }
+    }
+
+    void store(int i, const Vec3T<Real> &value) const
+    {
+        x[i] = float(value.x);
+        y[i] = float(value.y);
+        z[i] = float(value.z);
+        if constexpr (Traits::residuals) {
+            restX[i] = double(value.x) - double(x[i]);
+            restY[i] = double(value.y) - double(y[i]);
+            restZ[i] = double(value.z) - double(z[i]);
+        }
+    }
+};
+
+// Paralleltransport eines Tangentialvektors von from nach to entlang des verbindenden Grosskreises
+Vec3 transportTangent(const Vec3 &v, const Vec3 &from, const Vec3 &to)
+{
+    const Vec3 axis = Vec3::cross(from, to);
+    const float sine = axis.length();
+    if (sine < 1e-7f) {
+        return v - Vec3::dot(v, to) * to;
+    }
+    return rotateAroundAxis(v, axis * (1.0f / sine), qAtan2(sine, Vec3::dot(from, to)));
+}
+}
+
+SimulationCore::SimulationCore()
+    : accelerationsCurrent(false),
+      nextId(0),
+      gravity(10.0f),
+      solver(ForceSolver::BruteForce),
+      theta(0.5f),
+      integratorKind(Integrator::Leapfrog),
+      precisionKind(Precision::Float),
+      maxBlockLevel(8),
+      blockEta(0.1f),
+      evaluatedAccelerations(0),
+      kernelIsa(ForceKernels::detectInstructionSet()),
+      requestedThreads(0),
+      minParallelMarkers(256),
+      continuousCollisionsEnabled(true),
+      sweepPending(false),
+      sweepSeconds(0.0f),
+      sweptContacts(0),
+      collisionKind(CollisionMode::Elastic),
+      merges(0),
+      elasticImpacts(0),
+      structureLogging(false),
+      structureLogBase(0)
+{
+}
+
+void SimulationCore::clear()
+{
+    posX.clear(); posY.clear(); posZ.clear();
+    velX.clear(); velY.clear(); velZ.clear();
+    accX.clear(); accY.clear(); accZ.clear();
+    radii.clear();
+    densities.clear();
+    masses.clear();
+    colors.clear();
+    colliding.clear();
+    ids.clear();
+    resizeResiduals();
+    accelerationsCurrent = false;
+    sweepPending = false;
+    logStructureChange({StructureChange::Reset, 0, 0, -1, invalidMarkerId, invalidMarkerId});
+}
+
+void SimulationCore::reserve(int count)
+{
+    posX.reserve(count); posY.reserve(count); posZ.reserve(count);
+    velX.reserve(count); velY.reserve(count); velZ.reserve(count);
+    accX.reserve(count); accY.reserve(count); accZ.reserve(count);
+    radii.reserve(count);
+    densities.reserve(count);
+    masses.reserve(count);
+    colors.reserve(count);
+    colliding.reserve(count);
+    ids.reserve(count);
+}
+
+int SimulationCore::addMarker(const Vec3 &position, const Vec3 &velocity, float radius, float density, quint32 color)
+{
+    const Vec3 posNorm = position.normalized();
+    posX.append(posNorm.x); posY.append(posNorm.y); posZ.append(posNorm.z);
+    velX.append(velocity.x); velY.append(velocity.y); velZ.append(velocity.z);
+    accX.append(0.0f); accY.append(0.0f); accZ.append(0.0f);
+    radii.append(radius);
+    densities.append(density);
+    masses.append(density * radius * radius * radius);
+    colors.append(color);
+    colliding.append(false);
+    ids.append(nextId++);
+    resizeResiduals();
+    accelerationsCurrent = false;
+    logStructureChange({StructureChange::Append, size() - 1, 1, -1, invalidMarkerId, invalidMarkerId});
+    return size() - 1;
+}
+
+void SimulationCore::removeMarker(int index)
+{
+    if (index < 0 || index >= size()) {
+        return;
+    }
+    swapRemove(index, invalidMarkerId);
+}
+
+void SimulationCore::swapRemove(int index, quint32 mergedInto)
+{
+    const int last = size() - 1;
+    logStructureChange({StructureChange::Remove, index, 0, index == last ? -1 : last, ids[index], mergedInto});
+
+    swapRemoveColumn(posX, index); swapRemoveColumn(posY, index); swapRemoveColumn(posZ, index);
+    swapRemoveColumn(velX, index); swapRemoveColumn(velY, index); swapRemoveColumn(velZ, index);
+    swapRemoveColumn(accX, index); swapRemoveColumn(accY, index); swapRemoveColumn(accZ, index);
+    swapRemoveColumn(radii, index);
+    swapRemoveColumn(densities, index);
+    swapRemoveColumn(masses, index);
+    swapRemoveColumn(colors, index);
+    swapRemoveColumn(colliding, index);
+    swapRemoveColumn(ids, index);
+    if (hasResiduals()) {
+        swapRemoveColumn(posResX, index); swapRemoveColumn(posResY, index); swapRemoveColumn(posResZ, index);
+        swapRemoveColumn(velResX, index); swapRemoveColumn(velResY, index); swapRemoveColumn(velResZ, index);
+    }
+    accelerationsCurrent = false;
+}
+
+void SimulationCore::setStructureLogging(bool enabled)
+{
+    structureLogging = enabled;
+    if (!enabled) {
+        trimStructureLog(structureVersion());
+    }
+}
+
+void SimulationCore::trimStructureLog(quint64 version)
+{
+    const int count = static_cast<int>(qBound<quint64>(0, version - qMin(version, structureLogBase), quint64(structureChanges.size())));
+    if (count > 0) {
+        structureChanges.remove(0, count);
+        structureLogBase += quint64(count);
+    }
+}
+
+void SimulationCore::logStructureChange(const StructureChange &change)
+{
+    if (structureLogging) {
+        structureChanges.append(change);
+    }
+}
+
+void SimulationCore::assignColumns(int count, const ColumnData &columns)
+{
+    clear();
+    count = qMax(0, count);
+
+    auto assign = [count](auto &target, const auto *source) {
+        target.resize(count);
+        std::copy(source, source + count, target.data());
+    };
+    assign(posX, columns.posX);
+    assign(posY, columns.posY);
+    assign(posZ, columns.posZ);
+    assign(velX, columns.velX);
+    assign(velY, columns.velY);
+    assign(velZ, columns.velZ);
+    assign(radii, columns.radii);
+    assign(densities, columns.densities);
+    assign(colors, columns.colors);
+    // Wie addMarker(): Schritt, Kollisionen und Trajektorien-Kodierung setzen Einheitsvektoren voraus
+    for (int i = 0; i < count; ++i) {
+        const Vec3 position = Vec3(posX[i], posY[i], posZ[i]).normalized();
+        posX[i] = position.x;
+        posY[i] = position.y;
+        posZ[i] = position.z;
+    }
+    ids.resize(count);
+    for (int i = 0; i < count; ++i) {
+        ids[i] = nextId++;
+    }
+
+    accX.fill(0.0f, count);
+    accY.fill(0.0f, count);
+    accZ.fill(0.0f, count);
+    colliding.fill(false, count);
+    masses.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const float r = radii[i];
+        masses[i] = densities[i] * r * r * r;
+    }
+    resizeResiduals();
+    logStructureChange({StructureChange::Append, 0, count, -1, invalidMarkerId, invalidMarkerId});
+}
+
+void SimulationCore::generateMarkers(const MarkerGenerator::Settings &settings)
+{
+    if (settings.count <= 0) {
+        return;
+    }
+
+    const MarkerGenerator generator(settings);
+    const int first = size();
+    const int total = first + settings.count;
+
+    // Erst alle Spalten auf die Endgroesse bringen, dann jeder Thread seinen Indexbereich fuellen
+    posX.resize(total); posY.resize(total); posZ.resize(total);
+    velX.resize(total); velY.resize(total); velZ.resize(total);
+    accX.resize(total); accY.resize(total); accZ.resize(total);
+    radii.resize(total);
+    densities.resize(total);
+    masses.resize(total);
+    colors.resize(total);
+    colliding.resize(total);
+    ids.resize(total);
+    for (int i = first; i < total; ++i) {
+        ids[i] = nextId++;
+    }
+    resizeResiduals();
+    accelerationsCurrent = false;
+    logStructureChange({StructureChange::Append, first, settings.count, -1, invalidMarkerId, invalidMarkerId});
+
+    float *px = posX.data() + first;
+    float *py = posY.data() + first;
+    float *pz = posZ.data() + first;
+    float *vx = velX.data() + first;
+    float *vy = velY.data() + first;
+    float *vz = velZ.data() + first;
+    float *ax = accX.data() + first;
+    float *ay = accY.data() + first;
+    float *az = accZ.data() + first;
+    float *r = radii.data() + first;
+    float *d = densities.data() + first;
+    float *m = masses.data() + first;
+    quint32 *c = colors.data() + first;
+    bool *hit = colliding.data() + first;
+    // Strom je Marker-ID statt Index im Stapel: IDs werden nie wiederverwendet, ein zweiter Stapel mit gleichem Seed
+    // liefert daher neue Marker statt deckungsgleicher Kopien (die sich weder stossen noch anziehen wuerden)
+    const quint32 *streams = ids.constData() + first;
+
+    const float radius = settings.size;
+    const float density = settings.density;
+    const float mass = density * radius * radius * radius;
+    const quint32 color = settings.color;
+
+    parallelFor(settings.count, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            Vec3 position;
+            Vec3 velocity;
+            generator.sample(quint64(streams[i]), position, velocity);
+            px[i] = position.x; py[i] = position.y; pz[i] = position.z;
+            vx[i] = velocity.x; vy[i] = velocity.y; vz[i] = velocity.z;
+            ax[i] = 0.0f; ay[i] = 0.0f; az[i] = 0.0f;
+            r[i] = radius;
+            d[i] = density;
+            m[i] = mass;
+            c[i] = color;
+            hit[i] = false;
+        }
+    });
+}
+
+const char *SimulationCore::collisionModeName(CollisionMode mode)
+{
+    switch (mode) {
+    case CollisionMode::Elastic:
+        return "elastic";
+    case CollisionMode::Merge:
+        return "merge";
+    }
+    return "unknown";
+}
+
+bool SimulationCore::parseCollisionMode(const QString &name, CollisionMode &mode)
+{
+    for (auto candidate : {CollisionMode::Elastic, CollisionMode::Merge}) {
+        if (name.compare(collisionModeName(candidate), Qt::CaseInsensitive) == 0) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *SimulationCore::precisionName(Precision precision)
+{
+    switch (precision) {
+    case Precision::Float:
+        return "float";
+    case Precision::Mixed:
+        return "mixed";
+    case Precision::Double:
+        return "double";
+    }
+    return "unknown";
+}
+
+bool SimulationCore::parsePrecision(const QString &name, Precision &precision)
+{
+    for (auto candidate : {Precision::Float, Precision::Mixed, Precision::Double}) {
+        if (name.compare(precisionName(candidate), Qt::CaseInsensitive) == 0) {
+            precision = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimulationCore::setPrecision(Precision value)
+{
+    if (value == precisionKind) {
+        return;
+    }
+    // Restspalten verwerfen bzw. mit Null anlegen: der float-Wert ist der neue exakte Zustand
+    precisionKind = value;
+    posResX.clear(); posResY.clear(); posResZ.clear();
+    velResX.clear(); velResY.clear(); velResZ.clear();
+    resizeResiduals();
+}
+
+void SimulationCore::resizeResiduals()
+{
+    // Neue Marker beginnen ohne Rest, ihr exakter Zustand ist der float-Wert
+    const int count = hasResiduals() ? size() : 0;
+    posResX.resize(count); posResY.resize(count); posResZ.resize(count);
+    velResX.resize(count); velResY.resize(count); velResZ.resize(count);
+}
+
+const char *SimulationCore::integratorName(Integrator integrator)
+{
+    switch (integrator) {
+    case Integrator::Euler:
+        return "euler";
+    case Integrator::Leapfrog:
+        return "leapfrog";
+    case Integrator::Yoshida4:
+        return "yoshida4";
+    case Integrator::RK4:
+        return "rk4";
+    case Integrator::Block:
+        return "block";
+    }
+    return "unknown";
+}
+
+bool SimulationCore::parseIntegrator(const QString &name, Integrator &integrator)
+{
+    for (auto candidate : {Integrator::Euler, Integrator::Leapfrog, Integrator::Yoshida4, Integrator::RK4,
+                           Integrator::Block}) {
+        if (name.compare(integratorName(candidate), Qt::CaseInsensitive) == 0) {
+            integrator = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *SimulationCore::forceSolverName(ForceSolver solver)
+{
+    switch (solver) {
+    case ForceSolver::BruteForce:
+        return "direct";
+    case ForceSolver::BarnesHut:
+        return "barnes-hut";
+    }
+    return "unknown";
+}
+
+bool SimulationCore::parseForceSolver(const QString &name, ForceSolver &solver)
+{
+    for (auto candidate : {ForceSolver::BruteForce, ForceSolver::BarnesHut}) {
+        if (name.compare(forceSolverName(candidate), Qt::CaseInsensitive) == 0) {
+            solver = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+int SimulationCore::forceEvaluationsPerStep(Integrator integrator)
+{
+    switch (integrator) {
+    case Integrator::Yoshida4:
+        return 3;
+    case Integrator::RK4:
+        return 4;
+    case Integrator::Euler:
+    case Integrator::Leapfrog:
+    case Integrator::Block: // Richtwert; tatsaechlich je nach Stufen mehr, siehe accelerationEvaluations()
+    default:
+        return 1;
+    }
+}
+
+void SimulationCore::step(float deltaSeconds)
+{
+    if (deltaSeconds <= 0.0f) {
+        return;
+    }
+
+    advance(deltaSeconds);
+    handleCollisions();
+}
+
+void SimulationCore::advance(float deltaSeconds)
+{
+    if (deltaSeconds <= 0.0f || isEmpty()) {
+        return;
+    }
+
+    FrameProfiler::Scope profile(FrameProfiler::Integration);
+    if (continuousCollisionsEnabled) {
+        sweepX.resize(size());
+        sweepY.resize(size());
+        sweepZ.resize(size());
+        std::copy(posX.cbegin(), posX.cend(), sweepX.begin());
+        std::copy(posY.cbegin(), posY.cend(), sweepY.begin());
+        std::copy(posZ.cbegin(), posZ.cend(), sweepZ.begin());
+        sweepSeconds = deltaSeconds;
+        sweepPending = true;
+    }
+
+    switch (integratorKind) {
+    case Integrator::Leapfrog:
+        leapfrogStep(deltaSeconds);
+        break;
+    case Integrator::Yoshida4:
+        leapfrogStep(yoshidaW1 * deltaSeconds);
+        leapfrogStep(yoshidaW0 * deltaSeconds);
+        leapfrogStep(yoshidaW1 * deltaSeconds);
+        break;
+    case Integrator::RK4:
+        rungeKuttaStep(deltaSeconds);
+        break;
+    case Integrator::Block:
+        blockStep(deltaSeconds);
+        break;
+    case Integrator::Euler:
+    default:
+        computeAccelerations();
+        integrate(deltaSeconds);
+        break;
+    }
+}
+
+void SimulationCore::computeAccelerations()
+{
+    FrameProfiler::Scope profile(FrameProfiler::Force);
+    switch (solver) {
+    case ForceSolver::BarnesHut:
+        computeAccelerationsBarnesHut();
+        break;
+    case ForceSolver::BruteForce:
+    default:
+        computeAccelerationsBruteForce();
+        break;
+    }
+    evaluatedAccelerations += quint64(size());
+    accelerationsCurrent = true;
+}
+
+void SimulationCore::computeAccelerationsFor(const int *indices, int count)
+{
+    if (count == size()) {
+        computeAccelerations();
+        return;
+    }
+
+    // Einzelzeilen gegen alle Partner; die Partner-Schleife bleibt vektorisiert bzw. nutzt den Baum
+    FrameProfiler::Scope profile(FrameProfiler::Force);
+    float *ax = accX.data();
+    float *ay = accY.data();
+    float *az = accZ.data();
+    if (solver == ForceSolver::BarnesHut) {
+        tree.build(posX.constData(), posY.constData(), posZ.constData(), masses.constData(), size());
+        const float openingAngle = theta;
+        parallelFor(count, [&](int begin, int end) {
+            for (int k = begin; k < end; ++k) {
+                tree.computeAccelerations(indices[k], indices[k] + 1, gravity, openingAngle, ax, ay, az);
+            }
+        });
+    } else {
+        const ForceKernels::Input input{posX.constData(), posY.constData(), posZ.constData(),
+                                        masses.constData(), size(), gravity};
+        const ForceKernels::InstructionSet isa = kernelIsa;
+        parallelFor(count, [&](int begin, int end) {
+            for (int k = begin; k < end; ++k) {
+                ForceKernels::accumulateRows(input, indices[k], indices[k] + 1, ax, ay, az, isa);
+            }
+        });
+    }
+    evaluatedAccelerations += quint64(count);
+}
+
+void SimulationCore::computeAccelerationsBarnesHut()
+{
+    const int n = size();
+    tree.build(posX.constData(), posY.constData(), posZ.constData(), masses.constData(), n);
+
+    float *ax = accX.data();
+    float *ay = accY.data();
+    float *az = accZ.data();
+    parallelFor(n, [&](int begin, int end) {
+        tree.computeAccelerations(begin, end, gravity, theta, ax, ay, az);
+    });
+}
+
+void SimulationCore::computeAccelerationsBruteForce()
+{
+    // Jede Zeile vollstaendig gegen alle Partner (keine Symmetrie-Ausnutzung), damit Zeilen
+    // unabhaengig voneinander auf Threads verteilt werden koennen
+    const ForceKernels::Input input{posX.constData(), posY.constData(), posZ.constData(),
+                                    masses.constData(), size(), gravity};
+    float *ax = accX.data();
+    float *ay = accY.data();
+    float *az = accZ.data();
+    const ForceKernels::InstructionSet isa = kernelIsa;
+    parallelFor(size(), [&](int begin, int end) {
+        ForceKernels::accumulateRows(input, begin, end, ax, ay, az, isa);
+    });
+}
+
+void SimulationCore::setThreadCount(int count)
+{
+    requestedThreads = qMax(0, count);
+    if (pool && pool->threadCount() != effectiveThreadCount()) {
+        pool.reset();
+    }
+}
+
+int SimulationCore::effectiveThreadCount() const
+{
+    return requestedThreads > 0 ? requestedThreads : WorkerPool::idealThreadCount();
+}
+
+void SimulationCore::parallelFor(int count, const std::function<void(int, int)> &task)
+{
+    const int threads = effectiveThreadCount();
+    if (threads <= 1 || count < minParallelMarkers) {
+        task(0, count);
+        return;
+    }
+
+    if (!pool) {
+        pool = std::make_shared<WorkerPool>(threads);
+    }
+    pool->run(count, [&task](int begin, int end, int) {
+        task(begin, end);
+    });
+}
+
+template <typename Function>
+void SimulationCore::dispatchPrecision(Function &&function)
+{
+    switch (precisionKind) {
+    case Precision::Double:
+        function(PrecisionTraits<double, true>());
+        break;
+    case Precision::Mixed:
+        function(PrecisionTraits<double, false>());
+        break;
+    case Precision::Float:
+    default:
+        function(PrecisionTraits<float, false>());
+        break;
+    }
+}
+
+void SimulationCore::integrate(float deltaSeconds)
+{
+    dispatchPrecision([&](auto traits) { integrateAs<decltype(traits)>(deltaSeconds); });
+    accelerationsCurrent = false;
+}
+
+template <typename Traits>
+void SimulationCore::integrateAs(double deltaSeconds)
+{
+    using Real = typename Traits::Real;
+    using Vector = Vec3T<Real>;
+
+    // Rohzeiger vor dem parallelen Bereich holen: der nicht-konstante Zugriff auf implizit
+    // geteilte QVector-Daten darf nicht gleichzeitig aus mehreren Threads abkoppeln
+    const StateColumns<Traits> positions(posX, posY, posZ, posResX, posResY, posResZ);
+    const StateColumns<Traits> velocities(velX, velY, velZ, velResX, velResY, velResZ);
+    const float *ax = accX.constData();
+    const float *ay = accY.constData();
+    const float *az = accZ.constData();
+    const Real dt = Real(deltaSeconds);
+
+    parallelFor(size(), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const Vector pos = positions.load(i);
+            Vector vel = velocities.load(i) + Vector(ax[i], ay[i], az[i]) * dt;
+            vel -= Vector::dot(vel, pos) * pos;
+
+            const Real speed = vel.length();
+            if (speed > Real(1e-6f)) {
+                const Vector axis = Vector::cross(pos, vel).normalized();
+                const Real angleRad = speed * dt;
+
+                positions.store(i, rotateAroundAxis(pos, axis, angleRad).normalized());
+                velocities.store(i, rotateAroundAxis(vel, axis, angleRad));
+            }
+        }
+    });
+}
+
+void SimulationCore::kick(double deltaSeconds)
+{
+    dispatchPrecision([&](auto traits) { kickAs<decltype(traits)>(deltaSeconds); });
+}
+
+template <typename Traits>
+void SimulationCore::kickAs(double deltaSeconds)
+{
+    using Real = typename Traits::Real;
+    using Vector = Vec3T<Real>;
+
+    const StateColumns<Traits> positions(posX, posY, posZ, posResX, posResY, posResZ);
+    const StateColumns<Traits> velocities(velX, velY, velZ, velResX, velResY, velResZ);
+    const float *ax = accX.constData();
+    const float *ay = accY.constData();
+    const float *az = accZ.constData();
+    const Real dt = Real(deltaSeconds);
+
+    parallelFor(size(), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const Vector pos = positions.load(i);
+            Vector vel = velocities.load(i) + Vector(ax[i], ay[i], az[i]) * dt;
+            vel -= Vector::dot(vel, pos) * pos;
+            velocities.store(i, vel);
+        }
+    });
+}
+
+void SimulationCore::drift(double deltaSeconds)
+{
+    dispatchPrecision([&](auto traits) { driftAs<decltype(traits)>(deltaSeconds); });
+    accelerationsCurrent = false;
+}
+
+template <typename Traits>
+void SimulationCore::driftAs(double deltaSeconds)
+{
+    using Real = typename Traits::Real;
+    using Vector = Vec3T<Real>;
+
+    const StateColumns<Traits> positions(posX, posY, posZ, posResX, posResY, posResZ);
+    const StateColumns<Traits> velocities(velX, velY, velZ, velResX, velResY, velResZ);
+    const Real dt = Real(deltaSeconds);
+
+    parallelFor(size(), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            Vector pos = positions.load(i);
+            Vector vel = velocities.load(i);
+            geodesicFlow(pos, vel, dt);
+            positions.store(i, pos);
+            velocities.store(i, vel);
+        }
+    });
+}
+
+void SimulationCore::leapfrogStep(double deltaSeconds)
+{
+    // Kick-Drift-Kick; die Beschleunigung am Schrittende dient als Start des naechsten Schritts
+    if (!accelerationsCurrent) {
+        computeAccelerations();
+    }
+    kick(0.5 * deltaSeconds);
+    drift(deltaSeconds);
+    computeAccelerations();
+    kick(0.5 * deltaSeconds);
+}
+
+void SimulationCore::kickBlock(const int *indices, int count, double deltaSeconds)
+{
+    dispatchPrecision([&](auto traits) { kickBlockAs<decltype(traits)>(indices, count, deltaSeconds); });
+}
+
+template <typename Traits>
+void SimulationCore::kickBlockAs(const int *indices, int count, double deltaSeconds)
+{
+    using Real = typename Traits::Real;
+    using Vector = Vec3T<Real>;
+
+    // Halber Kick mit der eigenen Schrittweite dt / 2^k jedes Markers
+    const StateColumns<Traits> positions(posX, posY, posZ, posResX, posResY, posResZ);
+    const StateColumns<Traits> velocities(velX, velY, velZ, velResX, velResY, velResZ);
+    const float *ax = accX.constData();
+    const float *ay = accY.constData();
+    const float *az = accZ.constData();
+    const quint8 *level = levels.constData();
+    const double halfStep = 0.5 * deltaSeconds;
+
+    parallelFor(count, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            const int i = indices[k];
+            const Real h = Real(halfStep / double(1 << level[i]));
+            const Vector pos = positions.load(i);
+            Vector vel = velocities.load(i) + Vector(ax[i], ay[i], az[i]) * h;
+            vel -= Vector::dot(vel, pos) * pos;
+            velocities.store(i, vel);
+        }
+    });
+}
+
+int SimulationCore::assignBlockLevels(float deltaSeconds)
+{
+    const int n = size();
+    levels.resize(n);
+    nearestArc.resize(n);
+
+    // Naechster Nachbar ueber das Kollisionsgitter mit einer Suchweite um den mittleren Markerabstand;
+    // weiter entfernte Nachbarn zaehlen als searchAngle, das ist fuer die Schrittwahl konservativ
+    const float searchAngle = qBound(1e-3f, 4.0f / qSqrt(float(qMax(n, 1))), 1.0f);
+    const float searchChord = 2.0f * qSin(0.5f * searchAngle);
+    nearestArc.fill(searchChord);
+    nearestIndex.fill(-1, n);
+    collisionGrid.build(posX.constData(), posY.constData(), posZ.constData(), n, searchAngle);
+    for (int i = 0; i < n; ++i) {
+        collisionGrid.candidates(i, collisionCandidates);
+        for (int j : collisionCandidates) {
+            const float dx = posX[i] - posX[j];
+            const float dy = posY[i] - posY[j];
+            const float dz = posZ[i] - posZ[j];
+            const float chord = qSqrt(dx * dx + dy * dy + dz * dz);
+            if (chord < nearestArc[i]) {
+                nearestArc[i] = chord;
+                nearestIndex[i] = j;
+            }
+            if (chord < nearestArc[j]) {
+                nearestArc[j] = chord;
+                nearestIndex[j] = i;
+            }
+        }
+    }
+
+    // Stufe k: kleinste mit dt / 2^k <= h; zugleich Zaehlsortierung nach absteigender Stufe
+    QVector<int> perLevel(maxBlockLevel + 2, 0);
+    int deepest = 0;
+    for (int i = 0; i < n; ++i) {
+        // Unterhalb von sqrt(pairEpsilon) wirkt keine Kraft, naehere Nachbarn verlangen keine feineren Schritte
+        const float d = qMax(nearestArc[i], pairCutoffAngle);
+        const float acc = Vec3(accX[i], accY[i], accZ[i]).length();
+        // Annaeherungsgeschwindigkeit zum Nachbarn; ohne Nachbarn in Suchweite die eigene Geschwindigkeit
+        const int j = nearestIndex[i];
+        const float speed = (j >= 0 ? velocity(i) - velocity(j) : velocity(i)).length();
+        float h = deltaSeconds;
+        if (acc > 0.0f) {
+            h = qMin(h, blockEta * qSqrt(d / acc));
+        }
+        if (speed > 0.0f) {
+            h = qMin(h, blockEta * d / speed);
+        }
+
+        int level = 0;
+        while (level < maxBlockLevel && deltaSeconds / float(1 << level) > h) {
+            ++level;
+        }
+        levels[i] = quint8(level);
+        deepest = qMax(deepest, level);
+        ++perLevel[maxBlockLevel - level + 1];
+    }
+    for (int k = 1; k < perLevel.size(); ++k) {
+        perLevel[k] += perLevel[k - 1];
+    }
+    blockOrder.resize(n);
+    for (int i = 0; i < n; ++i) {
+        blockOrder[perLevel[maxBlockLevel - levels[i]]++] = i;
+    }
+    return deepest;
+}
+
+void SimulationCore::blockStep(float deltaSeconds)
+{
+    // Kick-Drift-Kick auf dem feinsten Raster dt / 2^L: alle Marker driften jeden Teilschritt (billig),
+    // Kraefte und Kicks nur fuer Marker, deren eigener Schritt an diesem Rasterpunkt beginnt oder endet
+    if (!accelerationsCurrent) {
+        computeAccelerations();
+    }
+    const int deepest = assignBlockLevels(deltaSeconds);
+    const int ticks = 1 << deepest;
+    const double tick = double(deltaSeconds) / ticks;
+
+    // blockOrder ist absteigend nach Stufe sortiert; an Rasterpunkt t sind die Stufen >= deepest - ctz(t)
+    // faellig, also ein Praefix von blockOrder
+    QVector<int> dueCount(deepest + 1, 0);
+    for (int i = 0; i < size(); ++i) {
+        ++dueCount[deepest - qMin<int>(levels[i], deepest)];
+    }
+    for (int k = 1; k <= deepest; ++k) {
+        dueCount[k] += dueCount[k - 1];
+    }
+    auto dueAt = [&](int t) {
+        if (t == 0 || t == ticks) {
+            return size();
+        }
+        int trailing = 0;
+        while (!((t >> trailing) & 1)) {
+            ++trailing;
+        }
+        return dueCount[trailing];
+    };
+
+    const int *order = blockOrder.constData();
+    for (int t = 0; t < ticks; ++t) {
+        kickBlock(order, dueAt(t), deltaSeconds);
+        drift(tick);
+        const int due = dueAt(t + 1);
+        computeAccelerationsFor(order, due);
+        kickBlock(order, due, deltaSeconds);
+    }
+    // Am Ende des Schritts haben alle Marker ihre Beschleunigung am Endpunkt
+    accelerationsCurrent = true;
+}
+
+void SimulationCore::rungeKuttaStep(double deltaSeconds)
+{
+    dispatchPrecision([&](auto traits) { rungeKuttaStepAs<decltype(traits)>(deltaSeconds); });
+    accelerationsCurrent = false;
+}
+
+template <typename Real>
+Real *SimulationCore::rungeKuttaBuffer(int size)
+{
+    if constexpr (std::is_same<Real, float>::value) {
+        rungeKuttaScratch.resize(size);
+        return rungeKuttaScratch.data();
+    } else {
+        rungeKuttaScratchWide.resize(size);
+        return rungeKuttaScratchWide.data();
+    }
+}
+
+template <typename Traits>
+void SimulationCore::rungeKuttaStepAs(double deltaSeconds)
+{
+    using Real = typename Traits::Real;
+    using Vector = Vec3T<Real>;
+
+    // RK4 fuer (p, v) im R^3 mit p' = v, v' = a(p/|p|) - |v|^2/|p|^2 * p. Die Kugel ist eine invariante
+    // Mannigfaltigkeit dieses Systems, daher bleibt die 4. Ordnung erhalten; projiziert wird nur am Schrittende.
+    const int n = size();
+    Real *scratch = rungeKuttaBuffer<Real>(15 * n);
+    Real *p0x = scratch;         Real *p0y = scratch + n;      Real *p0z = scratch + 2 * n;
+    Real *v0x = scratch + 3 * n; Real *v0y = scratch + 4 * n;  Real *v0z = scratch + 5 * n;
+    Real *kpx = scratch + 6 * n; Real *kpy = scratch + 7 * n;  Real *kpz = scratch + 8 * n;
+    Real *kvx = scratch + 9 * n; Real *kvy = scratch + 10 * n; Real *kvz = scratch + 11 * n;
+    Real *spx = scratch + 12 * n; Real *spy = scratch + 13 * n; Real *spz = scratch + 14 * n;
+
+    const StateColumns<Traits> positions(posX, posY, posZ, posResX, posResY, posResZ);
+    const StateColumns<Traits> velocities(velX, velY, velZ, velResX, velResY, velResZ);
+
+    parallelFor(n, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const Vector p0 = positions.load(i);
+            const Vector v0 = velocities.load(i);
+            p0x[i] = spx[i] = p0.x; p0y[i] = spy[i] = p0.y; p0z[i] = spz[i] = p0.z;
+            v0x[i] = v0.x; v0y[i] = v0.y; v0z[i] = v0.z;
+            kpx[i] = kpy[i] = kpz[i] = Real(0);
+            kvx[i] = kvy[i] = kvz[i] = Real(0);
+        }
+    });
+
+    static constexpr double stageWeights[4] = {1.0, 2.0, 2.0, 1.0};
+    static constexpr double stageOffsets[4] = {0.0, 0.5, 0.5, 1.0};
+
+    for (int stage = 0; stage < 4; ++stage) {
+        // Beschleunigungen an den (normierten) Stufenpositionen in posX/Y/Z
+        computeAccelerations();
+        const float *ax = accX.constData();
+        const float *ay = accY.constData();
+        const float *az = accZ.constData();
+
+        const Real weight = Real(stageWeights[stage]);
+        const bool lastStage = stage == 3;
+        const Real nextOffset = lastStage ? Real(0) : Real(stageOffsets[stage + 1] * deltaSeconds);
+
+        parallelFor(n, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const Vector stagePos(spx[i], spy[i], spz[i]);
+                const Vector stageVel = velocities.load(i);
+                const Vector stageAcc = Vector(ax[i], ay[i], az[i])
+                                      - (stageVel.lengthSquared() / stagePos.lengthSquared()) * stagePos;
+
+                kpx[i] += weight * stageVel.x; kpy[i] += weight * stageVel.y; kpz[i] += weight * stageVel.z;
+                kvx[i] += weight * stageAcc.x; kvy[i] += weight * stageAcc.y; kvz[i] += weight * stageAcc.z;
+
+                if (lastStage) {
+                    continue;
+                }
+
+                const Vector nextPos = Vector(p0x[i], p0y[i], p0z[i]) + stageVel * nextOffset;
+                const Vector nextVel = Vector(v0x[i], v0y[i], v0z[i]) + stageAcc * nextOffset;
+                spx[i] = nextPos.x; spy[i] = nextPos.y; spz[i] = nextPos.z;
+                positions.store(i, nextPos.normalized());
+                velocities.store(i, nextVel);
+            }
+        });
+    }
+
+    const Real sixth = Real(deltaSeconds / 6.0);
+    parallelFor(n, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const Vector pos = (Vector(p0x[i], p0y[i], p0z[i]) + Vector(kpx[i], kpy[i], kpz[i]) * sixth).normalized();
+            Vector vel = Vector(v0x[i], v0y[i], v0z[i]) + Vector(kvx[i], kvy[i], kvz[i]) * sixth;
+            vel -= Vector::dot(vel, pos) * pos;
+            positions.store(i, pos);
+            velocities.store(i, vel);
+        }
+    });
+}
+
+double SimulationCore::kineticEnergy() const
+{
+    double energy = 0.0;
+    for (int i = 0; i < size(); ++i) {
+        const double speedSquared = hasResiduals() ? exactVelocity(i).lengthSquared() : velocity(i).lengthSquared();
+        energy += 0.5 * masses[i] * speedSquared;
+    }
+    return energy;
+}
+
+double SimulationCore::potentialEnergy() const
+{
+    const double fullCircle = 2.0 * M_PI;
+    const int n = size();
+    double energy = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const Vec3d pos = exactPosition(i);
+        double row = 0.0;
+        for (int j = i + 1; j < n; ++j) {
+            const double dot = qBound(-1.0, Vec3d::dot(pos, exactPosition(j)), 1.0);
+            if (1.0 - dot * dot < pairEpsilon) {
+                continue;
+            }
+            const double arc = std::acos(dot);
+            row += masses[j] * (1.0 / arc + 1.0 / (fullCircle - arc));
+        }
+        energy -= masses[i] * row;
+    }
+    return gravity * energy;
+}
+
+void SimulationCore::handleCollisions()
+{
+    FrameProfiler::Scope profile(FrameProfiler::Collisions);
+    colliding.fill(false);
+    sweptContacts = 0;
+    merges = 0;
+    elasticImpacts = 0;
+
+    const int n = size();
+    const bool swept = continuousCollisionsEnabled && sweepPending && sweepX.size() == n;
+    sweepPending = false;
+    if (n < 2) {
+        return;
+    }
+    absorbedBy.fill(-1, n);
+    absorbedMarkers.clear();
+
+    float maxRadius = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        maxRadius = qMax(maxRadius, radii[i]);
+    }
+
+    // Kontakte waehrend des Schritts zuerst, danach verbleibende Ueberlappungen am Schrittende
+    if (swept) {
+        resolveSweptCollisions(maxRadius);
+    }
+
+    // Broad Phase: nur Marker aus benachbarten Gitterzellen koennen sich beruehren
+    collisionGrid.build(posX.constData(), posY.constData(), posZ.constData(), n, 2.0f * maxRadius / sphereRadius);
+
+    // Paare in derselben Reihenfolge (i, dann j aufsteigend) wie die vollstaendige Paarschleife aufloesen
+    for (int i = 0; i < n; ++i) {
+        if (isAbsorbed(i)) {
+            continue;
+        }
+        collisionGrid.candidates(i, collisionCandidates);
+        for (int j : collisionCandidates) {
+            resolveCollision(i, j);
+            if (isAbsorbed(i)) {
+                break;
+            }
+        }
+    }
+
+    // Aufgenommene Marker erst jetzt entfernen, damit die Indizes waehrend der Aufloesung gueltig bleiben
+    removeAbsorbedMarkers();
+}
+
+void SimulationCore::resolveCollision(int i, int j)
+{
+    if (isAbsorbed(j)) {
+        return;
+    }
+
+    const Vec3 pa = position(i);
+    const Vec3 pb = position(j);
+
+    const float dot = qBound(-1.0f, Vec3::dot(pa, pb), 1.0f);
+    const float angle = qAcos(dot);
+    const float minAngle = (radii[i] + radii[j]) / sphereRadius;
+
+    if (angle > minAngle) {
+        return;
+    }
+
+    if (collisionKind == CollisionMode::Merge) {
+        mergeMarkers(i, j);
+        return;
+    }
+
+    colliding[i] = true;
+    colliding[j] = true;
+    exchangeContactVelocities(i, j);
+}
+
+int SimulationCore::mergeMarkers(int i, int j)
+{
+    // Der schwerere Marker nimmt den leichteren auf, bei gleicher Masse der mit kleinerem Index
+    const int keep = masses[j] > masses[i] ? j : i;
+    const int gone = keep == i ? j : i;
+
+    const float m1 = masses[keep];
+    const float m2 = masses[gone];
+    const float total = m1 + m2;
+    const Vec3 p1 = position(keep);
+    const Vec3 p2 = position(gone);
+    const Vec3 v1 = velocity(keep);
+    const Vec3 v2 = velocity(gone);
+
+    // Massenschwerpunkt auf der Kugel
+    Vec3 merged = p1 * m1 + p2 * m2;
+    if (merged.lengthSquared() < 1e-12f) {
+        merged = p1;
+    }
+    merged = merged.normalized();
+
+    // Drehimpuls um den Kugelmittelpunkt L = m p x v ist das Gegenstueck zum Impuls in der Ebene.
+    // Tangentiale Geschwindigkeit am neuen Ort aus m p x v = L: v = (L x p) / m; der Anteil von L entlang p entfaellt.
+    Vec3 mergedVelocity;
+    if (total > 0.0f) {
+        const Vec3 angular = Vec3::cross(p1, v1) * m1 + Vec3::cross(p2, v2) * m2;
+        mergedVelocity = Vec3::cross(angular, merged) * (1.0f / total);
+    } else {
+        mergedVelocity = transportTangent((v1 + v2) * 0.5f, p1, merged);
+    }
+
+    // Volumen addiert sich, die Dichte folgt aus der erhaltenen Masse
+    const float r1 = radii[keep];
+    const float r2 = radii[gone];
+    const float radius = std::cbrt(r1 * r1 * r1 + r2 * r2 * r2);
+    radii[keep] = radius;
+    masses[keep] = total;
+    if (radius > 0.0f) {
+        densities[keep] = total / (radius * radius * radius);
+    }
+    setPosition(keep, merged);
+    setVelocity(keep, mergedVelocity);
+    colliding[keep] = true;
+
+    absorbedBy[gone] = keep;
+    absorbedMarkers.append(gone);
+    ++merges;
+    accelerationsCurrent = false;
+    return keep;
+}
+
+void SimulationCore::removeAbsorbedMarkers()
+{
+    if (absorbedMarkers.isEmpty()) {
+        return;
+    }
+
+    // Ziel-ID vor dem Umsortieren bestimmen; Ketten (a in b, b in c) bis zum verbliebenen Marker verfolgen
+    QVector<QPair<int, quint32>> removals;
+    removals.reserve(absorbedMarkers.size());
+    for (int index : absorbedMarkers) {
+        int target = absorbedBy[index];
+        while (absorbedBy[target] >= 0) {
+            target = absorbedBy[target];
+        }
+        removals.append(qMakePair(index, ids[target]));
+    }
+
+    // Absteigend entfernen: der jeweils letzte Marker ist dann nie selbst ein aufgenommener
+    std::sort(removals.begin(), removals.end(), [](const QPair<int, quint32> &a, const QPair<int, quint32> &b) {
+        return a.first > b.first;
+    });
+    for (const auto &removal : removals) {
+        swapRemove(removal.first, removal.second);
+    }
+    absorbedMarkers.clear();
+}
+
+void SimulationCore::exchangeContactVelocities(int i, int j)
+{
+    const float epsilon = 1e-6f;
+
+    const Vec3 pa = position(i);
+    const Vec3 pb = position(j);
+
+    Vec3 mid = pa + pb;
+    if (mid.lengthSquared() < epsilon) {
+        mid = pa;
+    }
+    mid = mid.normalized();
+
+    Vec3 n = pb - pa;
+    n -= Vec3::dot(n, mid) * mid;
+    if (n.lengthSquared() < epsilon) {
+        return;
+    }
+    n = n.normalized();
+
+    const Vec3 velA = velocity(i);
+    const Vec3 velB = velocity(j);
+    const Vec3 va = velA - Vec3::dot(velA, mid) * mid;
+    const Vec3 vb = velB - Vec3::dot(velB, mid) * mid;
+
+    const float vaN = Vec3::dot(va, n);
+    const float vbN = Vec3::dot(vb, n);
+    const float rel = vaN - vbN;
+
+    if (rel <= 0.0f) {
+        return;
+    }
+    ++elasticImpacts;
+
+    const Vec3 vaT = va - vaN * n;
+    const Vec3 vbT = vb - vbN * n;
+
+    const float m1 = radii[i] * radii[i];
+    const float m2 = radii[j] * radii[j];
+
+    const float newVaN = (vaN * (m1 - m2) + 2.0f * m2 * vbN) / (m1 + m2);
+    const float newVbN = (vbN * (m2 - m1) + 2.0f * m1 * vaN) / (m1 + m2);
+
+    Vec3 newVa = vaT + newVaN * n;
+    Vec3 newVb = vbT + newVbN * n;
+
+    newVa -= Vec3::dot(newVa, pa) * pa;
+    newVb -= Vec3::dot(newVb, pb) * pb;
+
+    setVelocity(i, newVa);
+    setVelocity(j, newVb);
+}
+
+void SimulationCore::resolveSweptCollisions(float maxRadius)
+{
+    const int n = size();
+    sweptPaths.resize(n);
+    sweepActive.resize(n);
+
+    // Nur Marker, die weiter als ihren Radius gewandert sind, koennen einen Kontakt ueberspringen
+    bool anyFast = false;
+    for (int i = 0; i < n; ++i) {
+        sweptPaths[i] = SweptPath(Vec3(sweepX[i], sweepY[i], sweepZ[i]), position(i), 0.0f);
+        const bool fast = sweptPaths[i].angle > radii[i] / sphereRadius;
+        sweepActive[i] = fast ? 1 : 0;
+        anyFast |= fast;
+    }
+    if (!anyFast) {
+        return;
+    }
+
+    // Jeder Durchlauf loest die fruehesten Kontakte auf; die neuen Restbahnen werden im naechsten Durchlauf geprueft
+    for (int pass = 0; pass < maxSweepPasses; ++pass) {
+        findSweptContacts(maxRadius);
+        if (sweptContactList.isEmpty()) {
+            break;
+        }
+        std::sort(sweptContactList.begin(), sweptContactList.end(), [](const SweptContact &a, const SweptContact &b) {
+            if (a.fraction != b.fraction) {
+                return a.fraction < b.fraction;
+            }
+            return a.i != b.i ? a.i < b.i : a.j < b.j;
+        });
+
+        // sweepActive markiert ab hier die in diesem Durchlauf bereits umgelenkten Marker
+        std::fill(sweepActive.begin(), sweepActive.end(), quint8(0));
+        for (const SweptContact &contact : sweptContactList) {
+            if (sweepActive[contact.i] || sweepActive[contact.j] || isAbsorbed(contact.i) || isAbsorbed(contact.j)) {
+                continue;
+            }
+            applySweptContact(contact);
+            sweepActive[contact.i] = 1;
+            sweepActive[contact.j] = 1;
+            ++sweptContacts;
+        }
+    }
+}
+
+void SimulationCore::findSweptContacts(float maxRadius)
+{
+    const int n = size();
+    sweptContactList.clear();
+
+    // Einschliessende Kappe je Bahn: Mittelpunkt des Bogens, Radius halber Bogen plus Markerradius
+    capX.resize(n);
+    capY.resize(n);
+    capZ.resize(n);
+    capAngles.resize(n);
+    for (int i = 0; i < n; ++i) {
+        const SweptPath &path = sweptPaths[i];
+        Vec3 center = path.start + path.end;
+        float cap = 0.5f * path.angle;
+        if (center.lengthSquared() < 1e-8f) {
+            // Nahezu antipodale Bahn: Mittelpunkt unbestimmt, Kappe um den Start
+            center = path.start;
+            cap = path.angle;
+        }
+        center = center.normalized();
+        capX[i] = center.x;
+        capY[i] = center.y;
+        capZ[i] = center.z;
+        capAngles[i] = cap + radii[i] / sphereRadius;
+    }
+
+    // Zellgroesse aus der typischen Kappe; einzelne Ausreisser wuerden sonst alle Zellen aufblaehen
+    capMedianScratch.resize(n);
+    std::copy(capAngles.cbegin(), capAngles.cend(), capMedianScratch.begin());
+    std::nth_element(capMedianScratch.begin(), capMedianScratch.begin() + n / 2, capMedianScratch.end());
+    float gridCapLimit = gridCapFactor * qMax(capMedianScratch[n / 2], maxRadius / sphereRadius);
+    if (2.0f * gridCapLimit > maxGridContactAngle) {
+        gridCapLimit = -1.0f; // Zellen wuerden die halbe Kugel umfassen: direkte Paarschleife ist billiger
+    }
+    float maxGridCap = 0.0f;
+    largeCaps.clear();
+    for (int i = 0; i < n; ++i) {
+        if (capAngles[i] > gridCapLimit) {
+            largeCaps.append(i);
+        } else {
+            maxGridCap = qMax(maxGridCap, capAngles[i]);
+        }
+    }
+
+    auto testPair = [this](int i, int j) {
+        if (isAbsorbed(i) || isAbsorbed(j)) {
+            return;
+        }
+        // Notwendige Bedingung: Sehne zwischen den Kappenmittelpunkten <= Winkelsumme (Sehne <= Bogen)
+        const float reach = capAngles[i] + capAngles[j];
+        const float dx = capX[i] - capX[j];
+        const float dy = capY[i] - capY[j];
+        const float dz = capZ[i] - capZ[j];
+        if (dx * dx + dy * dy + dz * dz > reach * reach) {
+            return;
+        }
+        float fraction = 0.0f;
+        if (sweptTimeOfImpact(i, j, fraction)) {
+            sweptContactList.append({fraction, i, j});
+        }
+    };
+
+    isLargeCap.fill(0, n);
+    for (int i : largeCaps) {
+        isLargeCap[i] = 1;
+    }
+
+    // Nur Paare mit mindestens einer aktiven Bahn; zwei langsame Marker erledigt die Ueberlappungspruefung.
+    // Sind die meisten Bahnen aktiv, genuegen die Kandidaten j > i, sonst Nachbarn der aktiven Marker in beide Richtungen.
+    if (largeCaps.size() < n) {
+        collisionGrid.build(capX.constData(), capY.constData(), capZ.constData(), n, 2.0f * maxGridCap);
+        const bool mostlyActive = 2 * std::count(sweepActive.cbegin(), sweepActive.cend(), quint8(1)) > n;
+        for (int i = 0; i < n; ++i) {
+            if (isLargeCap[i] || (!mostlyActive && !sweepActive[i])) {
+                continue;
+            }
+            if (mostlyActive) {
+                collisionGrid.candidates(i, collisionCandidates);
+            } else {
+                collisionGrid.neighbours(i, collisionCandidates);
+            }
+            for (int j : collisionCandidates) {
+                if (isLargeCap[j] || (!sweepActive[i] && !sweepActive[j])) {
+                    continue;
+                }
+                if (!mostlyActive && sweepActive[j] && j < i) {
+                    continue; // Paar zweier aktiver Marker wurde schon von j aus geprueft
+                }
+                testPair(qMin(i, j), qMax(i, j));
+            }
+        }
+    }
+
+    // Sehr lange Bahnen wuerden die Gitterzellen aufblaehen; sie werden gegen alle Marker geprueft
+    for (int large : largeCaps) {
+        for (int j = 0; j < n; ++j) {
+            if (j == large || (isLargeCap[j] && j < large) || (!sweepActive[large] && !sweepActive[j])) {
+                continue;
+            }
+            testPair(qMin(large, j), qMax(large, j));
+        }
+    }
+}
+
+SimulationCore::SweptPath::SweptPath(const Vec3 &from, const Vec3 &to, float fraction)
+    : start(from),
+      end(to),
+      startFraction(fraction),
+      angle(arcBetween(from, to))
+{
+    const Vec3 axis = Vec3::cross(from, to);
+    const float sine = axis.length();
+    if (sine > 1e-6f) {
+        spin = axis * (rate() / sine);
+    }
+}
+
+Vec3 SimulationCore::sweptPosition(int index, float fraction) const
+{
+    // Gleichfoermige Drehung entlang des Grosskreisbogens (Slerp) ab startFraction
+    const SweptPath &path = sweptPaths[index];
+    if (fraction <= path.startFraction) {
+        return path.start;
+    }
+    const float u = qMin(1.0f, (fraction - path.startFraction) / (1.0f - path.startFraction));
+    const float sine = qSin(path.angle);
+    if (sine < 1e-6f) {
+        return (path.start * (1.0f - u) + path.end * u).normalized();
+    }
+    return (path.start * (qSin((1.0f - u) * path.angle) / sine) + path.end * (qSin(u * path.angle) / sine)).normalized();
+}
+
+bool SimulationCore::sweptTimeOfImpact(int i, int j, float &fraction) const
+{
+    const SweptPath &a = sweptPaths[i];
+    const SweptPath &b = sweptPaths[j];
+    const float contact = (radii[i] + radii[j]) / sphereRadius;
+
+    // Im mitdrehenden System von b dreht sich a mit spin_a - spin_b: schneller kann sich der Abstand nicht aendern
+    const bool exactSpin = (a.angle <= 0.0f || a.spin.lengthSquared() > 0.0f) && (b.angle <= 0.0f || b.spin.lengthSquared() > 0.0f);
+    const float closingRate = exactSpin ? (a.spin - b.spin).length() : a.rate() + b.rate();
+    if (closingRate <= 0.0f) {
+        return false;
+    }
+
+    // Konservative Annaeherung: innerhalb von Luecke / closingRate ist kein Kontakt moeglich
+    float t = qMax(a.startFraction, b.startFraction);
+    for (int iteration = 0; iteration < maxAdvancementSteps; ++iteration) {
+        const float gap = arcBetween(sweptPosition(i, t), sweptPosition(j, t)) - contact;
+        if (gap <= contactTolerance * contact) {
+            // Bereits zu Beginn beruehrend: kein uebersprungener Kontakt, das erledigt die Ueberlappungspruefung
+            if (iteration == 0) {
+                return false;
+            }
+            fraction = t;
+            return true;
+        }
+        t += gap / closingRate;
+        if (t >= 1.0f) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void SimulationCore::applySweptContact(const SweptContact &contact)
+{
+    // Beide Marker an den Aufprallort setzen, die Geschwindigkeit vom Schrittende dorthin transportieren
+    for (int index : {contact.i, contact.j}) {
+        const Vec3 hit = sweptPosition(index, contact.fraction);
+        setVelocity(index, transportTangent(velocity(index), position(index), hit));
+        setPosition(index, hit);
+    }
+
+    int moving[2] = {contact.i, contact.j};
+    int movingCount = 2;
+    if (collisionKind == CollisionMode::Merge) {
+        moving[0] = mergeMarkers(contact.i, contact.j);
+        movingCount = 1;
+    } else {
+        exchangeContactVelocities(contact.i, contact.j);
+        colliding[contact.i] = true;
+        colliding[contact.j] = true;
+    }
+
+    // Restschritt mit der neuen Geschwindigkeit; die Gravitation des Rests ist bereits im Integrator enthalten
+    const float remainingSeconds = (1.0f - contact.fraction) * sweepSeconds;
+    for (int k = 0; k < movingCount; ++k) {
+        const int index = moving[k];
+        Vec3 pos = position(index);
+        Vec3 vel = velocity(index);
+        geodesicFlow(pos, vel, remainingSeconds);
+
+        sweptPaths[index] = SweptPath(position(index), pos, contact.fraction);
+        setPosition(index, pos);
+        setVelocity(index, vel);
+    }
+}
+
+void SimulationCore::setMarkerDensity(int index, float density)
+{
+    if (index < 0 || index >= size()) {
+        return;
+    }
+
+    densities[index] = density;
+    updateMass(index);
+}
+
+void SimulationCore::setMarkerRadius(int index, float radius)
+{
+    if (index < 0 || index >= size() || radius <= 0.0f) {
+        return;
+    }
+
+    radii[index] = radius;
+    updateMass(index);
+}
+
+void SimulationCore::setMarkerVelocityMagnitude(int index, float magnitude)
+{
+    if (index < 0 || index >= size()) {
+        return;
+    }
+
+    // Behalte die Richtung, aendere nur den Betrag
+    const Vec3 currentVelocity = velocity(index);
+    const float currentMagnitude = currentVelocity.length();
+
+    if (currentMagnitude > 0.0001f) {
+        setVelocity(index, currentVelocity.normalized() * magnitude);
+    } else {
+        // Falls Geschwindigkeit ~0 ist, setze neue Richtung in Z
+        setVelocity(index, Vec3(0.0f, 0.0f, magnitude));
+    }
+}
+
+QJsonObject SimulationCore::exportScenario() const
+{
+    QJsonObject root;
+    root["version"] = 1;
+    root["sphereRadius"] = sphereRadius;
+
+    QJsonArray markerArray;
+
+    for (int i = 0; i < size(); ++i) {
+        const quint32 rgb = colors[i];
+        QJsonObject markerObj;
+        markerObj["radius"] = radii[i];
+        markerObj["density"] = densities[i];
+        markerObj["color"] = QJsonArray{int((rgb >> 16) & 0xff), int((rgb >> 8) & 0xff), int(rgb & 0xff)};
+        markerObj["position"] = QJsonArray{posX[i], posY[i], posZ[i]};
+        markerObj["velocity"] = QJsonArray{velX[i], velY[i], velZ[i]};
+        markerArray.append(markerObj);
+    }
+
+    root["markers"] = markerArray;
+    return root;
+}
+
+bool SimulationCore::applyScenario(const QJsonObject &scenario)
+{
+    if (!scenario.contains("markers") || !scenario["markers"].isArray()) {
+        return false;
+    }
+
+    const QJsonArray markerArray = scenario["markers"].toArray();
+    clear();
+    reserve(markerArray.size());
+
+    // Ein Append-Eintrag fuer alle Marker statt einem je addMarker()
+    const bool logging = structureLogging;
+    structureLogging = false;
+
+    for (const auto &entry : markerArray) {
+        if (!entry.isObject()) {
+            continue;
+        }
+
+        const QJsonObject markerObj = entry.toObject();
+        const QJsonArray colorArr = markerObj["color"].toArray();
+        const QJsonArray posArr = markerObj["position"].toArray();
+        const QJsonArray velArr = markerObj["velocity"].toArray();
+
+        if (colorArr.size() != 3 || posArr.size() != 3 || velArr.size() != 3) {
+            continue;
+        }
+
+        const float radius = static_cast<float>(markerObj["radius"].toDouble(0.1));
+        const float density = static_cast<float>(markerObj["density"].toDouble(1.0));
+        const quint32 color = (quint32(qBound(0, colorArr[0].toInt(255), 255)) << 16)
+                            | (quint32(qBound(0, colorArr[1].toInt(255), 255)) << 8)
+                            | quint32(qBound(0, colorArr[2].toInt(255), 255));
+
+        const Vec3 position(
+            static_cast<float>(posArr[0].toDouble()),
+            static_cast<float>(posArr[1].toDouble()),
+            static_cast<float>(posArr[2].toDouble())
+        );
+
+        const Vec3 velocity(
+            static_cast<float>(velArr[0].toDouble()),
+            static_cast<float>(velArr[1].toDouble()),
+            static_cast<float>(velArr[2].toDouble())
+        );
+
+        addMarker(position, velocity, radius, density, color);
+    }
+
+    structureLogging = logging;
+    if (!isEmpty()) {
+        logStructureChange({StructureChange::Append, 0, size(), -1, invalidMarkerId, invalidMarkerId});
+    }
+    return true;
+}
+
+SimulationCore SimulationCore::parameterCopy() const
+{
+    // Die Kopie teilt zunaechst alle Spalten implizit; das Zuruecksetzen gibt die Referenzen sofort wieder frei,
+    // sodass der laufende Kern beim naechsten Schreibzugriff nichts kopieren muss
+    SimulationCore copy(*this);
+    auto release = [](auto &column) { column = std::decay_t<decltype(column)>(); };
+    release(copy.posX); release(copy.posY); release(copy.posZ);
+    release(copy.velX); release(copy.velY); release(copy.velZ);
+    release(copy.accX); release(copy.accY); release(copy.accZ);
+    release(copy.radii);
+    release(copy.densities);
+    release(copy.masses);
+    release(copy.colors);
+    release(copy.colliding);
+    release(copy.ids);
+    release(copy.posResX); release(copy.posResY); release(copy.posResZ);
+    release(copy.velResX); release(copy.velResY); release(copy.velResZ);
+    release(copy.rungeKuttaScratch);
+    release(copy.rungeKuttaScratchWide);
+    release(copy.levels);
+    release(copy.blockOrder);
+    release(copy.nearestArc);
+    release(copy.nearestIndex);
+    release(copy.tree);
+    release(copy.collisionGrid);
+    release(copy.collisionCandidates);
+    release(copy.sweepX); release(copy.sweepY); release(copy.sweepZ);
+    release(copy.sweptPaths);
+    release(copy.sweepActive);
+    release(copy.capX); release(copy.capY); release(copy.capZ);
+    release(copy.capAngles);
+    release(copy.capMedianScratch);
+    release(copy.largeCaps);
+    release(copy.isLargeCap);
+    release(copy.sweptContactList);
+    release(copy.absorbedBy);
+    release(copy.absorbedMarkers);
+    release(copy.structureChanges);
+    copy.sweepPending = false;
+    copy.structureLogging = false;
+    copy.structureLogBase = 0;
+    return copy;
+}
+
+QVector<QByteArray> SimulationCore::columnBytes() const
+{
+    QVector<QByteArray> columns;
+    columns.reserve(checkpointColumnCount);
+    auto add = [&columns](const auto &column) {
+        columns.append(QByteArray(reinterpret_cast<const char *>(column.constData()),
+                                  column.size() * qsizetype(sizeof(*column.constData()))));
+    };
+    add(posX); add(posY); add(posZ);
+    add(velX); add(velY); add(velZ);
+    add(accX); add(accY); add(accZ);
+    add(radii);
+    add(densities);
+    add(masses);
+    add(colors);
+    add(colliding);
+    add(ids);
+    add(posResX); add(posResY); add(posResZ);
+    add(velResX); add(velResY); add(velResZ);
+    return columns;
+}
+
+bool SimulationCore::restoreCheckpoint(const SimulationCore &parameters, const QVector<QByteArray> &columns)
+{
+    if (columns.size() != checkpointColumnCount) {
+        return false;
+    }
+    // Reihenfolge und Elementgroessen wie in columnBytes(); Restspalten nur im Double-Modus
+    static const qsizetype elementSizes[checkpointColumnCount] = {
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, qsizetype(sizeof(bool)), 4, 8, 8, 8, 8, 8, 8
+    };
+    const qsizetype count = columns[9].size() / 4;
+    for (int c = 0; c < checkpointColumnCount; ++c) {
+        const bool residual = c >= 15;
+        const qsizetype expected = residual && !parameters.hasResiduals() ? 0 : count * elementSizes[c];
+        if (columns[c].size() != expected) {
+            return false;
+        }
+    }
+
+    // Ausfuehrung und Strukturprotokoll gehoeren zu diesem Kern, nicht zum Checkpoint
+    const int threads = requestedThreads;
+    const int parallelMarkers = minParallelMarkers;
+    const std::shared_ptr<WorkerPool> workers = pool;
+    const bool logging = structureLogging;
+    const quint64 logBase = structureLogBase;
+    const QVector<StructureChange> log = structureChanges;
+
+    *this = parameters;
+    requestedThreads = threads;
+    minParallelMarkers = parallelMarkers;
+    pool = workers;
+    structureLogging = logging;
+    structureLogBase = logBase;
+    structureChanges = log;
+
+    int next = 0;
+    auto take = [&columns, &next](auto &column) {
+        const QByteArray &bytes = columns[next++];
+        column.resize(bytes.size() / qsizetype(sizeof(*column.constData())));
+        if (!bytes.isEmpty()) {
+            std::memcpy(column.data(), bytes.constData(), size_t(bytes.size()));
+        }
+    };
+    take(posX); take(posY); take(posZ);
+    take(velX); take(velY); take(velZ);
+    take(accX); take(accY); take(accZ);
+    take(radii);
+    take(densities);
+    take(masses);
+    take(colors);
+    take(colliding);
+    take(ids);
+    take(posResX); take(posResY); take(posResZ);
+    take(velResX); take(velResY); take(velResZ);
+
+    logStructureChange({StructureChange::Reset, 0, 0, -1, invalidMarkerId, invalidMarkerId});
+    if (!isEmpty()) {
+        logStructureChange({StructureChange::Append, 0, size(), -1, invalidMarkerId, invalidMarkerId});
+    }
+    return true;
+}
+
+void SimulationCore::setPosition(int index, const Vec3 &position)
+{
+    posX[index] = position.x;
+    posY[index] = position.y;
+    posZ[index] = position.z;
+    if (hasResiduals()) {
+        posResX[index] = posResY[index] = posResZ[index] = 0.0;
+    }
+    accelerationsCurrent = false;
+}
+
+void SimulationCore::setVelocity(int index, const Vec3 &velocity)
+{
+    velX[index] = velocity.x;
+    velY[index] = velocity.y;
+    velZ[index] = velocity.z;
+    if (hasResiduals()) {
+        velResX[index] = velResY[index] = velResZ[index] = 0.0;
+    }
+}
+
+Vec3d SimulationCore::exactPosition(int index) const
+{
+    Vec3d exact(posX[index], posY[index], posZ[index]);
+    if (hasResiduals()) {
+        exact += Vec3d(posResX[index], posResY[index], posResZ[index]);
+    }
+    return exact;
+}
+
+Vec3d SimulationCore::exactVelocity(int index) const
+{
+    Vec3d exact(velX[index], velY[index], velZ[index]);
+    if (hasResiduals()) {
+        exact += Vec3d(velResX[index], velResY[index], velResZ[index]);
+    }
+    return exact;
+}
+
+void SimulationCore::updateMass(int index)
+{
+    const float r = radii[index];
+    masses[index] = densities[index] * r * r * r;
+    accelerationsCurrent = false;
+}
@@ -0,0 +1,374 @@
+#ifndef SIMULATIONCORE_H
+#define SIMULATIONCORE_H
+
+#include <QVector>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+#include <memory>
+
+#include "spheremath.h"
+#include "spheretree.h"
+#include "collisiongrid.h"
+#include "forcekernels.h"
+#include "markergenerator.h"
+#include "workerpool.h"
+
+/**
+ * @brief SimulationCore - Headless Physik-Simulation der Marker auf der Kugeloberflaeche
+ *
+ * Verantwortlichkeiten:
+ * - Speicherung des Marker-Zustands als Structure-of-Arrays (Position, Geschwindigkeit, Radius, Dichte, Masse, Farbe)
+ * - Berechnung der Gravitationskraefte und Integration der Bewegung auf der Einheitskugel
+ * - Waehlbare Integratoren (semi-implizites Euler, geodaetisches Leapfrog, Yoshida 4. Ordnung, RK4,
+ *   hierarchisches Block-Leapfrog), die Marker bleiben dabei stets auf der Kugel und die Geschwindigkeiten tangential
+ * - Waehlbare Rechengenauigkeit der Integration (float, gemischt, double); die Schrittkerne sind auf den
+ *   Skalartyp templatisiert und fuer alle drei Varianten instanziiert
+ * - Berechnung von kinetischer und potentieller Energie zur Kontrolle der Integrationsgenauigkeit
+ * - Parallele Kraftberechnung ueber einen persistenten WorkerPool; jede Zeile gehoert genau einem Thread,
+ *   dadurch sind die Ergebnisse fuer jede Thread-Anzahl bitgleich
+ * - Erkennung und Aufloesung von Kollisionen, bei schnellen Markern kontinuierlich entlang der Schrittbahn
+ *   (Aufprallzeitpunkt je Paar, danach Restschritt mit neuer Geschwindigkeit)
+ * - Wahlweise elastischer Stoss oder Verschmelzung (Masse und Drehimpuls bleiben erhalten)
+ * - Stabile Marker-IDs; Entfernen in O(1) durch Nachruecken des letzten Markers (Swap-Remove)
+ * - Optionales Protokoll struktureller Aenderungen, mit dem Ansichten ihre indexparallelen Daten nachfuehren
+ * - Serialisierung des Marker-Zustands fuer Szenarien (.grv) und spaltenweiser Import fuer .grvb
+ * - Reproduzierbare, parallele Erzeugung von Startverteilungen (MarkerGenerator)
+ * - Keine Abhaengigkeit von Qt3D oder QtGui, damit Tools und Benchmarks den Kern direkt linken koennen
+ */
+class SimulationCore {
+public:
+    enum class ForceSolver {
+        BruteForce, // exakte Paarsumme, O(N^2)
+        BarnesHut   // Cube-Sphere-Quadtree, O(N log N)
+    };
+    static const char *forceSolverName(ForceSolver solver);
+    // Namen wie von den *Name()-Funktionen geliefert, ohne Beachtung der Gross-/Kleinschreibung
+    static bool parseForceSolver(const QString &name, ForceSolver &solver);
+
+    enum class Integrator {
+        Euler,     // semi-implizites Euler (Kick, dann Drehung entlang der Geodaete), 1 Kraftauswertung
+        Leapfrog,  // geodaetisches Velocity-Verlet (Kick-Drift-Kick), 1 Kraftauswertung, 2. Ordnung
+        Yoshida4,  // Yoshida-Komposition dreier Leapfrog-Schritte, 3 Kraftauswertungen, 4. Ordnung
+        RK4,       // klassisches Runge-Kutta im Einbettungsraum mit Projektion, 4 Kraftauswertungen
+        Block      // Leapfrog mit Zweierpotenz-Teilschritten je Marker; Kraftauswertung nur fuer faellige Marker
+    };
+    static const char *integratorName(Integrator integrator);
+    static bool parseIntegrator(const QString &name, Integrator &integrator);
+
+    enum class CollisionMode {
+        Elastic,  // elastischer Stoss entlang der Verbindungslinie
+        Merge     // beruehrende Marker verschmelzen; der schwerere behaelt seine ID
+    };
+    static const char *collisionModeName(CollisionMode mode);
+    static bool parseCollisionMode(const QString &name, CollisionMode &mode);
+
+    // Genauigkeit von Kick, Drift und RK4-Stufen. Kraefte, Kollisionen und Snapshots rechnen immer auf den
+    // float-Spalten; im Double-Modus ergaenzen Restspalten sie zum exakten double-Zustand.
+    enum class Precision {
+        Float,  // Zustand und Arithmetik in float (schnellster Pfad)
+        Mixed,  // Zustand in float, Arithmetik je Schritt in double
+        Double  // Arithmetik in double, Zustand als float-Spalte plus double-Rest (exakt double)
+    };
+    static const char *precisionName(Precision precision);
+    static bool parsePrecision(const QString &name, Precision &precision);
+
+    static constexpr quint32 invalidMarkerId = 0xffffffffu;
+
+    // Strukturelle Aenderung der Markerspalten; Indizes beziehen sich auf den Zustand direkt vor der Aenderung
+    struct StructureChange {
+        enum Kind : quint8 {
+            Reset,   // alle Marker entfernt
+            Append,  // count Marker ab index angehaengt
+            Remove   // Marker index entfernt, der bisher letzte Marker (movedFrom) rueckt an seine Stelle
+        };
+        Kind kind;
+        int index;
+        int count;            // Append
+        int movedFrom;        // Remove: -1, wenn der letzte Marker selbst entfernt wurde
+        quint32 id;           // Remove: ID des entfernten Markers
+        quint32 mergedInto;   // Remove: ID des aufnehmenden Markers oder invalidMarkerId
+    };
+    // Volle Kraftauswertungen je Schritt; beim Block-Integrator nur ein Richtwert
+    static int forceEvaluationsPerStep(Integrator integrator);
+
+    SimulationCore();
+
+    int size() const { return static_cast<int>(posX.size()); }
+    bool isEmpty() const { return posX.isEmpty(); }
+
+    void clear();
+    void reserve(int count);
+    int addMarker(const Vec3 &position, const Vec3 &velocity, float radius, float density, quint32 color);
+    // Swap-Remove: der letzte Marker rueckt an die Stelle von index, alle anderen Indizes bleiben gueltig
+    void removeMarker(int index);
+
+    // Spaltenweiser Massenimport (z. B. aus einer gemappten .grvb-Datei); ersetzt alle Marker.
+    // Positionen werden wie in addMarker() normiert und muessen endlich und ungleich 0 sein (prueft der Aufrufer),
+    // die Masse wird aus Radius und Dichte berechnet.
+    struct ColumnData {
+        const float *posX;
+        const float *posY;
+        const float *posZ;
+        const float *velX;
+        const float *velY;
+        const float *velZ;
+        const float *radii;
+        const float *densities;
+        const quint32 *colors;
+    };
+    void assignColumns(int count, const ColumnData &columns);
+    // Haengt settings.count Marker an; parallel ueber den WorkerPool. Ergebnis haengt nur von Seed, Einstellungen
+    // und den vergebenen Marker-IDs ab (gleich in einem frischen Kern, verschieden bei jedem weiteren Stapel)
+    void generateMarkers(const MarkerGenerator::Settings &settings);
+
+    // Ein Zeitschritt: advance() und anschliessend handleCollisions()
+    void step(float deltaSeconds);
+    // Nur Bewegung mit dem gewaehlten Integrator, ohne Kollisionen; merkt sich die Startpositionen
+    void advance(float deltaSeconds);
+    void computeAccelerations();
+    void integrate(float deltaSeconds);
+    // Ueberlappungen am Schrittende; nach advance() zusaetzlich Kontakte entlang der Bahn (siehe continuousCollisions)
+    void handleCollisions();
+
+    // Kontinuierliche Kollisionserkennung: Marker, die sich in einem Schritt weiter als ihren Radius bewegen,
+    // werden entlang des Grosskreisbogens zwischen Start- und Endposition geprueft und zum Aufprallzeitpunkt
+    // aufgeloest. Ohne schnelle Marker kostet das nur einen Durchlauf ueber alle Positionen.
+    bool continuousCollisions() const { return continuousCollisionsEnabled; }
+    void setContinuousCollisions(bool enabled) { continuousCollisionsEnabled = enabled; }
+    // Im letzten handleCollisions() zum Aufprallzeitpunkt aufgeloeste Paare
+    int sweptContactCount() const { return sweptContacts; }
+
+    CollisionMode collisionMode() const { return collisionKind; }
+    void setCollisionMode(CollisionMode mode) { collisionKind = mode; }
+    // Im letzten handleCollisions() verschmolzene Paare
+    int mergeCount() const { return merges; }
+    // Im letzten handleCollisions() aufgeloeste Stoesse: elastisch abgeprallte (sich annaehernde) Paare plus
+    // verschmolzene Paare, am Schrittende und waehrend des Schritts; ruhende Kontakte zaehlen nicht
+    int collisionCount() const { return elasticImpacts + merges; }
+
+    // Protokoll struktureller Aenderungen (standardmaessig aus). structureVersion() zaehlt alle protokollierten
+    // Aenderungen; structureLog() enthaelt die Eintraege ab structureLogStart(), bis trimStructureLog() sie verwirft.
+    void setStructureLogging(bool enabled);
+    quint64 structureVersion() const { return structureLogBase + quint64(structureChanges.size()); }
+    quint64 structureLogStart() const { return structureLogBase; }
+    const QVector<StructureChange> &structureLog() const { return structureChanges; }
+    void trimStructureLog(quint64 version);
+
+    Integrator integrator() const { return integratorKind; }
+    void setIntegrator(Integrator value) { integratorKind = value; }
+
+    Precision precision() const { return precisionKind; }
+    // Beim Wechsel zu Double beginnt der exakte Zustand beim aktuellen float-Wert
+    void setPrecision(Precision value);
+
+    // Block-Integrator: Marker i laeuft mit dt / 2^k, k <= blockMaxLevel, gewaehlt aus
+    // h = blockAccuracy * min(sqrt(d/|a|), d/|v - v_n|) mit d = Abstand zum naechsten Nachbarn n
+    int blockMaxLevel() const { return maxBlockLevel; }
+    void setBlockMaxLevel(int levels) { maxBlockLevel = qBound(0, levels, 16); }
+    float blockAccuracy() const { return blockEta; }
+    void setBlockAccuracy(float eta) { blockEta = qMax(1e-4f, eta); }
+    // Stufe k je Marker aus dem letzten Block-Schritt (leer fuer andere Integratoren)
+    const QVector<quint8> &blockLevels() const { return levels; }
+
+    // Anzahl berechneter Einzelbeschleunigungen seit Erzeugung; geteilt durch size() = volle Kraftauswertungen
+    quint64 accelerationEvaluations() const { return evaluatedAccelerations; }
+
+    // Gravitationspotential U = -G*mi*mj*(1/s + 1/(2*pi - s)) beim Bogenabstand s, passend zum Kraftgesetz;
+    // im Double-Modus aus dem exakten Zustand
+    double kineticEnergy() const;
+    double potentialEnergy() const;
+    double totalEnergy() const { return kineticEnergy() + potentialEnergy(); }
+
+    void setMarkerDensity(int index, float density);
+    void setMarkerRadius(int index, float radius);
+    void setMarkerVelocityMagnitude(int index, float magnitude);
+
+    float gravityConstant() const { return gravity; }
+    void setGravityConstant(float value) { gravity = value; accelerationsCurrent = false; }
+
+    ForceSolver forceSolver() const { return solver; }
+    void setForceSolver(ForceSolver value) { solver = value; accelerationsCurrent = false; }
+    float openingAngle() const { return theta; }
+    void setOpeningAngle(float value) { theta = qMax(0.0f, value); accelerationsCurrent = false; }
+
+    // Befehlssatz des direkten Kraft-Kernels; standardmaessig der beste verfuegbare
+    ForceKernels::InstructionSet instructionSet() const { return kernelIsa; }
+    void setInstructionSet(ForceKernels::InstructionSet isa) { kernelIsa = isa; accelerationsCurrent = false; }
+
+    // 0 = alle verfuegbaren Kerne, 1 = nur aufrufender Thread
+    int threadCount() const { return requestedThreads; }
+    void setThreadCount(int count);
+    int effectiveThreadCount() const;
+    // Kopien teilen den WorkerPool, dessen run() alle Aufrufer serialisiert; eine Kopie, die in einem anderen
+    // Thread parallel zum Original rechnen soll, loest sich damit und legt beim naechsten Bedarf einen eigenen an
+    void detachWorkerPool() { pool.reset(); }
+    // Unterhalb dieser Markeranzahl wird einfaedig gerechnet (Fork/Join-Aufwand ueberwiegt)
+    int parallelThreshold() const { return minParallelMarkers; }
+    void setParallelThreshold(int markers) { minParallelMarkers = qMax(0, markers); }
+
+    Vec3 position(int index) const { return Vec3(posX[index], posY[index], posZ[index]); }
+    Vec3 velocity(int index) const { return Vec3(velX[index], velY[index], velZ[index]); }
+    float radius(int index) const { return radii[index]; }
+    float density(int index) const { return densities[index]; }
+    float mass(int index) const { return masses[index]; }
+    quint32 color(int index) const { return colors[index]; }
+    bool isColliding(int index) const { return colliding[index]; }
+    // Bleibt fuer die Lebensdauer des Markers gleich und wird nie wiederverwendet (auch nicht nach clear())
+    quint32 markerId(int index) const { return ids[index]; }
+    // Index des Markers mit dieser ID oder -1 (lineare Suche, fuer Einzelbefehle aus der GUI)
+    int indexOfId(quint32 id) const { return static_cast<int>(ids.indexOf(id)); }
+
+    const float *positionsX() const { return posX.constData(); }
+    const float *positionsY() const { return posY.constData(); }
+    const float *positionsZ() const { return posZ.constData(); }
+    const float *velocitiesX() const { return velX.constData(); }
+    const float *velocitiesY() const { return velY.constData(); }
+    const float *velocitiesZ() const { return velZ.constData(); }
+    const float *radiusData() const { return radii.constData(); }
+    const float *densityData() const { return densities.constData(); }
+    const float *massData() const { return masses.constData(); }
+    const quint32 *colorData() const { return colors.constData(); }
+    const quint32 *idData() const { return ids.constData(); }
+    const QVector<bool> &collidingFlags() const { return colliding; }
+
+    // Marker-Anteil eines Szenarios (Version, Kugelradius, Marker-Array)
+    QJsonObject exportScenario() const;
+    bool applyScenario(const QJsonObject &scenario);
+
+    // Checkpoints (CheckpointStore), jeweils zwischen zwei Schritten: parameterCopy() ist eine Kopie ohne
+    // Markerspalten und Arbeitspuffer (Parameter, Zaehler, ID-Zaehler), columnBytes() liefert alle Markerspalten
+    // als rohe Bytes in fester Reihenfolge. restoreCheckpoint() setzt beides wieder zusammen; Thread-Einstellungen
+    // und Strukturprotokoll dieses Kerns bleiben erhalten, protokolliert wird Reset und Append.
+    static constexpr int checkpointColumnCount = 21;
+    SimulationCore parameterCopy() const;
+    QVector<QByteArray> columnBytes() const;
+    // false, wenn die Spaltengroessen nicht zueinander oder zur Genauigkeit der Parameter passen
+    bool restoreCheckpoint(const SimulationCore &parameters, const QVector<QByteArray> &columns);
+
+    static constexpr float sphereRadius = 1.0f;
+
+private:
+    void setPosition(int index, const Vec3 &position);
+    void setVelocity(int index, const Vec3 &velocity);
+    void updateMass(int index);
+    void computeAccelerationsBruteForce();
+    void parallelFor(int count, const std::function<void(int begin, int end)> &task);
+    void computeAccelerationsBarnesHut();
+    // Schrittweiten in double, damit z. B. die Yoshida-Teilschritte im Double-Modus nicht auf float gerundet werden
+    void kick(double deltaSeconds);
+    void drift(double deltaSeconds);
+    void leapfrogStep(double deltaSeconds);
+    void blockStep(float deltaSeconds);
+    int assignBlockLevels(float deltaSeconds);
+    void computeAccelerationsFor(const int *indices, int count);
+    void kickBlock(const int *indices, int count, double deltaSeconds);
+    void rungeKuttaStep(double deltaSeconds);
+    // Schrittkerne je Genauigkeit; Traits waehlt Rechentyp und Restspalten (siehe simulationcore.cpp)
+    template <typename Function> void dispatchPrecision(Function &&function);
+    template <typename Traits> void integrateAs(double deltaSeconds);
+    template <typename Traits> void kickAs(double deltaSeconds);
+    template <typename Traits> void driftAs(double deltaSeconds);
+    template <typename Traits> void kickBlockAs(const int *indices, int count, double deltaSeconds);
+    template <typename Traits> void rungeKuttaStepAs(double deltaSeconds);
+    template <typename Real> Real *rungeKuttaBuffer(int size);
+    bool hasResiduals() const { return precisionKind == Precision::Double; }
+    void resizeResiduals();
+    Vec3d exactPosition(int index) const;
+    Vec3d exactVelocity(int index) const;
+    void resolveCollision(int i, int j);
+    // Elastischer Stoss entlang der Verbindungslinie, nur wenn sich die Marker annaehern
+    void exchangeContactVelocities(int i, int j);
+    // Verschmilzt i und j in den schwereren Marker und liefert dessen Index; der andere wird nur markiert
+    int mergeMarkers(int i, int j);
+    bool isAbsorbed(int index) const { return absorbedBy[index] >= 0; }
+    void removeAbsorbedMarkers();
+    void swapRemove(int index, quint32 mergedInto);
+    void logStructureChange(const StructureChange &change);
+
+    // Bahn eines Markers im letzten Schritt: Grosskreisbogen von start (Schrittanteil startFraction) bis end (1),
+    // also eine Drehung mit konstanter Winkelgeschwindigkeit spin (je Schrittanteil)
+    struct SweptPath {
+        Vec3 start;
+        Vec3 end;
+        float startFraction;
+        float angle;
+        Vec3 spin;         // Null bei (nahezu) antipodaler Bahn, dann gilt nur |spin| <= angle / (1 - startFraction)
+
+        SweptPath() : startFraction(0.0f), angle(0.0f) {}
+        SweptPath(const Vec3 &from, const Vec3 &to, float fraction);
+        float rate() const { return angle / (1.0f - startFraction); }
+    };
+    struct SweptContact {
+        float fraction;
+        int i;
+        int j;
+    };
+    void resolveSweptCollisions(float maxRadius);
+    void findSweptContacts(float maxRadius);
+    bool sweptTimeOfImpact(int i, int j, float &fraction) const;
+    Vec3 sweptPosition(int index, float fraction) const;
+    void applySweptContact(const SweptContact &contact);
+
+    // Structure-of-Arrays: jede Eigenschaft liegt zusammenhaengend im Speicher
+    QVector<float> posX, posY, posZ;   // unit vector on sphere
+    QVector<float> velX, velY, velZ;   // tangent vector (units: sphere radii per second)
+    QVector<float> accX, accY, accZ;
+    bool accelerationsCurrent;         // accX/Y/Z passen zu den aktuellen Positionen und Massen
+    QVector<float> radii;
+    QVector<float> densities;
+    QVector<float> masses;             // density * radius^3
+    QVector<quint32> colors;           // 0xRRGGBB
+    QVector<bool> colliding;
+    QVector<quint32> ids;
+    quint32 nextId;
+
+    float gravity;
+    ForceSolver solver;
+    float theta;          // Oeffnungswinkel des Barnes-Hut-Verfahrens
+    Integrator integratorKind;
+    Precision precisionKind;
+    QVector<double> posResX, posResY, posResZ;  // nur Precision::Double: exakte Position = posX + posResX
+    QVector<double> velResX, velResY, velResZ;
+    QVector<float> rungeKuttaScratch;  // Startzustand, Stufensummen und Stufenpositionen (15 Spalten)
+    QVector<double> rungeKuttaScratchWide;  // dasselbe fuer die double-Varianten
+    int maxBlockLevel;
+    float blockEta;
+    QVector<quint8> levels;            // Block-Stufe je Marker
+    QVector<int> blockOrder;           // Markerindizes nach absteigender Stufe
+    QVector<float> nearestArc;         // Abstand zum naechsten Nachbarn (Sehne, untere Schranke des Bogens)
+    QVector<int> nearestIndex;         // naechster Nachbar oder -1
+    quint64 evaluatedAccelerations;
+    ForceKernels::InstructionSet kernelIsa;
+    SphereTree tree;
+    int requestedThreads;
+    int minParallelMarkers;
+    std::shared_ptr<WorkerPool> pool;  // wird von Kopien des Kerns geteilt (siehe detachWorkerPool)
+    CollisionGrid collisionGrid;
+    QVector<int> collisionCandidates;
+    bool continuousCollisionsEnabled;
+    bool sweepPending;                 // sweepX/Y/Z und sweepSeconds stammen vom letzten advance()
+    float sweepSeconds;
+    QVector<float> sweepX, sweepY, sweepZ;
+    QVector<SweptPath> sweptPaths;
+    QVector<quint8> sweepActive;       // Bahn muss (erneut) gegen alle Nachbarn geprueft werden
+    QVector<float> capX, capY, capZ;   // Mittelpunkt der Kappe, die die Bahn einschliesst
+    QVector<float> capAngles;          // Kappenradius (Bogenmass) inklusive Markerradius
+    QVector<float> capMedianScratch;
+    QVector<int> largeCaps;            // Kappen ausserhalb des Gitters, werden gegen alle Marker geprueft
+    QVector<quint8> isLargeCap;
+    QVector<SweptContact> sweptContactList;
+    int sweptContacts;
+    CollisionMode collisionKind;
+    int merges;
+    int elasticImpacts;
+    QVector<int> absorbedBy;           // waehrend handleCollisions: Index des aufnehmenden Markers oder -1
+    QVector<int> absorbedMarkers;      // Indizes der aufgenommenen Marker, werden am Ende entfernt
+    bool structureLogging;
+    quint64 structureLogBase;
+    QVector<StructureChange> structureChanges;
+};
+
+#endif // SIMULATIONCORE_H
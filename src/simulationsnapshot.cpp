@@ -0,0 +1,34 @@
+#include "simulationsnapshot.h"
+
+#include <algorithm>
+
+namespace {
+template <typename T>
+void copyColumn(QVector<T> &target, const T *source, int count)
+{
+    target.resize(count);
+    std::copy(source, source + count, target.data());
+}
+}
+
+void SimulationSnapshot::capture(const SimulationCore &core, double time, quint64 steps)
+{
+    const int n = core.size();
+    copyColumn(posX, core.positionsX(), n);
+    copyColumn(posY, core.positionsY(), n);
+    copyColumn(posZ, core.positionsZ(), n);
+    copyColumn(velX, core.velocitiesX(), n);
+    copyColumn(velY, core.velocitiesY(), n);
+    copyColumn(velZ, core.velocitiesZ(), n);
+    copyColumn(radii, core.radiusData(), n);
+    copyColumn(densities, core.densityData(), n);
+    copyColumn(colors, core.colorData(), n);
+    copyColumn(colliding, core.collidingFlags().constData(), n);
+    copyColumn(ids, core.idData(), n);
+    const QVector<SimulationCore::StructureChange> &log = core.structureLog();
+    copyColumn(structureChanges, log.constData(), static_cast<int>(log.size()));
+    structureLogStart = core.structureLogStart();
+    structureVersion = core.structureVersion();
+    simulationTime = time;
+    stepCount = steps;
+}
@@ -0,0 +1,56 @@
+#ifndef SIMULATIONSNAPSHOT_H
+#define SIMULATIONSNAPSHOT_H
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "simulationcore.h"
+#include "spheremath.h"
+
+/**
+ * @brief SimulationSnapshot - Unveraenderlicher Abzug des Simulationszustands fuer Render- und UI-Seite
+ *
+ * Verantwortlichkeiten:
+ * - Kopie der Positionen, Geschwindigkeiten, Radien, Dichten, Farben, Kollisionsflags und Marker-IDs nach einem Schritt
+ * - Noch nicht bestaetigte strukturelle Aenderungen (SimulationCore::StructureChange), damit die GUI ihre
+ *   indexparallelen Daten per Swap-Remove nachfuehren kann, auch wenn sie Zwischen-Snapshots ueberspringt
+ * - Abgedeckter Bereich der Checkpoints fuer das Zuruecksetzen aus der GUI
+ * - Wiederverwendung der Puffer zwischen Veroeffentlichungen (keine Allokation bei gleicher Markeranzahl)
+ * - Wird vom Simulations-Thread geschrieben und nach publish() nur noch vom GUI-Thread gelesen
+ */
+struct SimulationSnapshot {
+    QVector<float> posX, posY, posZ;
+    QVector<float> velX, velY, velZ;
+    QVector<float> radii;
+    QVector<float> densities;
+    QVector<quint32> colors;
+    QVector<bool> colliding;
+    QVector<quint32> ids;
+    // Aenderungen mit den Versionen structureLogStart .. structureVersion - 1
+    QVector<SimulationCore::StructureChange> structureChanges;
+    quint64 structureLogStart = 0;
+    quint64 structureVersion = 0;
+    double simulationTime = 0.0;
+    quint64 stepCount = 0;
+    quint64 commandSequence = 0; // Anzahl der vor diesem Abzug ausgefuehrten Befehle (siehe SimulationThread::post)
+
+    // Abgedeckter Bereich der Checkpoints (siehe SimulationThread::seekCheckpoint)
+    struct CheckpointRange {
+        quint64 firstStep = 0;
+        quint64 lastStep = 0;
+        double firstTime = 0.0;
+        double lastTime = 0.0;
+        int count = 0;
+        qint64 bytes = 0;
+        bool replaying = false;  // protokollierte Schritte werden nach einem Zuruecksetzen wiederholt
+    };
+    CheckpointRange checkpoints;
+
+    int size() const { return static_cast<int>(posX.size()); }
+    Vec3 position(int index) const { return Vec3(posX[index], posY[index], posZ[index]); }
+    Vec3 velocity(int index) const { return Vec3(velX[index], velY[index], velZ[index]); }
+
+    void capture(const SimulationCore &core, double time, quint64 steps);
+};
+
+#endif // SIMULATIONSNAPSHOT_H
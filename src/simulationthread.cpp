@@ -0,0 +1,239 @@
+#include "simulationthread.h"
+#include "frameprofiler.h"
+#include "trajectoryrecorder.h"
+
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QTimer>
+
+class SimulationThread::Worker : public QObject {
+public:
+    Worker(TripleBuffer<SimulationSnapshot> &snapshots, const std::atomic<quint64> &acknowledgedStructure)
+        : snapshots(snapshots),
+          acknowledgedStructure(acknowledgedStructure),
+          timer(new QTimer(this)),
+          lastFrameMs(0),
+          timeScale(1.0f),
+          simulationTime(0.0),
+          stepCount(0),
+          executedCommands(0),
+          publishScheduled(false),
+          replaying(false)
+    {
+        timer->setInterval(16); // ~60 FPS
+        QObject::connect(timer, &QTimer::timeout, this, [this]() { tick(); });
+        core.setStructureLogging(true);
+    }
+
+    void setRunning(bool running)
+    {
+        if (running) {
+            frameTimer.start();
+            lastFrameMs = frameTimer.elapsed();
+            timer->start();
+        } else {
+            timer->stop();
+        }
+    }
+
+    void tick()
+    {
+        const qint64 nowMs = frameTimer.elapsed();
+        const float deltaSeconds = qMax(0.0f, (nowMs - lastFrameMs) / 1000.0f);
+        lastFrameMs = nowMs;
+
+        // Wende Zeitskalierung an
+        const float scaledDelta = deltaSeconds * timeScale;
+        if (scaledDelta <= 0.0f) {
+            return;
+        }
+
+        FrameProfiler::Scope profile(FrameProfiler::SimulationStep);
+        if (replaying) {
+            // Nach dem Zuruecksetzen die protokollierten Schrittweiten wiederholen (bitgleich zum ersten Lauf)
+            replaying = checkpoints.replayStep(core, simulationTime, stepCount);
+        }
+        if (!replaying) {
+            checkpoints.recordStep(core, simulationTime, stepCount, scaledDelta);
+            core.step(scaledDelta);
+            simulationTime += scaledDelta;
+            ++stepCount;
+        }
+        if (recorder) {
+            recorder->record(core, simulationTime, stepCount);
+        }
+        publish();
+    }
+
+    // Ein Befehl hat den Kern ausserhalb von step() veraendert
+    void commandExecuted()
+    {
+        ++executedCommands;
+        checkpoints.markChanged(stepCount, simulationTime);
+        replaying = false;
+    }
+
+    bool seek(quint64 step)
+    {
+        // Die Aufzeichnung ist streng fortlaufend; waehrenddessen wird nicht zurueckgesetzt
+        if (recorder) {
+            return false;
+        }
+        checkpoints.flush(core, simulationTime, stepCount);
+        if (!checkpoints.seek(step, core, simulationTime)) {
+            return false;
+        }
+        stepCount = step;
+        replaying = stepCount < checkpoints.lastStep();
+        publish();
+        return true;
+    }
+
+    void publish()
+    {
+        FrameProfiler::Scope profile(FrameProfiler::SnapshotPublish);
+        // Bestaetigte Aenderungen verwerfen; bestaetigt die GUI nicht (z. B. waehrend der Wiedergabe), das Protokoll
+        // begrenzen. Die GUI baut ihre Ansichten dann vollstaendig neu auf.
+        quint64 keepFrom = acknowledgedStructure.load(std::memory_order_relaxed);
+        if (core.structureVersion() - qMin(keepFrom, core.structureVersion()) > maxPendingStructureChanges) {
+            keepFrom = core.structureVersion() - maxPendingStructureChanges;
+        }
+        core.trimStructureLog(keepFrom);
+
+        SimulationSnapshot &snapshot = snapshots.writeBuffer();
+        snapshot.capture(core, simulationTime, stepCount);
+        snapshot.commandSequence = executedCommands;
+        snapshot.checkpoints.firstStep = checkpoints.firstStep();
+        snapshot.checkpoints.lastStep = checkpoints.lastStep();
+        snapshot.checkpoints.firstTime = checkpoints.firstTime();
+        snapshot.checkpoints.lastTime = checkpoints.lastTime();
+        snapshot.checkpoints.count = checkpoints.checkpointCount();
+        snapshot.checkpoints.bytes = checkpoints.memoryUsage();
+        snapshot.checkpoints.replaying = replaying;
+        snapshots.publish();
+    }
+
+    // Mehrere kurz hintereinander eingereihte Befehle teilen sich eine Veroeffentlichung
+    void schedulePublish()
+    {
+        if (publishScheduled) {
+            return;
+        }
+        publishScheduled = true;
+        QMetaObject::invokeMethod(this, [this]() {
+            publishScheduled = false;
+            publish();
+        }, Qt::QueuedConnection);
+    }
+
+    static constexpr quint64 maxPendingStructureChanges = 65536;
+
+    SimulationCore core;
+    CheckpointStore checkpoints;
+    std::shared_ptr<TrajectoryRecorder> recorder;
+    TripleBuffer<SimulationSnapshot> &snapshots;
+    const std::atomic<quint64> &acknowledgedStructure;
+    QTimer *timer;
+    QElapsedTimer frameTimer;
+    qint64 lastFrameMs;
+    float timeScale;
+    double simulationTime;
+    quint64 stepCount;
+    quint64 executedCommands;
+    bool publishScheduled;
+    bool replaying;         // Schritte kommen aus dem Checkpoint-Protokoll statt aus der Wanduhr
+};
+
+SimulationThread::SimulationThread()
+    : postedCommands(0),
+      acknowledgedStructure(0),
+      worker(new Worker(snapshots, acknowledgedStructure))
+{
+    thread.setObjectName("SimulationThread");
+    worker->moveToThread(&thread);
+    QObject::connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread.start();
+
+    postBlocking([](SimulationCore &) {
+        FrameProfiler::setThreadName("Simulation");
+    });
+}
+
+SimulationThread::~SimulationThread()
+{
+    thread.quit();
+    thread.wait();
+}
+
+quint64 SimulationThread::post(Command command)
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, command = std::move(command)]() {
+        command(w->core);
+        w->commandExecuted();
+        w->schedulePublish();
+    }, Qt::QueuedConnection);
+    return ++postedCommands;
+}
+
+quint64 SimulationThread::postBlocking(Command command)
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, &command]() {
+        command(w->core);
+        w->commandExecuted();
+        w->publish();
+    }, Qt::BlockingQueuedConnection);
+    return ++postedCommands;
+}
+
+void SimulationThread::query(Query query) const
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, &query]() {
+        query(w->core);
+    }, Qt::BlockingQueuedConnection);
+}
+
+void SimulationThread::setRunning(bool running)
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, running]() {
+        w->setRunning(running);
+    }, Qt::QueuedConnection);
+}
+
+void SimulationThread::setTimeScale(float scale)
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, scale]() {
+        w->timeScale = scale;
+    }, Qt::QueuedConnection);
+}
+
+void SimulationThread::setRecorder(std::shared_ptr<TrajectoryRecorder> recorder)
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, &recorder]() {
+        w->recorder = std::move(recorder);
+    }, Qt::BlockingQueuedConnection);
+}
+
+void SimulationThread::setCheckpointOptions(const CheckpointStore::Options &options)
+{
+    Worker *w = worker;
+    QMetaObject::invokeMethod(w, [w, options]() {
+        w->checkpoints.setOptions(options);
+        w->schedulePublish();
+    }, Qt::QueuedConnection);
+}
+
+bool SimulationThread::seekCheckpoint(quint64 step)
+{
+    Worker *w = worker;
+    bool found = false;
+    QMetaObject::invokeMethod(w, [w, step, &found]() {
+        found = w->seek(step);
+    }, Qt::BlockingQueuedConnection);
+    return found;
+}
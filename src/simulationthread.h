@@ -0,0 +1,75 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "checkpointstore.h"
+#include "simulationcore.h"
+#include "simulationsnapshot.h"
+#include "triplebuffer.h"
+
+class TrajectoryRecorder;
+
+/**
+ * @brief SimulationThread - Fuehrt den SimulationCore auf einem eigenen Thread aus
+ *
+ * Verantwortlichkeiten:
+ * - Zeitgesteuertes Schrittweiten der Simulation (~60 Hz) unabhaengig vom GUI-Thread
+ * - Veroeffentlichung unveraenderlicher Zustands-Snapshots ueber einen lock-freien Dreifachpuffer
+ * - Ausfuehrung von Aenderungen (Dichte, Radius, Parameter) als Befehle in der Warteschlange des Simulations-Threads
+ * - Blockierende Befehle fuer strukturelle Aenderungen (Erzeugen, Laden, Loeschen), nach denen sofort ein Snapshot vorliegt
+ * - Uebergabe jedes Schritts an einen optionalen TrajectoryRecorder
+ * - Checkpoints der laufenden Simulation (CheckpointStore): Zuruecksetzen auf einen frueheren Schritt, danach
+ *   werden die protokollierten Schritte bitgleich wiederholt, bis ein Befehl die aufgezeichnete Zukunft verwirft
+ * - Protokoll struktureller Aenderungen (Verschmelzen, Entfernen) bleibt im Snapshot, bis die GUI es bestaetigt
+ */
+class SimulationThread {
+public:
+    using Command = std::function<void(SimulationCore &)>;
+    using Query = std::function<void(const SimulationCore &)>;
+
+    SimulationThread();
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator=(const SimulationThread &) = delete;
+
+    // Asynchron; wird vor dem naechsten Schritt auf dem Simulations-Thread ausgefuehrt.
+    // Liefert die Befehlsnummer: ab snapshot().commandSequence >= Nummer ist die Aenderung sichtbar
+    quint64 post(Command command);
+    // Wartet, bis der Befehl ausgefuehrt und ein neuer Snapshot veroeffentlicht wurde
+    quint64 postBlocking(Command command);
+    // Blockierender, nur lesender Zugriff auf den Kern (z. B. fuer den Szenario-Export)
+    void query(Query query) const;
+
+    void setRunning(bool running);
+    void setTimeScale(float scale);
+    // Blockierend: nach der Rueckkehr greift der Simulations-Thread nicht mehr auf den alten Recorder zu
+    void setRecorder(std::shared_ptr<TrajectoryRecorder> recorder);
+
+    // Standardmaessig an (CheckpointStore::Options); Budget 0 schaltet die Checkpoints ab
+    void setCheckpointOptions(const CheckpointStore::Options &options);
+    // Blockierend: setzt den Zustand auf den Schritt step zurueck (Bereich siehe snapshot().checkpoints).
+    // false, wenn step nicht abgedeckt ist oder gerade aufgezeichnet wird.
+    bool seekCheckpoint(quint64 step);
+
+    // Nur GUI-Thread: holt den neuesten Snapshot, true wenn er sich seit dem letzten Aufruf geaendert hat
+    bool updateSnapshot() { return snapshots.update(); }
+    const SimulationSnapshot &snapshot() const { return snapshots.readBuffer(); }
+    // Die GUI hat alle strukturellen Aenderungen bis version uebernommen; aeltere Eintraege duerfen verworfen werden
+    void acknowledgeStructure(quint64 version) { acknowledgedStructure.store(version, std::memory_order_relaxed); }
+
+private:
+    class Worker;
+
+    TripleBuffer<SimulationSnapshot> snapshots;
+    quint64 postedCommands; // nur GUI-Thread; Befehle laufen in Einreihungsreihenfolge
+    std::atomic<quint64> acknowledgedStructure;
+    QThread thread;
+    Worker *worker;
+};
+
+#endif // SIMULATIONTHREAD_H
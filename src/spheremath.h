@@ -0,0 +1,72 @@
+#ifndef SPHEREMATH_H
+#define SPHEREMATH_H
+
+#include <QtGlobal>
+#include <QtMath>
+
+/**
+ * @brief Vec3T - Minimaler 3D-Vektor fuer den Simulationskern
+ *
+ * Verantwortlichkeiten:
+ * - Ersatz fuer QVector3D im Kern, damit dieser nur von Qt6::Core abhaengt
+ * - Grundoperationen (Skalarprodukt, Kreuzprodukt, Normierung) fuer Berechnungen auf der Einheitskugel
+ * - Skalartyp als Template-Parameter: Vec3 (float) fuer Speicher und Kraefte, Vec3d (double) fuer die
+ *   Integration in doppelter Genauigkeit (SimulationCore::Precision)
+ */
+template <typename T>
+struct Vec3T {
+    using Scalar = T;
+
+    T x;
+    T y;
+    T z;
+
+    Vec3T() : x(T(0)), y(T(0)), z(T(0)) {}
+    Vec3T(T x, T y, T z) : x(x), y(y), z(z) {}
+    template <typename U>
+    explicit Vec3T(const Vec3T<U> &o) : x(T(o.x)), y(T(o.y)), z(T(o.z)) {}
+
+    Vec3T operator+(const Vec3T &o) const { return Vec3T(x + o.x, y + o.y, z + o.z); }
+    Vec3T operator-(const Vec3T &o) const { return Vec3T(x - o.x, y - o.y, z - o.z); }
+    Vec3T operator-() const { return Vec3T(-x, -y, -z); }
+    Vec3T operator*(T s) const { return Vec3T(x * s, y * s, z * s); }
+    Vec3T &operator+=(const Vec3T &o) { x += o.x; y += o.y; z += o.z; return *this; }
+    Vec3T &operator-=(const Vec3T &o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+    Vec3T &operator*=(T s) { x *= s; y *= s; z *= s; return *this; }
+
+    T lengthSquared() const { return x * x + y * y + z * z; }
+    T length() const { return qSqrt(lengthSquared()); }
+
+    Vec3T normalized() const
+    {
+        const T len = length();
+        return len > T(0) ? Vec3T(x / len, y / len, z / len) : Vec3T();
+    }
+
+    static T dot(const Vec3T &a, const Vec3T &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    static Vec3T cross(const Vec3T &a, const Vec3T &b)
+    {
+        return Vec3T(a.y * b.z - a.z * b.y,
+                     a.z * b.x - a.x * b.z,
+                     a.x * b.y - a.y * b.x);
+    }
+};
+
+using Vec3 = Vec3T<float>;
+using Vec3d = Vec3T<double>;
+
+// Skalar nicht deduziert, damit z. B. 0.5 * Vec3 wie bisher nach float konvertiert
+template <typename T>
+inline Vec3T<T> operator*(typename Vec3T<T>::Scalar s, const Vec3T<T> &v) { return v * s; }
+
+// Rotation von v um die (normierte) Achse axis um angleRad (Rodrigues-Formel)
+template <typename T>
+inline Vec3T<T> rotateAroundAxis(const Vec3T<T> &v, const Vec3T<T> &axis, typename Vec3T<T>::Scalar angleRad)
+{
+    const T c = qCos(angleRad);
+    const T s = qSin(angleRad);
+    return v * c + Vec3T<T>::cross(axis, v) * s + axis * (Vec3T<T>::dot(axis, v) * (T(1) - c));
+}
+
+#endif // SPHEREMATH_H
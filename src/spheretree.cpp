@@ -0,0 +1,281 @@
+#include "spheretree.h"
+
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+// Seite des umschliessenden Wuerfels (0:+X 1:-X 2:+Y 3:-Y 4:+Z 5:-Z) und gnomonische Koordinaten (u, v) in [-1, 1]
+int cubeFace(float x, float y, float z, float &u, float &v)
+{
+    const float ax = qAbs(x);
+    const float ay = qAbs(y);
+    const float az = qAbs(z);
+
+    if (ax >= ay && ax >= az) {
+        const float inv = 1.0f / qMax(ax, 1e-12f);
+        u = y * inv;
+        v = z * inv;
+        return x >= 0.0f ? 0 : 1;
+    }
+    if (ay >= az) {
+        const float inv = 1.0f / qMax(ay, 1e-12f);
+        u = z * inv;
+        v = x * inv;
+        return y >= 0.0f ? 2 : 3;
+    }
+    const float inv = 1.0f / qMax(az, 1e-12f);
+    u = x * inv;
+    v = y * inv;
+    return z >= 0.0f ? 4 : 5;
+}
+
+float safeAcos(float dot)
+{
+    return qAcos(qBound(-1.0f, dot, 1.0f));
+}
+}
+
+SphereTree::SphereTree()
+    : px(nullptr),
+      py(nullptr),
+      pz(nullptr),
+      pm(nullptr),
+      markerCount(0)
+{
+}
+
+void SphereTree::build(const float *posX, const float *posY, const float *posZ, const float *masses, int count)
+{
+    px = posX;
+    py = posY;
+    pz = posZ;
+    pm = masses;
+    markerCount = count;
+
+    nodes.clear();
+    roots.clear();
+    order.resize(count);
+    scratch.resize(count);
+    faceU.resize(count);
+    faceV.resize(count);
+
+    if (count <= 0) {
+        return;
+    }
+
+    // Marker per Counting-Sort nach Wuerfelseite gruppieren
+    QVector<int> faceOf(count);
+    int faceCount[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < count; ++i) {
+        faceOf[i] = cubeFace(posX[i], posY[i], posZ[i], faceU[i], faceV[i]);
+        ++faceCount[faceOf[i]];
+    }
+
+    int faceStart[6];
+    int offset = 0;
+    for (int f = 0; f < 6; ++f) {
+        faceStart[f] = offset;
+        offset += faceCount[f];
+    }
+
+    int cursor[6];
+    std::copy(faceStart, faceStart + 6, cursor);
+    for (int i = 0; i < count; ++i) {
+        order[cursor[faceOf[i]]++] = i;
+    }
+
+    for (int f = 0; f < 6; ++f) {
+        if (faceCount[f] == 0) {
+            continue;
+        }
+        const int root = static_cast<int>(nodes.size());
+        nodes.append(Node{});
+        buildNode(root, faceStart[f], faceCount[f], -1.0f, -1.0f, 2.0f, 0);
+        roots.append(root);
+    }
+}
+
+int SphereTree::buildNode(int nodeIndex, int start, int count, float u0, float v0, float extent, int depth)
+{
+    {
+        Node &node = nodes[nodeIndex];
+        node.start = start;
+        node.count = count;
+        node.firstChild = -1;
+    }
+
+    // Massenschwerpunkt-Richtung ueber alle enthaltenen Marker
+    float sumX = 0.0f;
+    float sumY = 0.0f;
+    float sumZ = 0.0f;
+    float mass = 0.0f;
+    for (int k = start; k < start + count; ++k) {
+        const int i = order[k];
+        const float m = pm[i];
+        sumX += m * px[i];
+        sumY += m * py[i];
+        sumZ += m * pz[i];
+        mass += m;
+    }
+    if (sumX * sumX + sumY * sumY + sumZ * sumZ < 1e-20f) {
+        sumX = sumY = sumZ = 0.0f;
+        for (int k = start; k < start + count; ++k) {
+            const int i = order[k];
+            sumX += px[i];
+            sumY += py[i];
+            sumZ += pz[i];
+        }
+    }
+    const float invLen = 1.0f / qMax(qSqrt(sumX * sumX + sumY * sumY + sumZ * sumZ), 1e-20f);
+    {
+        Node &node = nodes[nodeIndex];
+        node.centerX = sumX * invLen;
+        node.centerY = sumY * invLen;
+        node.centerZ = sumZ * invLen;
+        node.mass = mass;
+    }
+
+    if (count <= leafSize || depth >= maxDepth) {
+        finalizeLeaf(nodes[nodeIndex]);
+        return nodeIndex;
+    }
+
+    // Aufteilung in vier Quadranten der (u, v)-Ebene
+    const float half = extent * 0.5f;
+    const float uMid = u0 + half;
+    const float vMid = v0 + half;
+
+    int quadrantCount[4] = {0, 0, 0, 0};
+    for (int k = start; k < start + count; ++k) {
+        const int i = order[k];
+        const int q = (faceU[i] >= uMid ? 1 : 0) + (faceV[i] >= vMid ? 2 : 0);
+        ++quadrantCount[q];
+    }
+
+    int quadrantStart[4];
+    quadrantStart[0] = start;
+    for (int q = 1; q < 4; ++q) {
+        quadrantStart[q] = quadrantStart[q - 1] + quadrantCount[q - 1];
+    }
+
+    int cursor[4];
+    std::copy(quadrantStart, quadrantStart + 4, cursor);
+    for (int k = start; k < start + count; ++k) {
+        const int i = order[k];
+        const int q = (faceU[i] >= uMid ? 1 : 0) + (faceV[i] >= vMid ? 2 : 0);
+        scratch[cursor[q]++] = i;
+    }
+    std::copy(scratch.begin() + start, scratch.begin() + start + count, order.begin() + start);
+
+    const int firstChild = static_cast<int>(nodes.size());
+    nodes[nodeIndex].firstChild = firstChild;
+    for (int q = 0; q < 4; ++q) {
+        Node empty{};
+        empty.firstChild = -1;
+        nodes.append(empty);
+    }
+
+    for (int q = 0; q < 4; ++q) {
+        const float cu = u0 + ((q & 1) ? half : 0.0f);
+        const float cv = v0 + ((q & 2) ? half : 0.0f);
+        buildNode(firstChild + q, quadrantStart[q], quadrantCount[q], cu, cv, half, depth + 1);
+    }
+
+    // Winkelradius aus den Kindern abschaetzen
+    Node &node = nodes[nodeIndex];
+    float radius = 0.0f;
+    for (int q = 0; q < 4; ++q) {
+        const Node &child = nodes[firstChild + q];
+        if (child.count == 0) {
+            continue;
+        }
+        const float dot = node.centerX * child.centerX + node.centerY * child.centerY + node.centerZ * child.centerZ;
+        radius = qMax(radius, safeAcos(dot) + child.angularRadius);
+    }
+    node.angularRadius = radius;
+    return nodeIndex;
+}
+
+void SphereTree::finalizeLeaf(Node &node) const
+{
+    float radius = 0.0f;
+    for (int k = node.start; k < node.start + node.count; ++k) {
+        const int i = order[k];
+        const float dot = node.centerX * px[i] + node.centerY * py[i] + node.centerZ * pz[i];
+        radius = qMax(radius, safeAcos(dot));
+    }
+    node.angularRadius = radius;
+}
+
+void SphereTree::computeAccelerations(int begin, int end, float gravityConstant, float openingAngle,
+                                      float *accX, float *accY, float *accZ) const
+{
+    constexpr float epsilon = 1e-4f;
+    const float fullCircle = static_cast<float>(2.0 * M_PI);
+
+    // Stapeltiefe: sechs Wurzeln plus drei offene Geschwister pro Ebene
+    constexpr int stackCapacity = 6 + 3 * (maxDepth + 1) + 4;
+    int stack[stackCapacity];
+
+    auto accumulate = [&](float pax, float pay, float paz, float pbx, float pby, float pbz, float mb,
+                          float &ax, float &ay, float &az) {
+        const float dot = qBound(-1.0f, pax * pbx + pay * pby + paz * pbz, 1.0f);
+        const float tangentLengthSq = 1.0f - dot * dot;
+        if (tangentLengthSq < epsilon) {
+            return;
+        }
+        const float arc = qMax(qAcos(dot), epsilon);
+        const float otherArc = qMax(fullCircle - arc, epsilon);
+        const float scale = gravityConstant * mb * ((1.0f / (arc * arc)) - (1.0f / (otherArc * otherArc)))
+                          / qSqrt(tangentLengthSq);
+        ax += scale * (pbx - dot * pax);
+        ay += scale * (pby - dot * pay);
+        az += scale * (pbz - dot * paz);
+    };
+
+    for (int i = begin; i < end; ++i) {
+        const float pax = px[i];
+        const float pay = py[i];
+        const float paz = pz[i];
+        float ax = 0.0f;
+        float ay = 0.0f;
+        float az = 0.0f;
+
+        int top = 0;
+        for (int root : roots) {
+            stack[top++] = root;
+        }
+
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            if (node.count == 0) {
+                continue;
+            }
+
+            if (node.firstChild < 0) {
+                for (int k = node.start; k < node.start + node.count; ++k) {
+                    const int j = order[k];
+                    if (j != i) {
+                        accumulate(pax, pay, paz, px[j], py[j], pz[j], pm[j], ax, ay, az);
+                    }
+                }
+                continue;
+            }
+
+            const float dot = pax * node.centerX + pay * node.centerY + paz * node.centerZ;
+            const float arc = safeAcos(dot);
+            if (node.angularRadius < openingAngle * arc) {
+                accumulate(pax, pay, paz, node.centerX, node.centerY, node.centerZ, node.mass, ax, ay, az);
+                continue;
+            }
+
+            for (int q = 0; q < 4; ++q) {
+                stack[top++] = node.firstChild + q;
+            }
+        }
+
+        accX[i] = ax;
+        accY[i] = ay;
+        accZ[i] = az;
+    }
+}
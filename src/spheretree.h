@@ -0,0 +1,60 @@
+#ifndef SPHERETREE_H
+#define SPHERETREE_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief SphereTree - Hierarchische Zerlegung der Kugeloberflaeche fuer die Barnes-Hut-Kraftberechnung
+ *
+ * Verantwortlichkeiten:
+ * - Aufteilung der Marker auf die sechs Seiten eines Cube-Sphere und je einen Quadtree pro Seite
+ * - Aggregation von Gesamtmasse, Massenschwerpunkt-Richtung und Winkelradius pro Knoten
+ * - Naeherung weit entfernter Knoten als Punktmasse, gesteuert ueber den Oeffnungswinkel
+ * - Gleiches Kraftgesetz wie die direkte Summation (1/arc^2 - 1/(2*pi - arc)^2)
+ */
+class SphereTree {
+public:
+    SphereTree();
+
+    void build(const float *posX, const float *posY, const float *posZ, const float *masses, int count);
+
+    // Beschleunigungen der Marker [begin, end) aus dem zuletzt gebauten Baum
+    void computeAccelerations(int begin, int end, float gravityConstant, float openingAngle,
+                              float *accX, float *accY, float *accZ) const;
+
+    int nodeCount() const { return static_cast<int>(nodes.size()); }
+
+    static constexpr int leafSize = 8;
+    static constexpr int maxDepth = 20;
+
+private:
+    struct Node {
+        float centerX;      // normierte Richtung des Massenschwerpunkts
+        float centerY;
+        float centerZ;
+        float mass;
+        float angularRadius; // obere Schranke fuer den Winkel zwischen Schwerpunkt und enthaltenen Markern
+        int firstChild;      // Index des ersten von vier Kindern, -1 fuer Blaetter
+        int start;           // Bereich in 'order'
+        int count;
+    };
+
+    int buildNode(int nodeIndex, int start, int count, float u0, float v0, float extent, int depth);
+    void finalizeLeaf(Node &node) const;
+
+    QVector<Node> nodes;
+    QVector<int> roots;      // ein Wurzelknoten pro Wuerfelseite (nur nicht-leere Seiten)
+    QVector<int> order;      // Markerindizes, nach Knoten gruppiert
+    QVector<int> scratch;
+    QVector<float> faceU;
+    QVector<float> faceV;
+
+    const float *px;
+    const float *py;
+    const float *pz;
+    const float *pm;
+    int markerCount;
+};
+
+#endif // SPHERETREE_H
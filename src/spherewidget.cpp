@@ -1,4 +1,10 @@
 #include "spherewidget.h"
+#include "instancedmarkerrenderer.h"
+#include "capgeometrycache.h"
+#include "scenariofile.h"
+#include "frameprofiler.h"
+#include "trajectoryrecorder.h"
+#include "trajectoryreader.h"
 
 #include <Qt3DCore/QEntity>
 #include <Qt3DCore/QTransform>
@@ -10,27 +16,35 @@
 #include <QTimer>
 #include <QDebug>
 #include <QtMath>
-#include <QRandomGenerator>
 #include <algorithm>
-#include <QJsonArray>
 
 SphereWidget::SphereWidget()
     : Qt3DExtras::Qt3DWindow(),
       sphereTransform(nullptr),
       cameraController(nullptr),
     rootEntity(nullptr),
+    instancedRenderer(nullptr),
+    instancedRendering(false),
+    instancingThreshold(500),
     animationTimer(nullptr),
     animationEnabled(true),
     highlightedMarkerIndex(-1),
     selectedMarkerIndex(-1),
+    highlightedMarkerId(SimulationCore::invalidMarkerId),
+    selectedMarkerId(SimulationCore::invalidMarkerId),
     followMarkerEnabled(false),
     followMarkerDistance(3.5f),
-    timeScale(1.0f)
+    timeScale(1.0f),
+    playbackActive(false),
+    playbackRunning(false),
+    playbackPosition(0.0),
+    playbackFrame(-1),
+    lastNotifiedStep(0),
+    appliedStructureVersion(0),
+    structureRebuild(true),
+    notifiedMarkerCount(0)
 {
     setTitle("Gravity Simulator - Qt3D");
-
-    frameTimer.start();
-    lastFrameMs = frameTimer.elapsed();
     
     // Setup camera first
     auto *camera = this->camera();
@@ -51,10 +65,18 @@ SphereWidget::SphereWidget()
     cameraController->setLookSpeed(180.0f);
     cameraController->setCamera(camera);
     
-    // Setup animation timer
+    // Die Simulation schreitet auf ihrem eigenen Thread voran; dieser Timer uebernimmt nur den neuesten Snapshot
     animationTimer = new QTimer(this);
     connect(animationTimer, &QTimer::timeout, this, &SphereWidget::updateFrame);
     animationTimer->start(16); // ~60 FPS
+
+    simulation.setRunning(animationEnabled);
+    FrameProfiler::setThreadName("GUI");
+}
+
+SphereWidget::~SphereWidget()
+{
+    stopRecording();
 }
 
 Qt3DCore::QEntity *SphereWidget::createScene()
@@ -67,6 +89,14 @@ Qt3DCore::QEntity *SphereWidget::createScene()
     // Create lighting and sphere
     createLighting(rootEntity);
     createSphere(rootEntity);
+
+    // Besitzer-Knoten der geteilten Kappen-Geometrien; Marker referenzieren sie nur
+    capGeometryCache = std::make_unique<CapGeometryCache>(new Qt3DCore::QNode(rootEntity), SimulationCore::sphereRadius);
+
+    // Instanzierter Renderer fuer grosse Markeranzahlen; bleibt deaktiviert bis zur Schwelle
+    instancedRenderer = new InstancedMarkerRenderer(rootEntity, SimulationCore::sphereRadius);
+    instancedRenderer->setEnabled(false);
+
     createMarkers(rootEntity);
     
     qDebug() << "Scene created successfully";
@@ -80,96 +110,311 @@ void SphereWidget::createMarkers(Qt3DCore::QEntity *rootEntity)
         return;
     }
 
-    generateMarkers(8, 0.5f, 0.1f, 1.0f);
+    MarkerGenerator::Settings settings;
+    settings.count = 8;
+    settings.speed = 0.5f;
+    settings.size = 0.1f;
+    settings.density = 1.0f;
+    generateMarkers(settings);
 }
 
-void SphereWidget::clearMarkers()
+void SphereWidget::destroyMarkerEntity(SurfaceMarker *marker)
 {
-    for (auto &state : markers) {
-        if (state.marker) {
-            if (auto *entity = state.marker->entity()) {
-                delete entity;
-            }
-            delete state.marker;
+    if (marker) {
+        if (auto *entity = marker->entity()) {
+            delete entity;
         }
+        delete marker;
+    }
+}
+
+void SphereWidget::destroyMarkerEntities()
+{
+    for (auto *marker : markerEntities) {
+        destroyMarkerEntity(marker);
+    }
+    markerEntities.clear();
+}
+
+void SphereWidget::resetMarkerViews()
+{
+    destroyMarkerEntities();
+    const bool hadMarkers = !markerColors.isEmpty();
+    markerColors.clear();
+    if (instancedRenderer) {
+        instancedRenderer->clear();
     }
-    markers.clear();
     highlightedMarkerIndex = -1;
     selectedMarkerIndex = -1;
+    highlightedMarkerId = SimulationCore::invalidMarkerId;
+    selectedMarkerId = SimulationCore::invalidMarkerId;
+    // Ausstehende Einzelaenderungen beziehen sich auf Indizes, die es nicht mehr gibt
+    pendingMarkerChanges.clear();
+    // Der naechste Live-Snapshot wird vollstaendig uebernommen, das Strukturprotokoll bis dahin uebersprungen
+    structureRebuild = true;
+    if (hadMarkers || notifiedMarkerCount != 0) {
+        notifiedMarkerCount = 0;
+        emit markerCountChanged(0);
+    }
+}
+
+void SphereWidget::clearMarkers()
+{
+    stopPlayback();
+    resetMarkerViews();
+    simulation.postBlocking([](SimulationCore &core) {
+        core.clear();
+    });
+    simulation.updateSnapshot();
 }
 
-void SphereWidget::generateMarkers(int count, float speed, float size, float density)
+void SphereWidget::generateMarkers(const MarkerGenerator::Settings &settings)
 {
     if (!rootEntity) {
         return;
     }
 
-    if (count <= 0) {
+    if (settings.count <= 0) {
         return;
     }
 
-    constexpr float sphereRadius = 1.0f;
-    auto *rng = QRandomGenerator::global();
+    stopPlayback();
+    MarkerGenerator::Settings generation = settings;
+    generation.color = QColor(120, 190, 255).rgb() & 0xffffff;
+    simulation.postBlocking([&generation](SimulationCore &core) {
+        core.generateMarkers(generation);
+    });
+    syncMarkerEntities();
+}
 
-    auto randRange = [rng](double minValue, double maxValue) {
-        return minValue + (maxValue - minValue) * rng->generateDouble();
+void SphereWidget::syncMarkerEntities()
+{
+    if (!playbackActive) {
+        simulation.updateSnapshot();
+        applyStructureChanges();
+    }
+    const SimulationSnapshot &snapshot = currentSnapshot();
+
+    // Neu hinzugekommene Simulations-Marker und Platzhalter aus dem Strukturprotokoll uebernehmen ihre Farbe
+    // aus der Simulation
+    const int knownCount = qMin(static_cast<int>(markerColors.size()), snapshot.size());
+    for (int i = 0; i < knownCount; ++i) {
+        if (!markerColors[i].isValid()) {
+            markerColors[i] = QColor::fromRgb(snapshot.colors[i]);
+        }
+    }
+    markerColors.reserve(snapshot.size());
+    for (int i = markerColors.size(); i < snapshot.size(); ++i) {
+        markerColors.append(QColor::fromRgb(snapshot.colors[i]));
+    }
+    // Erst melden, wenn die Ansichten zum neuen Bestand passen
+    auto notifyCount = [this]() {
+        if (markerColors.size() != notifiedMarkerCount) {
+            notifiedMarkerCount = static_cast<int>(markerColors.size());
+            emit markerCountChanged(notifiedMarkerCount);
+        }
     };
 
-    auto randomUnitVector = [&]() {
-        const float z = static_cast<float>(randRange(-1.0, 1.0));
-        const float t = static_cast<float>(randRange(0.0, 2.0 * M_PI));
-        const float r = qSqrt(qMax(0.0f, 1.0f - z * z));
-        return QVector3D(r * qCos(t), z, r * qSin(t)).normalized();
+    // Ab der Schwelle zeichnet der InstancedMarkerRenderer alle Marker in einem Draw-Call
+    instancedRendering = markerColors.size() >= instancingThreshold;
+    if (instancedRendering) {
+        destroyMarkerEntities();
+        instancedRenderer->setEnabled(true);
+        uploadInstances();
+        notifyCount();
+        return;
+    }
+
+    instancedRenderer->clear();
+    instancedRenderer->setEnabled(false);
+
+    // Erzeuge fehlende 3D-Marker fuer Platzhalter und neu hinzugekommene Simulations-Marker
+    const int count = qMin(snapshot.size(), static_cast<int>(markerColors.size()));
+    auto createMarker = [this, &snapshot](int i) {
+        const Vec3 position = snapshot.position(i);
+        auto *marker = new SurfaceMarker(rootEntity, capGeometryCache.get(), SimulationCore::sphereRadius, snapshot.radii[i], displayColor(i));
+        marker->setSurfaceNormal(QVector3D(position.x, position.y, position.z));
+        return marker;
     };
+    if (markerEntities.size() > count) {
+        for (int i = count; i < markerEntities.size(); ++i) {
+            destroyMarkerEntity(markerEntities[i]);
+        }
+        markerEntities.resize(count);
+    }
+    for (int i = 0; i < markerEntities.size(); ++i) {
+        if (!markerEntities[i]) {
+            markerEntities[i] = createMarker(i);
+        }
+    }
+    markerEntities.reserve(count);
+    for (int i = markerEntities.size(); i < count; ++i) {
+        markerEntities.append(createMarker(i));
+    }
+
+    notifyCount();
+}
+
+bool SphereWidget::applyStructureChanges()
+{
+    const SimulationSnapshot &snapshot = simulation.snapshot();
+    if (appliedStructureVersion == snapshot.structureVersion && !structureRebuild) {
+        return false;
+    }
+
+    const int begin = static_cast<int>(qMax(appliedStructureVersion, snapshot.structureLogStart) - snapshot.structureLogStart);
+    const int end = static_cast<int>(snapshot.structureVersion - snapshot.structureLogStart);
+    bool rebuild = structureRebuild || appliedStructureVersion < snapshot.structureLogStart;
+    for (int k = begin; k < end && !rebuild; ++k) {
+        rebuild = snapshot.structureChanges[k].kind == SimulationCore::StructureChange::Reset;
+    }
 
-    auto tangentDirection = [](const QVector3D &pos, const QVector3D &dir) {
-        QVector3D tangent = dir - QVector3D::dotProduct(dir, pos) * pos;
-        if (tangent.lengthSquared() < 1e-6f) {
-            tangent = QVector3D::crossProduct(pos, QVector3D(0.0f, 1.0f, 0.0f));
-            if (tangent.lengthSquared() < 1e-6f) {
-                tangent = QVector3D::crossProduct(pos, QVector3D(1.0f, 0.0f, 0.0f));
+    const int previousCount = markerColors.size();
+    bool removed = false;
+    if (!rebuild) {
+        // Einzelne Eintraege nachspielen: Anhaengen als Platzhalter, Entfernen per Swap-Remove wie im Kern
+        for (int k = begin; k < end; ++k) {
+            const SimulationCore::StructureChange &change = snapshot.structureChanges[k];
+            if (change.kind == SimulationCore::StructureChange::Append) {
+                const bool withEntities = !instancedRendering && markerEntities.size() == markerColors.size();
+                markerColors.insert(markerColors.size(), change.count, QColor());
+                if (withEntities) {
+                    markerEntities.insert(markerEntities.size(), change.count, nullptr);
+                }
+            } else if (change.kind == SimulationCore::StructureChange::Remove) {
+                removeMarkerView(change);
+                removed = true;
+            }
+        }
+        rebuild = markerColors.size() != snapshot.size();
+    }
+
+    if (rebuild) {
+        // Protokoll verworfen, zurueckgesetzt oder Ansichten nicht mehr passend: aus dem Snapshot neu aufbauen
+        if (!structureRebuild) {
+            resetMarkerViews();
+        }
+        structureRebuild = false;
+        appliedStructureVersion = snapshot.structureVersion;
+        simulation.acknowledgeStructure(appliedStructureVersion);
+        return true;
+    }
+
+    appliedStructureVersion = snapshot.structureVersion;
+    simulation.acknowledgeStructure(appliedStructureVersion);
+    if (!removed) {
+        return markerColors.size() != previousCount;
+    }
+
+    // Aufgenommene Auswahl geht auf den aufnehmenden Marker ueber
+    const MarkerStateView markers(snapshot);
+    auto resolve = [&markers](int &index, quint32 &id) {
+        if (id != SimulationCore::invalidMarkerId && index < 0) {
+            index = markers.indexOfId(id);
+            if (index < 0) {
+                id = SimulationCore::invalidMarkerId;
             }
         }
-        return tangent.normalized();
     };
+    resolve(selectedMarkerIndex, selectedMarkerId);
+    resolve(highlightedMarkerIndex, highlightedMarkerId);
+    // Ausstehende Einzelaenderungen sind an Indizes gebunden; nach dem Umsortieren alle Marker melden
+    for (PendingMarkerChange &change : pendingMarkerChanges) {
+        change.first = 0;
+        change.last = markerColors.size() - 1;
+    }
 
-    const QColor baseColor(120, 190, 255);
+    if (instancedRendering) {
+        // Farben stehen im Instanzpuffer noch an den alten Indizes: beim naechsten Upload alle neu setzen
+        instancedRenderer->resize(0);
+    } else {
+        updateMarkerColor(selectedMarkerIndex);
+        updateMarkerColor(highlightedMarkerIndex);
+    }
 
-    for (int i = 0; i < count; ++i) {
-        const QVector3D position = randomUnitVector();
-        const float latDeg = qRadiansToDegrees(qAsin(position.y()));
-        const float lonDeg = qRadiansToDegrees(qAtan2(position.z(), position.x()));
+    emit markerStructureChanged(snapshot.structureChanges.mid(begin, end - begin));
+    return true;
+}
 
-        auto *marker = new SurfaceMarker(rootEntity, sphereRadius, size, baseColor);
-        marker->setSphericalPosition(latDeg, lonDeg);
+void SphereWidget::removeMarkerView(const SimulationCore::StructureChange &change)
+{
+    const int last = markerColors.size() - 1;
+    if (change.index < 0 || change.index > last) {
+        return;
+    }
 
-        const QVector3D dir = randomUnitVector();
-        const QVector3D velocity = tangentDirection(position, dir) * speed;
+    const bool withEntities = markerEntities.size() == markerColors.size();
+    markerColors[change.index] = markerColors[last];
+    markerColors.removeLast();
+    if (withEntities && !markerEntities.isEmpty()) {
+        destroyMarkerEntity(markerEntities[change.index]);
+        markerEntities[change.index] = markerEntities[last];
+        markerEntities.removeLast();
+    }
 
-        markers.append({marker, position, velocity, size, density, baseColor});
+    // Auswahl und Hervorhebung folgen dem Index; ein entfernter Marker wird per ID zum aufnehmenden weitergereicht
+    auto follow = [&change](int &index, quint32 &id) {
+        if (id == SimulationCore::invalidMarkerId) {
+            return;
+        }
+        if (id == change.id) {
+            id = change.mergedInto;
+            index = -1;
+        } else if (index >= 0 && index == change.movedFrom) {
+            index = change.index;
+        }
+    };
+    follow(selectedMarkerIndex, selectedMarkerId);
+    follow(highlightedMarkerIndex, highlightedMarkerId);
+}
+
+void SphereWidget::uploadInstances()
+{
+    FrameProfiler::Scope profile(FrameProfiler::InstanceUpload);
+    const SimulationSnapshot &snapshot = currentSnapshot();
+    const int count = qMin(snapshot.size(), static_cast<int>(markerColors.size()));
+
+    // Nur bei geaenderter Anzahl alle Farben neu setzen; sonst aendert updateMarkers/updateMarkerColor einzelne
+    if (instancedRenderer->instanceCount() != count) {
+        instancedRenderer->resize(count);
+        for (int i = 0; i < count; ++i) {
+            instancedRenderer->setColor(i, displayColor(i));
+        }
     }
+    instancedRenderer->setTransforms(snapshot.posX.constData(), snapshot.posY.constData(), snapshot.posZ.constData(),
+                                     snapshot.radii.constData());
+    instancedRenderer->upload();
 }
 
-QJsonObject SphereWidget::exportScenario() const
+QColor SphereWidget::displayColor(int markerIndex) const
 {
-    QJsonObject root;
-    root["version"] = 1;
-    root["animationEnabled"] = animationEnabled;
-    root["sphereRadius"] = 1.0;
+    if (selectedMarkerIndex == markerIndex) {
+        return QColor(0, 255, 0);
+    }
+    if (highlightedMarkerIndex == markerIndex) {
+        return QColor(255, 0, 0);
+    }
+    return markerColors[markerIndex];
+}
 
-    QJsonArray markerArray;
+const SimulationSnapshot &SphereWidget::currentSnapshot() const
+{
+    return playbackActive ? playbackSnapshot : simulation.snapshot();
+}
 
-    for (const auto &state : markers) {
-        QJsonObject markerObj;
-        markerObj["radius"] = state.radius;
-        markerObj["density"] = state.density;
-        markerObj["color"] = QJsonArray{state.color.red(), state.color.green(), state.color.blue()};
-        markerObj["position"] = QJsonArray{state.position.x(), state.position.y(), state.position.z()};
-        markerObj["velocity"] = QJsonArray{state.velocity.x(), state.velocity.y(), state.velocity.z()};
-        markerArray.append(markerObj);
-    }
+void SphereWidget::setInstancingThreshold(int markers)
+{
+    instancingThreshold = qMax(0, markers);
+    syncMarkerEntities();
+}
 
-    root["markers"] = markerArray;
+QJsonObject SphereWidget::exportScenario() const
+{
+    QJsonObject root;
+    simulation.query([&root](const SimulationCore &core) {
+        root = core.exportScenario();
+    });
+    root["animationEnabled"] = animationEnabled;
     return root;
 }
 
@@ -179,59 +424,260 @@ bool SphereWidget::applyScenario(const QJsonObject &scenario)
         return false;
     }
 
-    const QJsonArray markerArray = scenario["markers"].toArray();
     clearMarkers();
+    simulation.postBlocking([&scenario](SimulationCore &core) {
+        core.applyScenario(scenario);
+    });
+    syncMarkerEntities();
 
-    constexpr float sphereRadius = 1.0f;
+    const bool animEnabled = scenario["animationEnabled"].toBool(true);
+    setAnimationEnabled(animEnabled);
+    return true;
+}
 
-    for (const auto &entry : markerArray) {
-        if (!entry.isObject()) {
-            continue;
-        }
+bool SphereWidget::loadScenarioFile(const QString &path, QString *error)
+{
+    stopPlayback();
+
+    // Laden auf dem Simulations-Thread; bei einem Fehler bleibt der Kern unveraendert
+    bool loaded = false;
+    bool animEnabled = true;
+    simulation.postBlocking([&](SimulationCore &core) {
+        loaded = ScenarioFile::load(path, core, &animEnabled, error);
+    });
+    if (!loaded) {
+        return false;
+    }
 
-        const QJsonObject markerObj = entry.toObject();
-        const QJsonArray colorArr = markerObj["color"].toArray();
-        const QJsonArray posArr = markerObj["position"].toArray();
-        const QJsonArray velArr = markerObj["velocity"].toArray();
+    resetMarkerViews();
+    syncMarkerEntities();
+    setAnimationEnabled(animEnabled);
+    return true;
+}
 
-        if (colorArr.size() != 3 || posArr.size() != 3 || velArr.size() != 3) {
-            continue;
-        }
+bool SphereWidget::saveScenarioFile(const QString &path, QString *error) const
+{
+    bool saved = false;
+    const bool animEnabled = animationEnabled;
+    simulation.query([&](const SimulationCore &core) {
+        saved = ScenarioFile::save(path, core, animEnabled, error);
+    });
+    return saved;
+}
 
-        const float radius = static_cast<float>(markerObj["radius"].toDouble(0.1));
-        const float density = static_cast<float>(markerObj["density"].toDouble(1.0));
-        const QColor color(
-            colorArr[0].toInt(255),
-            colorArr[1].toInt(255),
-            colorArr[2].toInt(255)
-        );
+bool SphereWidget::startRecording(const QString &path, int stepInterval, QString *error)
+{
+    stopRecording();
 
-        const QVector3D position(
-            static_cast<float>(posArr[0].toDouble()),
-            static_cast<float>(posArr[1].toDouble()),
-            static_cast<float>(posArr[2].toDouble())
-        );
+    TrajectoryRecorder::Options options;
+    options.stepInterval = stepInterval;
+    auto newRecorder = std::make_shared<TrajectoryRecorder>();
+    if (!newRecorder->start(path, options, error)) {
+        return false;
+    }
+    recorder = newRecorder;
+    simulation.setRecorder(recorder);
+    return true;
+}
 
-        const QVector3D velocity(
-            static_cast<float>(velArr[0].toDouble()),
-            static_cast<float>(velArr[1].toDouble()),
-            static_cast<float>(velArr[2].toDouble())
-        );
+void SphereWidget::stopRecording()
+{
+    if (!recorder) {
+        return;
+    }
+    // Erst abmelden, dann die restlichen Bilder schreiben lassen
+    simulation.setRecorder(nullptr);
+    recorder->stop();
+    recorder.reset();
+}
+
+void SphereWidget::setCheckpointBudget(qint64 bytes)
+{
+    CheckpointStore::Options options;
+    options.memoryBudget = qMax<qint64>(0, bytes);
+    simulation.setCheckpointOptions(options);
+}
 
-        auto *marker = new SurfaceMarker(rootEntity, sphereRadius, radius, color);
-        const QVector3D posNorm = position.normalized();
-        const float latDeg = qRadiansToDegrees(qAsin(posNorm.y()));
-        const float lonDeg = qRadiansToDegrees(qAtan2(posNorm.z(), posNorm.x()));
-        marker->setSphericalPosition(latDeg, lonDeg);
+bool SphereWidget::seekCheckpoint(quint64 step)
+{
+    if (playbackActive || recorder) {
+        return false;
+    }
+    if (!simulation.seekCheckpoint(step)) {
+        return false;
+    }
+    // Bestand und Eigenschaften koennen sich seit dem Checkpoint beliebig geaendert haben: wie nach dem Laden
+    // eines Szenarios vollstaendig neu aufbauen
+    resetMarkerViews();
+    syncMarkerEntities();
+    updateMarkers();
+    lastNotifiedStep = simulation.snapshot().stepCount;
+    if (!markerColors.isEmpty()) {
+        emit markersChanged(0, markerColors.size() - 1, AllFields);
+    }
+    return true;
+}
 
-        markers.append({marker, posNorm, velocity, radius, density, color});
+bool SphereWidget::startPlayback(const QString &path, QString *error)
+{
+    auto reader = std::make_unique<TrajectoryReader>();
+    if (!reader->open(path, error)) {
+        return false;
     }
 
-    const bool animEnabled = scenario["animationEnabled"].toBool(true);
-    setAnimationEnabled(animEnabled);
+    stopRecording();
+    stopPlayback();
+    simulation.setRunning(false);
+
+    playbackReader = std::move(reader);
+    playbackActive = true;
+    playbackRunning = false;
+    playbackFrame = -1;
+    playbackPosition = playbackReader->startTime();
+
+    resetMarkerViews();
+    showPlaybackFrame(0);
+    emit playbackStateChanged(true);
+    emit playbackTimeChanged(playbackPosition);
     return true;
 }
 
+void SphereWidget::stopPlayback()
+{
+    if (!playbackActive) {
+        return;
+    }
+
+    playbackActive = false;
+    playbackRunning = false;
+    playbackReader.reset();
+    playbackSnapshot = SimulationSnapshot();
+
+    // Zurueck zum Live-Zustand, der waehrend der Wiedergabe unveraendert geblieben ist
+    resetMarkerViews();
+    syncMarkerEntities();
+    updateMarkers();
+    lastNotifiedStep = simulation.snapshot().stepCount;
+    if (!markerColors.isEmpty()) {
+        emit markersChanged(0, markerColors.size() - 1, AllFields);
+    }
+    simulation.setRunning(animationEnabled);
+    emit playbackStateChanged(false);
+}
+
+void SphereWidget::setPlaybackRunning(bool running)
+{
+    if (!playbackActive) {
+        return;
+    }
+    if (running && playbackPosition >= playbackReader->endTime()) {
+        seekPlayback(playbackReader->startTime());
+    }
+    playbackRunning = running;
+    playbackClock.start();
+}
+
+void SphereWidget::seekPlayback(double time)
+{
+    if (!playbackActive) {
+        return;
+    }
+    playbackPosition = qBound(playbackReader->startTime(), time, playbackReader->endTime());
+    playbackClock.start();
+    showPlaybackFrame(playbackReader->frameAt(playbackPosition));
+    emit playbackTimeChanged(playbackPosition);
+}
+
+double SphereWidget::playbackStartTime() const
+{
+    return playbackReader ? playbackReader->startTime() : 0.0;
+}
+
+double SphereWidget::playbackEndTime() const
+{
+    return playbackReader ? playbackReader->endTime() : 0.0;
+}
+
+void SphereWidget::advancePlayback()
+{
+    if (!playbackRunning) {
+        return;
+    }
+
+    // Abspielen in aufgezeichneter Simulationszeit, skaliert mit der aktuellen Zeitskalierung
+    playbackPosition += playbackClock.restart() / 1000.0 * timeScale;
+    if (playbackPosition >= playbackReader->endTime()) {
+        playbackPosition = playbackReader->endTime();
+        playbackRunning = false;
+    }
+    showPlaybackFrame(playbackReader->frameAt(playbackPosition));
+    emit playbackTimeChanged(playbackPosition);
+}
+
+void SphereWidget::showPlaybackFrame(int frame)
+{
+    if (frame == playbackFrame) {
+        return;
+    }
+    bool decoded;
+    {
+        FrameProfiler::Scope profile(FrameProfiler::PlaybackDecode);
+        decoded = playbackReader->readFrame(frame, playbackSnapshot);
+    }
+    if (!decoded) {
+        qWarning() << "Trajektorien-Bild" << frame << "konnte nicht dekodiert werden";
+        return;
+    }
+    playbackFrame = frame;
+
+    // Aendert sich die Markeranzahl zwischen Keyframes, werden die Ansichten neu aufgebaut
+    if (playbackSnapshot.size() != markerColors.size()) {
+        resetMarkerViews();
+        syncMarkerEntities();
+    }
+    updateMarkers();
+    if (playbackSnapshot.size() > 0) {
+        emit markersChanged(0, playbackSnapshot.size() - 1, AllFields);
+    }
+}
+
+void SphereWidget::queueMarkerChange(quint64 sequence, int markerIndex, MarkerFields fields)
+{
+    // Aufeinanderfolgende Aenderungen derselben Eigenschaft (z. B. Mehrfachauswahl) zu einem Bereich zusammenfassen
+    if (!pendingMarkerChanges.isEmpty()) {
+        PendingMarkerChange &last = pendingMarkerChanges.last();
+        if (last.fields == fields && last.last + 1 == markerIndex) {
+            last.sequence = sequence;
+            last.last = markerIndex;
+            return;
+        }
+    }
+    pendingMarkerChanges.append({sequence, markerIndex, markerIndex, fields});
+}
+
+void SphereWidget::emitMarkerChanges()
+{
+    const SimulationSnapshot &snapshot = simulation.snapshot();
+    const int count = snapshot.size();
+
+    if (snapshot.stepCount != lastNotifiedStep) {
+        lastNotifiedStep = snapshot.stepCount;
+        if (count > 0) {
+            emit markersChanged(0, count - 1, Position | Velocity);
+        }
+    }
+
+    // Befehle laufen in Einreihungsreihenfolge, daher ist die Liste nach sequence sortiert
+    int done = 0;
+    while (done < pendingMarkerChanges.size() && pendingMarkerChanges[done].sequence <= snapshot.commandSequence) {
+        const PendingMarkerChange &change = pendingMarkerChanges[done++];
+        if (change.first < count) {
+            emit markersChanged(change.first, qMin(change.last, count - 1), change.fields);
+        }
+    }
+    pendingMarkerChanges.remove(0, done);
+}
+
 void SphereWidget::createLighting(Qt3DCore::QEntity *rootEntity)
 {
     if (!rootEntity) {
@@ -292,18 +738,24 @@ void SphereWidget::createSphere(Qt3DCore::QEntity *rootEntity)
 
 void SphereWidget::updateFrame()
 {
-    const qint64 nowMs = frameTimer.elapsed();
-    const float deltaSeconds = qMax(0.0f, (nowMs - lastFrameMs) / 1000.0f);
-    lastFrameMs = nowMs;
-
-    // Wende Zeitskalierung an
-    const float scaledDelta = deltaSeconds * timeScale;
-    updateMarkers(scaledDelta);
+    FrameProfiler::Scope profile(FrameProfiler::Frame);
+    if (playbackActive) {
+        advancePlayback();
+    } else if (simulation.updateSnapshot()) {
+        // Verschmolzene Marker zuerst aus den Ansichten entfernen, damit alle Indizes zum Snapshot passen
+        if (applyStructureChanges()) {
+            syncMarkerEntities();
+        }
+        updateMarkers();
+        emitMarkerChanges();
+    }
     
     // Kamera dem Marker folgen lassen
-    if (followMarkerEnabled && selectedMarkerIndex >= 0 && selectedMarkerIndex < markers.size()) {
+    const SimulationSnapshot &snapshot = currentSnapshot();
+    if (followMarkerEnabled && selectedMarkerIndex >= 0 && selectedMarkerIndex < snapshot.size()) {
         auto *cam = camera();
-        const QVector3D markerPos = markers[selectedMarkerIndex].position.normalized();
+        const Vec3 selectedPos = snapshot.position(selectedMarkerIndex);
+        const QVector3D markerPos = QVector3D(selectedPos.x, selectedPos.y, selectedPos.z).normalized();
         
         // Neue Kamera-Position: in Richtung des Markers, mit konfigurierter Distanz
         const QVector3D newCamPos = markerPos * followMarkerDistance;
@@ -324,160 +776,51 @@ void SphereWidget::updateFrame()
     }
 }
 
-void SphereWidget::updateMarkers(float deltaSeconds)
+void SphereWidget::updateMarkers()
 {
-    if (deltaSeconds <= 0.0f) {
-        return;
-    }
-
-    constexpr float sphereRadius = 1.0f;
-    constexpr float gravityConstant = 10.0f;
-    const float epsilon = 1e-4f;
-
-    QVector<QVector3D> accelerations(markers.size(), QVector3D(0.0f, 0.0f, 0.0f));
-
-    for (int i = 0; i < markers.size(); ++i) {
-        for (int j = i + 1; j < markers.size(); ++j) {
-            const QVector3D pa = markers[i].position.normalized();
-            const QVector3D pb = markers[j].position.normalized();
-
-            const float dot = qBound(-1.0f, QVector3D::dotProduct(pa, pb), 1.0f);
-            const float angle = qAcos(dot);
-            const float arc = qMax(angle * sphereRadius, epsilon);
-            const float otherArc = qMax(static_cast<float>(2.0 * M_PI) * sphereRadius - arc, epsilon);
-
-            QVector3D ti = pb - QVector3D::dotProduct(pb, pa) * pa;
-            QVector3D tj = pa - QVector3D::dotProduct(pa, pb) * pb;
-
-            if (ti.lengthSquared() < epsilon || tj.lengthSquared() < epsilon) {
-                continue;
-            }
-
-            ti.normalize();
-            tj.normalize();
-
-            const float mi = markers[i].density * markers[i].radius * markers[i].radius * markers[i].radius;
-            const float mj = markers[j].density * markers[j].radius * markers[j].radius * markers[j].radius;
-
-            const float forceMagnitude = gravityConstant * mi * mj * ((1.0f / (arc * arc)) - (1.0f / (otherArc * otherArc)));
-
-            accelerations[i] += (forceMagnitude / mi) * ti;
-            accelerations[j] += (forceMagnitude / mj) * tj;
-        }
-    }
-
-    for (int i = 0; i < markers.size(); ++i) {
-        auto &state = markers[i];
-        const QVector3D position = state.position.normalized();
-        QVector3D velocity = state.velocity + accelerations.value(i) * deltaSeconds;
-        velocity -= QVector3D::dotProduct(velocity, position) * position;
-
-        const float speed = velocity.length();
-        if (speed > 1e-6f) {
-            const QVector3D axis = QVector3D::crossProduct(position, velocity).normalized();
-            const float angleRad = (speed * deltaSeconds);
-            const QQuaternion rotation = QQuaternion::fromAxisAndAngle(axis, qRadiansToDegrees(angleRad));
-
-            state.position = rotation.rotatedVector(position).normalized();
-            state.velocity = rotation.rotatedVector(velocity);
-        }
-
-    }
+    const SimulationSnapshot &snapshot = currentSnapshot();
 
     const QColor baseColor(120, 190, 255);
     const QColor hitColor(255, 220, 80);
 
-    QVector<bool> colliding(markers.size(), false);
-    handleCollisions(colliding);
-
-    for (auto &state : markers) {
-        const float latDeg = qRadiansToDegrees(qAsin(state.position.y()));
-        const float lonDeg = qRadiansToDegrees(qAtan2(state.position.z(), state.position.x()));
-        state.marker->setSphericalPosition(latDeg, lonDeg);
-    }
-
-    for (int i = 0; i < markers.size(); ++i) {
-        // Prüfe ob dieser Marker selektiert oder hervorgehoben ist
-        if (i == selectedMarkerIndex || i == highlightedMarkerIndex) {
-            // Für selektierte/hervorgehobene Marker: verwende updateMarkerColor
-            updateMarkerColor(i);
-            continue;
-        }
-        
-        const QColor target = colliding[i] ? hitColor : baseColor;
-        if (markers[i].color != target) {
-            markers[i].color = target;
-            markers[i].marker->setColor(target);
+    if (instancedRendering) {
+        const int count = qMin(snapshot.size(), static_cast<int>(markerColors.size()));
+        {
+            // Nur Marker mit neuer Kollisionsfarbe landen im Dirty-Bitset des Farbpuffers
+            FrameProfiler::Scope profile(FrameProfiler::ColorSync);
+            for (int i = 0; i < count; ++i) {
+                const QColor &target = snapshot.colliding[i] ? hitColor : baseColor;
+                if (markerColors[i] != target) {
+                    markerColors[i] = target;
+                    instancedRenderer->setColor(i, displayColor(i));
+                }
+            }
         }
-    }
-}
-
-void SphereWidget::handleCollisions(QVector<bool> &colliding)
-{
-    if (markers.size() < 2) {
+        uploadInstances();
         return;
     }
 
-    constexpr float sphereRadius = 1.0f;
-    const float epsilon = 1e-6f;
-
-    for (int i = 0; i < markers.size(); ++i) {
-        for (int j = i + 1; j < markers.size(); ++j) {
-            auto &a = markers[i];
-            auto &b = markers[j];
-
-            const QVector3D pa = a.position.normalized();
-            const QVector3D pb = b.position.normalized();
-
-            const float dot = qBound(-1.0f, QVector3D::dotProduct(pa, pb), 1.0f);
-            const float angle = qAcos(dot);
-            const float minAngle = (a.radius + b.radius) / sphereRadius;
-
-            if (angle > minAngle) {
-                continue;
+    const int count = qMin(snapshot.size(), static_cast<int>(markerEntities.size()));
+    {
+        // Positionen liegen auf der Einheitskugel und sind damit bereits die Flaechennormalen
+        FrameProfiler::Scope profile(FrameProfiler::TransformSync);
+        SurfaceMarker::setSurfaceNormals(markerEntities, snapshot.posX.constData(), snapshot.posY.constData(),
+                                         snapshot.posZ.constData(), count);
+        // Verschmelzen vergroessert den aufnehmenden Marker; der instanzierte Pfad liest die Radien ohnehin je Bild
+        for (int i = 0; i < count; ++i) {
+            if (markerEntities[i]->radius() != snapshot.radii[i]) {
+                markerEntities[i]->setMarkerRadius(snapshot.radii[i]);
             }
+        }
+    }
 
-            colliding[i] = true;
-            colliding[j] = true;
-
-            QVector3D mid = pa + pb;
-            if (mid.lengthSquared() < epsilon) {
-                mid = pa;
-            }
-            mid.normalize();
-
-            QVector3D n = pb - pa;
-            n -= QVector3D::dotProduct(n, mid) * mid;
-            if (n.lengthSquared() < epsilon) {
-                continue;
-            }
-            n.normalize();
-
-            QVector3D va = a.velocity - QVector3D::dotProduct(a.velocity, mid) * mid;
-            QVector3D vb = b.velocity - QVector3D::dotProduct(b.velocity, mid) * mid;
-
-            const float vaN = QVector3D::dotProduct(va, n);
-            const float vbN = QVector3D::dotProduct(vb, n);
-            const float rel = vaN - vbN;
-
-            if (rel <= 0.0f) {
-                continue;
-            }
-
-            const QVector3D vaT = va - vaN * n;
-            const QVector3D vbT = vb - vbN * n;
-
-            const float m1 = a.radius * a.radius;
-            const float m2 = b.radius * b.radius;
-
-            const float newVaN = (vaN * (m1 - m2) + 2.0f * m2 * vbN) / (m1 + m2);
-            const float newVbN = (vbN * (m2 - m1) + 2.0f * m1 * vaN) / (m1 + m2);
-
-            a.velocity = vaT + newVaN * n;
-            b.velocity = vbT + newVbN * n;
-
-            a.velocity -= QVector3D::dotProduct(a.velocity, pa) * pa;
-            b.velocity -= QVector3D::dotProduct(b.velocity, pb) * pb;
+    // Material-Aenderungen nur bei neuer Kollisionsfarbe; Auswahl und Hervorhebung setzt updateMarkerColor
+    FrameProfiler::Scope profile(FrameProfiler::ColorSync);
+    for (int i = 0; i < count; ++i) {
+        const QColor &target = snapshot.colliding[i] ? hitColor : baseColor;
+        if (markerColors[i] != target) {
+            markerColors[i] = target;
+            markerEntities[i]->setColor(displayColor(i));
         }
     }
 }
@@ -489,13 +832,9 @@ void SphereWidget::setAnimationEnabled(bool enabled)
     }
 
     animationEnabled = enabled;
-    if (animationTimer) {
-        if (animationEnabled) {
-            lastFrameMs = frameTimer.elapsed();
-            animationTimer->start(16);
-        } else {
-            animationTimer->stop();
-        }
+    // Waehrend der Wiedergabe bleibt die Simulation angehalten; stopPlayback() uebernimmt den Zustand
+    if (!playbackActive) {
+        simulation.setRunning(animationEnabled);
     }
 }
 
@@ -519,16 +858,19 @@ void SphereWidget::zoomOut()
 
 QVector<SphereWidget::MarkerInfo> SphereWidget::getMarkersInfo() const
 {
+    const SimulationSnapshot &snapshot = currentSnapshot();
     QVector<MarkerInfo> result;
-    for (int i = 0; i < markers.size(); ++i) {
-        const auto &state = markers[i];
+    result.reserve(snapshot.size());
+    for (int i = 0; i < snapshot.size(); ++i) {
+        const Vec3 position = snapshot.position(i);
+        const Vec3 velocity = snapshot.velocity(i);
         result.append({
             i,
-            state.radius,
-            state.density,
-            state.color,
-            state.position,
-            state.velocity
+            snapshot.radii[i],
+            snapshot.densities[i],
+            markerColors.value(i),
+            QVector3D(position.x, position.y, position.z),
+            QVector3D(velocity.x, velocity.y, velocity.z)
         });
     }
     return result;
@@ -536,16 +878,17 @@ QVector<SphereWidget::MarkerInfo> SphereWidget::getMarkersInfo() const
 
 void SphereWidget::highlightMarker(int markerIndex)
 {
-    qDebug() << "highlightMarker called with index:" << markerIndex << "total markers:" << markers.size();
+    qDebug() << "highlightMarker called with index:" << markerIndex << "total markers:" << markerColors.size();
 
     const int previousIndex = highlightedMarkerIndex;
-    highlightedMarkerIndex = (markerIndex >= 0 && markerIndex < markers.size()) ? markerIndex : -1;
+    highlightedMarkerIndex = (markerIndex >= 0 && markerIndex < markerColors.size()) ? markerIndex : -1;
+    highlightedMarkerId = highlightedMarkerIndex >= 0 ? markerState().id(highlightedMarkerIndex) : SimulationCore::invalidMarkerId;
 
-    if (previousIndex >= 0 && previousIndex < markers.size()) {
+    if (previousIndex >= 0 && previousIndex < markerColors.size()) {
         updateMarkerColor(previousIndex);
     }
 
-    if (highlightedMarkerIndex >= 0 && highlightedMarkerIndex < markers.size()) {
+    if (highlightedMarkerIndex >= 0 && highlightedMarkerIndex < markerColors.size()) {
         updateMarkerColor(highlightedMarkerIndex);
     }
 }
@@ -558,33 +901,32 @@ void SphereWidget::clearHighlightedMarker()
 void SphereWidget::setSelectedMarker(int markerIndex)
 {
     const int previousIndex = selectedMarkerIndex;
-    selectedMarkerIndex = (markerIndex >= 0 && markerIndex < markers.size()) ? markerIndex : -1;
+    selectedMarkerIndex = (markerIndex >= 0 && markerIndex < markerColors.size()) ? markerIndex : -1;
+    selectedMarkerId = selectedMarkerIndex >= 0 ? markerState().id(selectedMarkerIndex) : SimulationCore::invalidMarkerId;
 
-    if (previousIndex >= 0 && previousIndex < markers.size()) {
+    if (previousIndex >= 0 && previousIndex < markerColors.size()) {
         updateMarkerColor(previousIndex);
     }
 
-    if (selectedMarkerIndex >= 0 && selectedMarkerIndex < markers.size()) {
+    if (selectedMarkerIndex >= 0 && selectedMarkerIndex < markerColors.size()) {
         updateMarkerColor(selectedMarkerIndex);
     }
 }
 
 void SphereWidget::updateMarkerColor(int markerIndex)
 {
-    if (markerIndex < 0 || markerIndex >= markers.size()) {
+    if (markerIndex < 0 || markerIndex >= markerColors.size()) {
         return;
     }
 
-    QColor colorToApply = markers[markerIndex].color;
-
-    if (selectedMarkerIndex == markerIndex) {
-        colorToApply = QColor(0, 255, 0);
-    } else if (highlightedMarkerIndex == markerIndex) {
-        colorToApply = QColor(255, 0, 0);
+    if (instancedRendering) {
+        instancedRenderer->setColor(markerIndex, displayColor(markerIndex));
+        instancedRenderer->upload();
+        return;
     }
 
-    if (markers[markerIndex].marker) {
-        markers[markerIndex].marker->setColor(colorToApply);
+    if (markerIndex < markerEntities.size() && markerEntities[markerIndex]) {
+        markerEntities[markerIndex]->setColor(displayColor(markerIndex));
     }
 }
 
@@ -603,49 +945,117 @@ void SphereWidget::setFollowMarker(bool enabled)
 
 void SphereWidget::setMarkerDensity(int markerIndex, float density)
 {
-    if (markerIndex < 0 || markerIndex >= markers.size()) {
+    // Aufgezeichnete Bilder sind unveraenderlich
+    if (playbackActive || markerIndex < 0 || markerIndex >= markerColors.size()) {
         return;
     }
     
-    markers[markerIndex].density = density;
+    // Per ID: bis zur Ausfuehrung koennen Verschmelzungen die Indizes verschieben
+    const quint32 markerId = markerState().id(markerIndex);
+    const quint64 sequence = simulation.post([markerId, density](SimulationCore &core) {
+        const int index = core.indexOfId(markerId);
+        if (index >= 0) {
+            core.setMarkerDensity(index, density);
+        }
+    });
+    queueMarkerChange(sequence, markerIndex, Density);
 }
 
 void SphereWidget::setMarkerRadius(int markerIndex, float radius)
 {
-    if (markerIndex < 0 || markerIndex >= markers.size()) {
+    // Aufgezeichnete Bilder sind unveraenderlich
+    if (playbackActive || markerIndex < 0 || markerIndex >= markerColors.size()) {
         return;
     }
     
     if (radius > 0) {
-        markers[markerIndex].radius = radius;
-        // Aktualisiere auch die 3D-Geometrie
-        if (markers[markerIndex].marker) {
-            markers[markerIndex].marker->setMarkerRadius(radius);
-        }
+        const quint32 markerId = markerState().id(markerIndex);
+        const quint64 sequence = simulation.post([markerId, radius](SimulationCore &core) {
+            const int index = core.indexOfId(markerId);
+            if (index >= 0) {
+                core.setMarkerRadius(index, radius);
+            }
+        });
+        // Die Geometrie folgt in beiden Render-Pfaden dem Snapshot (updateMarkers), sobald er den Befehl enthaelt
+        queueMarkerChange(sequence, markerIndex, Radius);
     }
 }
 
 void SphereWidget::setMarkerVelocityMagnitude(int markerIndex, float magnitude)
 {
-    if (markerIndex < 0 || markerIndex >= markers.size()) {
+    // Aufgezeichnete Bilder sind unveraenderlich
+    if (playbackActive || markerIndex < 0 || markerIndex >= markerColors.size()) {
         return;
     }
-    
-    // Behalte die Richtung, aendere nur den Betrag
-    QVector3D currentVelocity = markers[markerIndex].velocity;
-    float currentMagnitude = currentVelocity.length();
-    
-    if (currentMagnitude > 0.0001f) {
-        // Normalisiere und skaliere mit neuem Betrag
-        QVector3D direction = currentVelocity.normalized();
-        markers[markerIndex].velocity = direction * magnitude;
-    } else {
-        // Falls Geschwindigkeit ~0 ist, setze neue Richtung in Z
-        markers[markerIndex].velocity = QVector3D(0, 0, magnitude);
-    }
+
+    // Per ID: bis zur Ausfuehrung koennen Verschmelzungen die Indizes verschieben
+    const quint32 markerId = markerState().id(markerIndex);
+    const quint64 sequence = simulation.post([markerId, magnitude](SimulationCore &core) {
+        const int index = core.indexOfId(markerId);
+        if (index >= 0) {
+            core.setMarkerVelocityMagnitude(index, magnitude);
+        }
+    });
+    queueMarkerChange(sequence, markerIndex, Velocity);
 }
 
 void SphereWidget::setTimeScale(float scale)
 {
-    timeScale = qBound(0.1f, scale, 10.0f);
+    timeScale = qBound(0.1f, scale, 100.0f);
+    simulation.setTimeScale(timeScale);
+}
+
+void SphereWidget::setForceSolver(SimulationCore::ForceSolver solver)
+{
+    simulation.post([solver](SimulationCore &core) {
+        core.setForceSolver(solver);
+    });
+}
+
+void SphereWidget::setOpeningAngle(float angle)
+{
+    simulation.post([angle](SimulationCore &core) {
+        core.setOpeningAngle(angle);
+    });
+}
+
+void SphereWidget::setThreadCount(int threads)
+{
+    simulation.post([threads](SimulationCore &core) {
+        core.setThreadCount(threads);
+    });
+}
+
+void SphereWidget::setIntegrator(SimulationCore::Integrator integrator)
+{
+    simulation.post([integrator](SimulationCore &core) {
+        core.setIntegrator(integrator);
+    });
+}
+
+void SphereWidget::setPrecision(SimulationCore::Precision precision)
+{
+    simulation.post([precision](SimulationCore &core) {
+        core.setPrecision(precision);
+    });
+}
+
+void SphereWidget::setCollisionMode(SimulationCore::CollisionMode mode)
+{
+    simulation.post([mode](SimulationCore &core) {
+        core.setCollisionMode(mode);
+    });
+}
+
+SimulationCore SphereWidget::simulationCopy() const
+{
+    SimulationCore copy;
+    simulation.query([&copy](const SimulationCore &core) {
+        copy = core;
+    });
+    // Die Kopie hat keinen Beobachter, der das Strukturprotokoll bestaetigt
+    copy.setStructureLogging(false);
+    // Eigener Pool, sonst warten die Kraftberechnungen der Kopie und der Live-Simulation aufeinander
+    copy.detachWorkerPool();
+    return copy;
 }
@@ -6,12 +6,20 @@
 #include <Qt3DExtras/QForwardRenderer>
 #include <QColor>
 #include <QVector>
-#include <QElapsedTimer>
 #include <QVector3D>
 #include <QJsonObject>
-#include <QColor>
+#include <QElapsedTimer>
+#include <memory>
 
 #include "surface_marker.h"
+#include "simulationcore.h"
+#include "simulationthread.h"
+#include "markerstateview.h"
+
+class InstancedMarkerRenderer;
+class CapGeometryCache;
+class TrajectoryRecorder;
+class TrajectoryReader;
 
 QT_BEGIN_NAMESPACE
 namespace Qt3DCore {
@@ -31,10 +39,22 @@ class SphereWidget : public Qt3DExtras::Qt3DWindow {
     Q_OBJECT
 
 public:
+    // Welche Markereigenschaften sich in einem markersChanged-Bereich geaendert haben
+    enum MarkerField {
+        Position = 0x01,
+        Velocity = 0x02,
+        Radius = 0x04,
+        Density = 0x08,
+        Color = 0x10,
+        AllFields = Position | Velocity | Radius | Density | Color
+    };
+    Q_DECLARE_FLAGS(MarkerFields, MarkerField)
+
     SphereWidget();
-    ~SphereWidget() = default;
+    ~SphereWidget();
 
-    void generateMarkers(int count, float speed, float size, float density);
+    // Erzeugt zuerst den numerischen Zustand auf dem Simulations-Thread, danach die Render-Objekte
+    void generateMarkers(const MarkerGenerator::Settings &settings);
     void setAnimationEnabled(bool enabled);
     bool isAnimationEnabled() const { return animationEnabled; }
     void clearMarkers();
@@ -48,6 +68,17 @@ public:
     void setMarkerRadius(int markerIndex, float radius);
     void setMarkerVelocityMagnitude(int markerIndex, float magnitude);
     void setTimeScale(float scale);
+    void setForceSolver(SimulationCore::ForceSolver solver);
+    void setOpeningAngle(float angle);
+    void setThreadCount(int threads);
+    void setIntegrator(SimulationCore::Integrator integrator);
+    void setPrecision(SimulationCore::Precision precision);
+    void setCollisionMode(SimulationCore::CollisionMode mode);
+    // Ab dieser Markeranzahl werden alle Marker instanziert in einem Draw-Call gezeichnet
+    void setInstancingThreshold(int markers);
+    int instancingThresholdValue() const { return instancingThreshold; }
+    // Konsistente Kopie des Simulationskerns (z. B. fuer den Integrator-Bericht) mit eigenem WorkerPool
+    SimulationCore simulationCopy() const;
     
     struct MarkerInfo {
         int index;
@@ -57,10 +88,44 @@ public:
         QVector3D position;
         QVector3D velocity;
     };
+    // Vollstaendige Kopie aller Marker; fuer wiederholte Abfragen markerState() verwenden
     QVector<MarkerInfo> getMarkersInfo() const;
+    // Kopierfreier Blick auf den angezeigten Zustand (Live-Snapshot oder Wiedergabebild), nur im GUI-Thread
+    MarkerStateView markerState() const { return MarkerStateView(currentSnapshot()); }
+    // Anzahl der angezeigten Marker (Live-Simulation oder Wiedergabe), ohne den Zustand zu kopieren
+    int markerCount() const { return static_cast<int>(markerColors.size()); }
 
     QJsonObject exportScenario() const;
     bool applyScenario(const QJsonObject &scenario);
+    // Szenario-Datei im JSON- (.grv) oder Binaerformat (.grvb), Format nach Dateiendung
+    bool loadScenarioFile(const QString &path, QString *error = nullptr);
+    bool saveScenarioFile(const QString &path, QString *error = nullptr) const;
+
+    // Trajektorien-Aufzeichnung (.grvt): jeder k-te Simulationsschritt, geschrieben auf einem eigenen Thread
+    bool startRecording(const QString &path, int stepInterval, QString *error = nullptr);
+    void stopRecording();
+    bool isRecording() const { return recorder != nullptr; }
+    const TrajectoryRecorder *trajectoryRecorder() const { return recorder.get(); }
+
+    // Wiedergabe: haelt die Simulation an und zeigt aufgezeichnete Bilder statt der Live-Snapshots
+    bool startPlayback(const QString &path, QString *error = nullptr);
+    void stopPlayback();
+    bool isPlaybackActive() const { return playbackActive; }
+    bool isPlaybackRunning() const { return playbackRunning; }
+    void setPlaybackRunning(bool running);
+    void seekPlayback(double time);
+    double playbackTime() const { return playbackPosition; }
+    double playbackStartTime() const;
+    double playbackEndTime() const;
+
+    // Checkpoints der Live-Simulation: Speicherbudget in Bytes (0 = aus) und Zuruecksetzen auf einen Schritt im
+    // abgedeckten Bereich; danach laufen die aufgezeichneten Schritte bitgleich nach. Nicht waehrend Aufnahme
+    // oder Wiedergabe.
+    void setCheckpointBudget(qint64 bytes);
+    const SimulationSnapshot::CheckpointRange &checkpointRange() const { return simulation.snapshot().checkpoints; }
+    quint64 simulationStep() const { return simulation.snapshot().stepCount; }
+    double simulationTime() const { return simulation.snapshot().simulationTime; }
+    bool seekCheckpoint(quint64 step);
     
     inline void setBackgroundColor(const QColor &color) {
         auto fg = defaultFrameGraph();
@@ -69,6 +134,19 @@ public:
         }
     }
 
+signals:
+    // Nach jeder Aenderung von markerCount(); Marker werden am Ende angehaengt, per Swap-Remove entfernt
+    // (vorher markerStructureChanged) oder alle entfernt
+    void markerCountChanged(int count);
+    // Strukturelle Aenderungen des Live-Zustands in Protokollreihenfolge, nur wenn mindestens ein Marker per
+    // Swap-Remove entfernt wurde (z. B. verschmolzen). Die Ansichten sind bereits angepasst, markerCountChanged folgt.
+    void markerStructureChanged(const QVector<SimulationCore::StructureChange> &changes);
+    // Eigenschaften der Marker first..last (inklusive) sind in markerState() neu; Simulationsschritte melden
+    // Position|Velocity fuer alle Marker, Einzelaenderungen erst, wenn der Snapshot sie enthaelt
+    void markersChanged(int first, int last, SphereWidget::MarkerFields fields);
+    void playbackStateChanged(bool active);
+    void playbackTimeChanged(double time);
+
 private slots:
     void updateFrame();
 
@@ -77,31 +155,66 @@ private:
     void createSphere(Qt3DCore::QEntity *rootEntity);
     void createLighting(Qt3DCore::QEntity *rootEntity);
     void createMarkers(Qt3DCore::QEntity *rootEntity);
-    void updateMarkers(float deltaSeconds);
-    void handleCollisions(QVector<bool> &colliding);
+    void updateMarkers();
     void updateMarkerColor(int markerIndex);
+    void syncMarkerEntities();
+    // Fuehrt markerColors, markerEntities, Auswahl und ausstehende Aenderungen dem Live-Snapshot nach;
+    // true, wenn sich die Markeranzahl geaendert hat
+    bool applyStructureChanges();
+    void removeMarkerView(const SimulationCore::StructureChange &change);
+    void destroyMarkerEntity(SurfaceMarker *marker);
+    void destroyMarkerEntities();
+    void resetMarkerViews();
+    void uploadInstances();
+    QColor displayColor(int markerIndex) const;
+    const SimulationSnapshot &currentSnapshot() const;
+    void advancePlayback();
+    void showPlaybackFrame(int frame);
+    void queueMarkerChange(quint64 sequence, int markerIndex, MarkerFields fields);
+    void emitMarkerChanges();
+
+    // Einzelaenderung, die sichtbar wird, sobald der Snapshot den Befehl sequence enthaelt
+    struct PendingMarkerChange {
+        quint64 sequence;
+        int first;
+        int last;
+        MarkerFields fields;
+    };
 
     Qt3DCore::QTransform *sphereTransform;
     Qt3DExtras::QOrbitCameraController *cameraController;
     Qt3DCore::QEntity *rootEntity;
-    struct MarkerState {
-        SurfaceMarker *marker;
-        QVector3D position; // unit vector on sphere
-        QVector3D velocity; // tangent vector (units: sphere radii per second)
-        float radius;
-        float density;
-        QColor color;
-    };
-    QVector<MarkerState> markers;
-    QElapsedTimer frameTimer;
-    qint64 lastFrameMs;
+    SimulationThread simulation;             // steps the SimulationCore on its own thread
+    QVector<SurfaceMarker *> markerEntities; // parallel to the latest snapshot (empty while instanced, nullptr until created)
+    QVector<QColor> markerColors;            // currently displayed base/hit color, one per marker
+    std::unique_ptr<CapGeometryCache> capGeometryCache; // geteilte Kappen-Geometrien der Einzel-Marker
+    InstancedMarkerRenderer *instancedRenderer;
+    bool instancedRendering;
+    int instancingThreshold;
     QTimer *animationTimer;
     bool animationEnabled;
     int highlightedMarkerIndex;
     int selectedMarkerIndex;
+    quint32 highlightedMarkerId;             // folgt beim Verschmelzen dem aufnehmenden Marker
+    quint32 selectedMarkerId;
     bool followMarkerEnabled;
     float followMarkerDistance; // Distance for following the marker
-    float timeScale; // Time scale factor for simulation speed
+    float timeScale;
+    std::shared_ptr<TrajectoryRecorder> recorder;
+    std::unique_ptr<TrajectoryReader> playbackReader;
+    SimulationSnapshot playbackSnapshot;     // zuletzt dekodiertes Bild der Wiedergabe
+    QElapsedTimer playbackClock;
+    bool playbackActive;
+    bool playbackRunning;
+    double playbackPosition;                 // Simulationszeit der Wiedergabe
+    int playbackFrame;
+    QVector<PendingMarkerChange> pendingMarkerChanges;
+    quint64 lastNotifiedStep;                // stepCount des zuletzt gemeldeten Live-Snapshots
+    quint64 appliedStructureVersion;         // bis hierher sind die Ansichten dem Strukturprotokoll gefolgt
+    bool structureRebuild;                   // Ansichten leer: naechster Snapshot wird vollstaendig uebernommen
+    int notifiedMarkerCount;                 // zuletzt mit markerCountChanged gemeldet
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(SphereWidget::MarkerFields)
+
 #endif // SPHEREWIDGET_H
@@ -1,269 +1,30 @@
 #include "surface_marker.h"
+#include "capgeometrycache.h"
 
 #include <Qt3DCore/QTransform>
 #include <Qt3DExtras/QPhongMaterial>
-#include <Qt3DCore/QGeometry>
 #include <Qt3DRender/QGeometryRenderer>
-#include <Qt3DCore/QAttribute>
-#include <Qt3DCore/QBuffer>
 #include <Qt3DRender/QCullFace>
 #include <Qt3DRender/QTechnique>
 #include <Qt3DRender/QRenderPass>
 #include <QVector3D>
 #include <QQuaternion>
 #include <QtMath>
-#include <cmath>
-
-namespace {
-Qt3DRender::QGeometryRenderer *createSphericalCap(float surfaceRadius, float markerRadius)
-{
-    auto *geometry = new Qt3DCore::QGeometry();
-    auto *renderer = new Qt3DRender::QGeometryRenderer();
-
-    const float minRadius = 0.0001f;
-    surfaceRadius = qMax(surfaceRadius, minRadius);
-    markerRadius = qMax(markerRadius, minRadius);
-
-    const float maxAngle = static_cast<float>(M_PI) - 0.01f;
-    float capAngle = markerRadius / surfaceRadius;
-    capAngle = qMin(capAngle, maxAngle);
-
-    const float renderRadius = surfaceRadius + qMax(markerRadius * 0.12f, 0.02f);
-    const float thickness = qMax(markerRadius * 0.15f, 0.01f);
-    const float innerRadius = qMax(renderRadius - thickness, minRadius);
-
-    const int rings = 16;
-    const int slices = 32;
-    const int verticesPerRing = slices + 1;
-    const int capVertexCount = (rings + 1) * verticesPerRing;
-    const int sideVertexCount = 2 * verticesPerRing;
-    const int vertexCount = capVertexCount * 2 + sideVertexCount;
-    const int capIndexCount = rings * slices * 6;
-    const int sideIndexCount = slices * 6;
-    const int indexCount = capIndexCount * 2 + sideIndexCount;
-
-    QByteArray vertexBufferData;
-    vertexBufferData.resize(vertexCount * 6 * sizeof(float));
-    float *v = reinterpret_cast<float *>(vertexBufferData.data());
-
-    // Outer cap
-    for (int ring = 0; ring <= rings; ++ring) {
-        const float t = static_cast<float>(ring) / static_cast<float>(rings);
-        const float theta = capAngle * t;
-        const float sinTheta = qSin(theta);
-        const float cosTheta = qCos(theta);
-
-        for (int slice = 0; slice <= slices; ++slice) {
-            const float s = static_cast<float>(slice) / static_cast<float>(slices);
-            const float phi = static_cast<float>(2.0 * M_PI) * s;
-
-            const float sinPhi = qSin(phi);
-            const float cosPhi = qCos(phi);
-
-            const QVector3D normal(
-                sinTheta * cosPhi,
-                cosTheta,
-                sinTheta * sinPhi
-            );
-
-            const QVector3D position = normal * renderRadius;
-
-            *v++ = position.x();
-            *v++ = position.y();
-            *v++ = position.z();
-            *v++ = normal.x();
-            *v++ = normal.y();
-            *v++ = normal.z();
-        }
-    }
-
-    // Inner cap (normals inverted)
-    for (int ring = 0; ring <= rings; ++ring) {
-        const float t = static_cast<float>(ring) / static_cast<float>(rings);
-        const float theta = capAngle * t;
-        const float sinTheta = qSin(theta);
-        const float cosTheta = qCos(theta);
-
-        for (int slice = 0; slice <= slices; ++slice) {
-            const float s = static_cast<float>(slice) / static_cast<float>(slices);
-            const float phi = static_cast<float>(2.0 * M_PI) * s;
-
-            const float sinPhi = qSin(phi);
-            const float cosPhi = qCos(phi);
-
-            const QVector3D normal(
-                sinTheta * cosPhi,
-                cosTheta,
-                sinTheta * sinPhi
-            );
-
-            const QVector3D position = normal * innerRadius;
-            const QVector3D inverted = -normal;
-
-            *v++ = position.x();
-            *v++ = position.y();
-            *v++ = position.z();
-            *v++ = inverted.x();
-            *v++ = inverted.y();
-            *v++ = inverted.z();
-        }
-    }
-
-    // Side ring
-    for (int slice = 0; slice <= slices; ++slice) {
-        const float s = static_cast<float>(slice) / static_cast<float>(slices);
-        const float phi = static_cast<float>(2.0 * M_PI) * s;
-
-        const float sinPhi = qSin(phi);
-        const float cosPhi = qCos(phi);
-
-        const float sinTheta = qSin(capAngle);
-        const float cosTheta = qCos(capAngle);
-
-        const QVector3D direction(
-            sinTheta * cosPhi,
-            cosTheta,
-            sinTheta * sinPhi
-        );
-
-        const QVector3D normal(
-            cosPhi,
-            0.0f,
-            sinPhi
-        );
-
-        const QVector3D outerPos = direction * renderRadius;
-        const QVector3D innerPos = direction * innerRadius;
-
-        *v++ = outerPos.x();
-        *v++ = outerPos.y();
-        *v++ = outerPos.z();
-        *v++ = normal.x();
-        *v++ = normal.y();
-        *v++ = normal.z();
-
-        *v++ = innerPos.x();
-        *v++ = innerPos.y();
-        *v++ = innerPos.z();
-        *v++ = normal.x();
-        *v++ = normal.y();
-        *v++ = normal.z();
-    }
-
-    QByteArray indexBufferData;
-    indexBufferData.resize(indexCount * sizeof(quint32));
-    quint32 *indices = reinterpret_cast<quint32 *>(indexBufferData.data());
-
-    const int outerStart = 0;
-    const int innerStart = capVertexCount;
-    const int sideStart = capVertexCount * 2;
-
-    for (int ring = 0; ring < rings; ++ring) {
-        for (int slice = 0; slice < slices; ++slice) {
-            const int ringStart = ring * verticesPerRing;
-            const int nextRingStart = (ring + 1) * verticesPerRing;
-
-            const quint32 a = outerStart + ringStart + slice;
-            const quint32 b = outerStart + ringStart + slice + 1;
-            const quint32 c = outerStart + nextRingStart + slice;
-            const quint32 d = outerStart + nextRingStart + slice + 1;
-
-            *indices++ = a;
-            *indices++ = c;
-            *indices++ = b;
-            *indices++ = b;
-            *indices++ = c;
-            *indices++ = d;
-        }
-    }
-
-    for (int ring = 0; ring < rings; ++ring) {
-        for (int slice = 0; slice < slices; ++slice) {
-            const int ringStart = ring * verticesPerRing;
-            const int nextRingStart = (ring + 1) * verticesPerRing;
-
-            const quint32 a = innerStart + ringStart + slice;
-            const quint32 b = innerStart + ringStart + slice + 1;
-            const quint32 c = innerStart + nextRingStart + slice;
-            const quint32 d = innerStart + nextRingStart + slice + 1;
-
-            *indices++ = a;
-            *indices++ = b;
-            *indices++ = c;
-            *indices++ = b;
-            *indices++ = d;
-            *indices++ = c;
-        }
-    }
-
-    for (int slice = 0; slice < slices; ++slice) {
-        const quint32 outerA = sideStart + slice * 2;
-        const quint32 innerA = sideStart + slice * 2 + 1;
-        const quint32 outerB = sideStart + (slice + 1) * 2;
-        const quint32 innerB = sideStart + (slice + 1) * 2 + 1;
-
-        *indices++ = outerA;
-        *indices++ = innerA;
-        *indices++ = outerB;
-        *indices++ = outerB;
-        *indices++ = innerA;
-        *indices++ = innerB;
-    }
-
-    auto *vertexBuffer = new Qt3DCore::QBuffer(geometry);
-    vertexBuffer->setData(vertexBufferData);
-
-    auto *indexBuffer = new Qt3DCore::QBuffer(geometry);
-    indexBuffer->setData(indexBufferData);
-
-    auto *positionAttribute = new Qt3DCore::QAttribute();
-    positionAttribute->setName(Qt3DCore::QAttribute::defaultPositionAttributeName());
-    positionAttribute->setVertexBaseType(Qt3DCore::QAttribute::Float);
-    positionAttribute->setVertexSize(3);
-    positionAttribute->setAttributeType(Qt3DCore::QAttribute::VertexAttribute);
-    positionAttribute->setBuffer(vertexBuffer);
-    positionAttribute->setByteStride(6 * sizeof(float));
-    positionAttribute->setByteOffset(0);
-    positionAttribute->setCount(vertexCount);
-
-    auto *normalAttribute = new Qt3DCore::QAttribute();
-    normalAttribute->setName(Qt3DCore::QAttribute::defaultNormalAttributeName());
-    normalAttribute->setVertexBaseType(Qt3DCore::QAttribute::Float);
-    normalAttribute->setVertexSize(3);
-    normalAttribute->setAttributeType(Qt3DCore::QAttribute::VertexAttribute);
-    normalAttribute->setBuffer(vertexBuffer);
-    normalAttribute->setByteStride(6 * sizeof(float));
-    normalAttribute->setByteOffset(3 * sizeof(float));
-    normalAttribute->setCount(vertexCount);
-
-    auto *indexAttribute = new Qt3DCore::QAttribute();
-    indexAttribute->setAttributeType(Qt3DCore::QAttribute::IndexAttribute);
-    indexAttribute->setVertexBaseType(Qt3DCore::QAttribute::UnsignedInt);
-    indexAttribute->setBuffer(indexBuffer);
-    indexAttribute->setCount(indexCount);
-
-    geometry->addAttribute(positionAttribute);
-    geometry->addAttribute(normalAttribute);
-    geometry->addAttribute(indexAttribute);
-
-    renderer->setGeometry(geometry);
-    renderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Triangles);
-
-    return renderer;
-}
-}
 
 SurfaceMarker::SurfaceMarker(Qt3DCore::QEntity *parent,
+                             CapGeometryCache *geometryCache,
                              float surfaceRadius,
                              float markerRadius,
                              const QColor &color)
     : surfaceRadius(surfaceRadius),
       markerRadius(markerRadius),
-      latitudeDeg(0.0f),
-      longitudeDeg(0.0f),
+      surfaceNormal(0.0f, 1.0f, 0.0f),
+      color(color),
+      geometryCache(geometryCache),
+      geometryKey(CapGeometryCache::keyFor(markerRadius)),
       markerEntity(new Qt3DCore::QEntity(parent)),
             transform(new Qt3DCore::QTransform()),
-            geometryRenderer(createSphericalCap(surfaceRadius, markerRadius)),
+            geometryRenderer(geometryCache->acquire(geometryKey)),
             material(new Qt3DExtras::QPhongMaterial())
 {
         material->setDiffuse(color);
@@ -287,21 +48,55 @@ SurfaceMarker::SurfaceMarker(Qt3DCore::QEntity *parent,
     markerEntity->addComponent(material);
     markerEntity->addComponent(transform);
 
+    // Die Kappe sitzt im Ursprung mit Einheitsskala; veraendert wird nur noch die Drehung
+    transform->setScale(1.0f);
+    transform->setTranslation(QVector3D(0.0f, 0.0f, 0.0f));
     updateTransform();
 }
 
-void SurfaceMarker::setSphericalPosition(float latitudeDeg, float longitudeDeg)
+SurfaceMarker::~SurfaceMarker()
+{
+    // Die geteilte Geometrie gehoert dem Cache; hier wird nur die Referenz abgegeben
+    geometryCache->release(geometryKey);
+}
+
+namespace {
+// |a x b|^2 = sin^2(theta) ~ theta^2 fuer Einheitsvektoren; anders als 1 - cos(theta) ~ theta^2 / 2 bleibt der
+// Wert in float aufloesbar (1 - 5e-9 waere bereits 1.0f) und spart acos im Vergleich
+constexpr float orientationCrossLimit = SurfaceMarker::orientationThreshold * SurfaceMarker::orientationThreshold;
+}
+
+bool SurfaceMarker::setSurfaceNormal(const QVector3D &normal)
 {
-    this->latitudeDeg = latitudeDeg;
-    this->longitudeDeg = longitudeDeg;
+    // Gegenrichtung (theta nahe pi) hat ebenfalls ein kleines Kreuzprodukt und wird ueber das Skalarprodukt erkannt
+    if (QVector3D::crossProduct(normal, surfaceNormal).lengthSquared() < orientationCrossLimit
+        && QVector3D::dotProduct(normal, surfaceNormal) > 0.0f) {
+        return false;
+    }
+    surfaceNormal = normal;
     updateTransform();
+    return true;
+}
+
+int SurfaceMarker::setSurfaceNormals(const QVector<SurfaceMarker *> &markers,
+                                     const float *x, const float *y, const float *z, int count)
+{
+    int updated = 0;
+    count = qMin(count, static_cast<int>(markers.size()));
+    for (int i = 0; i < count; ++i) {
+        if (markers[i]->setSurfaceNormal(QVector3D(x[i], y[i], z[i]))) {
+            ++updated;
+        }
+    }
+    return updated;
 }
 
 void SurfaceMarker::setColor(const QColor &color)
 {
-    if (!material) {
+    if (!material || color == this->color) {
         return;
     }
+    this->color = color;
     material->setDiffuse(color);
     material->setAmbient(color);
 }
@@ -313,33 +108,35 @@ void SurfaceMarker::setMarkerRadius(float radius)
     }
     
     markerRadius = radius;
-    
-    // Erstelle die Geometrie neu mit dem neuen Radius
-    if (geometryRenderer) {
-        delete geometryRenderer;
+
+    // Innerhalb derselben Radius-Stufe bleibt die geteilte Geometrie unveraendert
+    const CapGeometryCache::Key key = CapGeometryCache::keyFor(markerRadius);
+    if (key == geometryKey) {
+        return;
     }
-    
-    geometryRenderer = createSphericalCap(surfaceRadius, markerRadius);
-    if (markerEntity && geometryRenderer) {
+
+    Qt3DRender::QGeometryRenderer *previous = geometryRenderer;
+    const CapGeometryCache::Key previousKey = geometryKey;
+
+    geometryKey = key;
+    geometryRenderer = geometryCache->acquire(geometryKey);
+    if (markerEntity) {
+        markerEntity->removeComponent(previous);
         markerEntity->addComponent(geometryRenderer);
     }
+    geometryCache->release(previousKey);
 }
 
 void SurfaceMarker::updateTransform()
 {
-    const float latRad = qDegreesToRadians(latitudeDeg);
-    const float lonRad = qDegreesToRadians(longitudeDeg);
-
-    const float cosLat = qCos(latRad);
-    const QVector3D normal(
-        cosLat * qCos(lonRad),
-        qSin(latRad),
-        cosLat * qSin(lonRad)
-    );
-
-    const QQuaternion rotation = QQuaternion::rotationTo(QVector3D(0.0f, 1.0f, 0.0f), normal);
-
+    // Kuerzeste Drehung von +Y auf die Normale n: q = (1 + n.y, (0,1,0) x n), normiert.
+    // Ohne Winkelfunktionen; nur am Suedpol (n = -Y) ist die Achse unbestimmt
+    const float w = 1.0f + surfaceNormal.y();
+    QQuaternion rotation;
+    if (w < 1e-6f) {
+        rotation = QQuaternion(0.0f, 1.0f, 0.0f, 0.0f); // 180 Grad um X
+    } else {
+        rotation = QQuaternion(w, surfaceNormal.z(), 0.0f, -surfaceNormal.x()).normalized();
+    }
     transform->setRotation(rotation);
-    transform->setScale(1.0f);
-    transform->setTranslation(QVector3D(0.0f, 0.0f, 0.0f));
 }
@@ -3,6 +3,10 @@
 
 #include <Qt3DCore/QEntity>
 #include <QColor>
+#include <QVector>
+#include <QVector3D>
+
+class CapGeometryCache;
 
 QT_BEGIN_NAMESPACE
 namespace Qt3DCore {
@@ -19,24 +23,39 @@ QT_END_NAMESPACE
 class SurfaceMarker {
 public:
     SurfaceMarker(Qt3DCore::QEntity *parent,
+                  CapGeometryCache *geometryCache,
                   float surfaceRadius,
                   float markerRadius,
                   const QColor &color);
-    ~SurfaceMarker() = default;
+    ~SurfaceMarker();
 
-    void setSphericalPosition(float latitudeDeg, float longitudeDeg);
+    // Ausrichtung ueber die Flaechennormale (Einheitsvektor der Markerposition); liefert false, wenn die
+    // Drehung unter orientationThreshold liegt und keine Qt3D-Eigenschaft geaendert wurde
+    bool setSurfaceNormal(const QVector3D &normal);
+    // Richtet markers[i] nach (x[i], y[i], z[i]) aus, z. B. direkt aus den Spalten eines Snapshots;
+    // liefert die Anzahl tatsaechlich aktualisierter Transformationen
+    static int setSurfaceNormals(const QVector<SurfaceMarker *> &markers,
+                                 const float *x, const float *y, const float *z, int count);
+    // Ohne Farbwechsel keine Material-Aenderung (und damit keine Qt3D-Benachrichtigung)
     void setColor(const QColor &color);
+    // Tauscht die geteilte Geometrie nur beim Wechsel der Radius-Stufe
     void setMarkerRadius(float radius);
+    float radius() const { return markerRadius; }
 
     Qt3DCore::QEntity *entity() const { return markerEntity; }
 
+    // Kleinere Drehungen (Bogenmass) werden nicht an Qt3D weitergegeben; weit unter einem Pixel
+    static constexpr float orientationThreshold = 1e-4f;
+
 private:
     void updateTransform();
 
     float surfaceRadius;
     float markerRadius;
-    float latitudeDeg;
-    float longitudeDeg;
+    QVector3D surfaceNormal; // zuletzt an Qt3D uebergebene Ausrichtung
+    QColor color;            // zuletzt an das Material uebergebene Farbe
+    CapGeometryCache *geometryCache;
+    int geometryKey;
 
     Qt3DCore::QEntity *markerEntity;
     Qt3DCore::QTransform *transform;
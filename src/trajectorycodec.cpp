@@ -0,0 +1,116 @@
+#include "trajectorycodec.h"
+
+#include <QtEndian>
+#include <QtMath>
+#include <cstring>
+#include <limits>
+
+namespace TrajectoryCodec {
+
+namespace {
+inline float signNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+inline quint16 quantizeUnit(float value)
+{
+    return static_cast<quint16>(qBound(0, qRound((value * 0.5f + 0.5f) * 65535.0f), 65535));
+}
+
+inline float dequantizeUnit(quint16 value)
+{
+    return value / 65535.0f * 2.0f - 1.0f;
+}
+}
+
+void writeFileHeader(QByteArray &out, const FileHeader &header)
+{
+    uchar bytes[fileHeaderSize];
+    std::memset(bytes, 0, sizeof(bytes));
+    std::memcpy(bytes, fileMagic, sizeof(fileMagic));
+    qToLittleEndian<quint32>(header.version, bytes + 4);
+    qToLittleEndian<quint32>(fileHeaderSize, bytes + 8);
+    qToLittleEndian<quint32>(header.stepInterval, bytes + 12);
+    qToLittleEndian<quint32>(header.keyframeInterval, bytes + 16);
+    qToLittleEndian<float>(header.velocityScale, bytes + 20);
+    out.append(reinterpret_cast<const char *>(bytes), fileHeaderSize);
+}
+
+bool readFileHeader(const uchar *data, qint64 size, FileHeader &header)
+{
+    if (size < fileHeaderSize || std::memcmp(data, fileMagic, sizeof(fileMagic)) != 0) {
+        return false;
+    }
+    header.version = qFromLittleEndian<quint32>(data + 4);
+    const quint32 headerSize = qFromLittleEndian<quint32>(data + 8);
+    header.stepInterval = qFromLittleEndian<quint32>(data + 12);
+    header.keyframeInterval = qFromLittleEndian<quint32>(data + 16);
+    header.velocityScale = qFromLittleEndian<float>(data + 20);
+    return header.version == formatVersion && headerSize == fileHeaderSize && header.velocityScale > 0.0f;
+}
+
+void writeFrameHeader(uchar *out, const FrameHeader &header)
+{
+    std::memset(out, 0, frameHeaderSize);
+    qToLittleEndian<quint32>(header.frameBytes, out);
+    qToLittleEndian<quint32>(header.markerCount, out + 4);
+    out[8] = header.type;
+    qToLittleEndian<double>(header.simulationTime, out + 16);
+    qToLittleEndian<quint64>(header.stepCount, out + 24);
+}
+
+bool readFrameHeader(const uchar *data, qint64 available, FrameHeader &header)
+{
+    if (available < frameHeaderSize) {
+        return false;
+    }
+    header.frameBytes = qFromLittleEndian<quint32>(data);
+    header.markerCount = qFromLittleEndian<quint32>(data + 4);
+    header.type = data[8] == KeyFrame ? KeyFrame : DeltaFrame;
+    header.simulationTime = qFromLittleEndian<double>(data + 16);
+    header.stepCount = qFromLittleEndian<quint64>(data + 24);
+    return header.frameBytes >= quint32(frameHeaderSize) && qint64(header.frameBytes) <= available;
+}
+
+void encodeOctahedral(float x, float y, float z, quint16 &u, quint16 &v)
+{
+    // Projektion auf das Oktaeder |x| + |y| + |z| = 1, untere Haelfte nach aussen geklappt
+    const float l1 = qAbs(x) + qAbs(y) + qAbs(z);
+    float px = l1 > 0.0f ? x / l1 : 1.0f;
+    float py = l1 > 0.0f ? y / l1 : 0.0f;
+    if (z < 0.0f) {
+        const float fx = (1.0f - qAbs(py)) * signNotZero(px);
+        const float fy = (1.0f - qAbs(px)) * signNotZero(py);
+        px = fx;
+        py = fy;
+    }
+    u = quantizeUnit(px);
+    v = quantizeUnit(py);
+}
+
+void decodeOctahedral(quint16 u, quint16 v, float &x, float &y, float &z)
+{
+    float px = dequantizeUnit(u);
+    float py = dequantizeUnit(v);
+    const float pz = 1.0f - qAbs(px) - qAbs(py);
+    if (pz < 0.0f) {
+        const float fx = (1.0f - qAbs(py)) * signNotZero(px);
+        const float fy = (1.0f - qAbs(px)) * signNotZero(py);
+        px = fx;
+        py = fy;
+    }
+    const float length = qSqrt(px * px + py * py + pz * pz);
+    x = px / length;
+    y = py / length;
+    z = pz / length;
+}
+
+qint32 quantizeVelocity(float value, float scale)
+{
+    const double scaled = double(value) * scale;
+    const double limit = double(std::numeric_limits<qint32>::max() / 2);
+    return static_cast<qint32>(qBound(-limit, scaled, limit) + (scaled >= 0.0 ? 0.5 : -0.5));
+}
+
+}
@@ -0,0 +1,98 @@
+#ifndef TRAJECTORYCODEC_H
+#define TRAJECTORYCODEC_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/**
+ * @brief TrajectoryCodec - Gemeinsames Dateiformat und Kodierung der Trajektorien-Aufzeichnung (.grvt)
+ *
+ * Verantwortlichkeiten:
+ * - Oktaeder-Kodierung von Einheitsvektoren in 2 x 16 Bit (Positionsfehler ~3e-5 Kugelradien)
+ * - Festkomma-Quantisierung der Geschwindigkeiten, ZigZag- und Varint-Kodierung der Differenzen
+ * - Aufbau von Datei- und Bildkopf, geteilt von TrajectoryRecorder und TrajectoryReader
+ *
+ * Aufbau einer .grvt-Datei (Little Endian, nur anhaengend geschrieben):
+ *   Dateikopf (32 Bytes): "GRVT", Version, Kopfgroesse, Aufnahmeintervall k, Keyframe-Abstand, Geschwindigkeitsskala
+ *   Bilder, jeweils mit 32-Byte-Kopf: Bildgroesse, Markeranzahl, Typ (Keyframe/Delta), Simulationszeit, Schrittzahl
+ *     Positionen:   N x (quint16, quint16) oktaeder-kodiert, in jedem Bild absolut
+ *     Kollisionen:  (N + 7) / 8 Bytes Bitfeld
+ *     Geschwindigkeiten: 3N ZigZag-Varints, Differenz zum vorherigen Bild (im Keyframe zu 0)
+ *     nur Keyframes: Radius und Dichte (float32), Farbe (quint32) je Marker
+ */
+namespace TrajectoryCodec {
+
+constexpr char fileMagic[4] = {'G', 'R', 'V', 'T'};
+constexpr quint32 formatVersion = 1;
+constexpr int fileHeaderSize = 32;
+constexpr int frameHeaderSize = 32;
+constexpr float velocityScale = 16384.0f; // Quantisierungsschritt ~6e-5 Kugelradien pro Sekunde
+
+enum FrameType : quint8 {
+    DeltaFrame = 0,
+    KeyFrame = 1
+};
+
+struct FileHeader {
+    quint32 version = formatVersion;
+    quint32 stepInterval = 1;
+    quint32 keyframeInterval = 1;
+    float velocityScale = TrajectoryCodec::velocityScale;
+};
+
+struct FrameHeader {
+    quint32 frameBytes = 0;  // inklusive Kopf
+    quint32 markerCount = 0;
+    FrameType type = DeltaFrame;
+    double simulationTime = 0.0;
+    quint64 stepCount = 0;
+};
+
+void writeFileHeader(QByteArray &out, const FileHeader &header);
+bool readFileHeader(const uchar *data, qint64 size, FileHeader &header);
+
+void writeFrameHeader(uchar *out, const FrameHeader &header);
+bool readFrameHeader(const uchar *data, qint64 available, FrameHeader &header);
+
+void encodeOctahedral(float x, float y, float z, quint16 &u, quint16 &v);
+void decodeOctahedral(quint16 u, quint16 v, float &x, float &y, float &z);
+
+qint32 quantizeVelocity(float value, float scale);
+
+inline quint32 zigZagEncode(qint32 value)
+{
+    return (quint32(value) << 1) ^ quint32(value >> 31);
+}
+
+inline qint32 zigZagDecode(quint32 value)
+{
+    return qint32(value >> 1) ^ -qint32(value & 1);
+}
+
+// Haengt value als LEB128-Varint an (1 bis 5 Bytes)
+inline void appendVarint(QByteArray &out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// Liest einen Varint; gibt nullptr zurueck, wenn der Puffer vorher endet
+inline const uchar *readVarint(const uchar *data, const uchar *end, quint32 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && data < end; shift += 7) {
+        const uchar byte = *data++;
+        value |= quint32(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return data;
+        }
+    }
+    return nullptr;
+}
+
+}
+
+#endif // TRAJECTORYCODEC_H
@@ -0,0 +1,200 @@
+#include "trajectoryreader.h"
+
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+// Kleinste Bildgroesse fuer markerCount Marker: Positionen, Kollisionsbits, mindestens ein Byte je Varint und im
+// Keyframe die statischen Spalten. 64-Bit-Arithmetik, damit eine beschaedigte Markeranzahl nicht ueberlaeuft.
+bool frameFits(const TrajectoryCodec::FrameHeader &header)
+{
+    const qint64 n = header.markerCount;
+    qint64 required = TrajectoryCodec::frameHeaderSize + 4 * n + (n + 7) / 8 + 3 * n;
+    if (header.type == TrajectoryCodec::KeyFrame) {
+        required += 12 * n;
+    }
+    return qint64(header.frameBytes) >= required;
+}
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    close();
+}
+
+bool TrajectoryReader::open(const QString &path, QString *error)
+{
+    close();
+
+    auto fail = [this, error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        close();
+        return false;
+    };
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("Datei konnte nicht gelesen werden: %1").arg(file.errorString()));
+    }
+    size = file.size();
+    data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        return fail(QString("Datei konnte nicht eingeblendet werden: %1").arg(file.errorString()));
+    }
+    if (!TrajectoryCodec::readFileHeader(data, size, fileHeader)) {
+        return fail(QString("Keine gueltige Trajektorien-Datei (Version %1 erwartet)").arg(TrajectoryCodec::formatVersion));
+    }
+
+    // Bildindex: nur die Koepfe werden gelesen, der Rest der Datei bleibt unberuehrt. Bilder, deren Markeranzahl
+    // nicht in die Bildgroesse passt oder nicht zum Keyframe gehoert, werden verworfen; da Deltas aufeinander
+    // aufbauen, gilt das auch fuer alle folgenden Bilder bis zum naechsten gueltigen Keyframe.
+    int currentKeyframe = -1;
+    quint32 keyframeMarkers = 0;
+    qint64 offset = TrajectoryCodec::fileHeaderSize;
+    TrajectoryCodec::FrameHeader frameHeader;
+    while (TrajectoryCodec::readFrameHeader(data + offset, size - offset, frameHeader)) {
+        const bool valid = frameFits(frameHeader);
+        if (frameHeader.type == TrajectoryCodec::KeyFrame) {
+            currentKeyframe = valid ? frames.size() : -1;
+            keyframeMarkers = frameHeader.markerCount;
+            if (valid) {
+                ++keyframes;
+            }
+        } else if (!valid || frameHeader.markerCount != keyframeMarkers) {
+            currentKeyframe = -1;
+        }
+        if (currentKeyframe >= 0) {
+            frames.append({offset, frameHeader.simulationTime, currentKeyframe});
+        }
+        offset += frameHeader.frameBytes;
+    }
+
+    if (frames.isEmpty()) {
+        return fail(QString("Die Aufzeichnung enthaelt keine Bilder"));
+    }
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+    }
+    file.close();
+    size = 0;
+    frames.clear();
+    keyframes = 0;
+    velocities.clear();
+    decodedIndex = -1;
+}
+
+int TrajectoryReader::frameAt(double time) const
+{
+    auto it = std::upper_bound(frames.cbegin(), frames.cend(), time,
+                               [](double t, const FrameEntry &entry) { return t < entry.time; });
+    return qMax(0, static_cast<int>(it - frames.cbegin()) - 1);
+}
+
+bool TrajectoryReader::applyVelocities(int index)
+{
+    TrajectoryCodec::FrameHeader frameHeader;
+    const uchar *frame = data + frames[index].offset;
+    TrajectoryCodec::readFrameHeader(frame, size - frames[index].offset, frameHeader);
+
+    const int n = static_cast<int>(frameHeader.markerCount);
+    if (frameHeader.type == TrajectoryCodec::KeyFrame) {
+        velocities.fill(0, 3 * n);
+    } else if (velocities.size() != 3 * n) {
+        return false;
+    }
+
+    const uchar *cursor = frame + TrajectoryCodec::frameHeaderSize + qint64(n) * 4 + (n + 7) / 8;
+    const uchar *end = frame + frameHeader.frameBytes;
+    qint32 *values = velocities.data();
+    for (int k = 0; k < 3 * n; ++k) {
+        quint32 raw;
+        cursor = TrajectoryCodec::readVarint(cursor, end, raw);
+        if (!cursor) {
+            return false;
+        }
+        values[k] += TrajectoryCodec::zigZagDecode(raw);
+    }
+    decodedIndex = index;
+    return true;
+}
+
+bool TrajectoryReader::readFrame(int index, SimulationSnapshot &out)
+{
+    if (!data || index < 0 || index >= frames.size()) {
+        return false;
+    }
+
+    // Fortlaufendes Abspielen rechnet vom letzten Bild weiter, sonst ab dem Keyframe
+    const int keyframe = frames[index].keyframe;
+    int next = keyframe;
+    if (decodedIndex >= keyframe && decodedIndex <= index && frames[decodedIndex].keyframe == keyframe) {
+        next = decodedIndex + 1;
+    }
+    for (int i = next; i <= index; ++i) {
+        if (!applyVelocities(i)) {
+            decodedIndex = -1;
+            return false;
+        }
+    }
+
+    TrajectoryCodec::FrameHeader frameHeader;
+    const uchar *frame = data + frames[index].offset;
+    TrajectoryCodec::readFrameHeader(frame, size - frames[index].offset, frameHeader);
+    const int n = static_cast<int>(frameHeader.markerCount);
+
+    out.posX.resize(n);
+    out.posY.resize(n);
+    out.posZ.resize(n);
+    out.velX.resize(n);
+    out.velY.resize(n);
+    out.velZ.resize(n);
+    out.colliding.resize(n);
+
+    const uchar *positions = frame + TrajectoryCodec::frameHeaderSize;
+    for (int i = 0; i < n; ++i) {
+        TrajectoryCodec::decodeOctahedral(qFromLittleEndian<quint16>(positions + qint64(i) * 4),
+                                          qFromLittleEndian<quint16>(positions + qint64(i) * 4 + 2),
+                                          out.posX[i], out.posY[i], out.posZ[i]);
+    }
+
+    const uchar *flags = positions + qint64(n) * 4;
+    for (int i = 0; i < n; ++i) {
+        out.colliding[i] = (flags[i >> 3] >> (i & 7)) & 1;
+    }
+
+    const float inverseScale = 1.0f / fileHeader.velocityScale;
+    const qint32 *values = velocities.constData();
+    for (int i = 0; i < n; ++i) {
+        out.velX[i] = values[3 * i] * inverseScale;
+        out.velY[i] = values[3 * i + 1] * inverseScale;
+        out.velZ[i] = values[3 * i + 2] * inverseScale;
+    }
+
+    // Radien, Dichten und Farben liegen am Ende des zugehoerigen Keyframes
+    TrajectoryCodec::FrameHeader keyHeader;
+    const uchar *key = data + frames[keyframe].offset;
+    TrajectoryCodec::readFrameHeader(key, size - frames[keyframe].offset, keyHeader);
+    // Groessen wurden beim Oeffnen geprueft (frameFits)
+    if (keyHeader.markerCount != frameHeader.markerCount) {
+        return false;
+    }
+    const uchar *statics = key + keyHeader.frameBytes - qint64(n) * 12;
+    out.radii.resize(n);
+    out.densities.resize(n);
+    out.colors.resize(n);
+    qFromLittleEndian<float>(statics, n, out.radii.data());
+    qFromLittleEndian<float>(statics + n * 4, n, out.densities.data());
+    qFromLittleEndian<quint32>(statics + n * 8, n, out.colors.data());
+
+    out.simulationTime = frameHeader.simulationTime;
+    out.stepCount = frameHeader.stepCount;
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef TRAJECTORYREADER_H
+#define TRAJECTORYREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "simulationsnapshot.h"
+#include "trajectorycodec.h"
+
+/**
+ * @brief TrajectoryReader - Wahlfreier Zugriff auf eine aufgezeichnete .grvt-Trajektorie
+ *
+ * Verantwortlichkeiten:
+ * - Speicherabbildung der Datei und einmaliger Aufbau eines Bildindex (Offset, Zeit, zugehoeriger Keyframe)
+ * - Suche eines Zeitpunkts per Binaersuche, Keyframe-Lookup pro Bild in O(1)
+ * - Dekodierung ab dem Keyframe; beim fortlaufenden Abspielen wird vom zuletzt dekodierten Bild weitergerechnet
+ * - Ein am Ende abgeschnittenes Bild (z. B. nach Absturz waehrend der Aufnahme) wird ignoriert
+ * - Bilder, deren Markeranzahl nicht zur Bildgroesse passt, werden beim Oeffnen samt abhaengiger Deltas verworfen
+ */
+class TrajectoryReader {
+public:
+    TrajectoryReader() = default;
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader &) = delete;
+    TrajectoryReader &operator=(const TrajectoryReader &) = delete;
+
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    const TrajectoryCodec::FileHeader &header() const { return fileHeader; }
+    int frameCount() const { return static_cast<int>(frames.size()); }
+    int keyframeCount() const { return keyframes; }
+    double startTime() const { return frames.isEmpty() ? 0.0 : frames.first().time; }
+    double endTime() const { return frames.isEmpty() ? 0.0 : frames.last().time; }
+    double frameTime(int index) const { return frames[index].time; }
+
+    // Letztes Bild mit Zeit <= time (Zeiten vor dem Anfang liefern Bild 0)
+    int frameAt(double time) const;
+    bool readFrame(int index, SimulationSnapshot &out);
+
+private:
+    struct FrameEntry {
+        qint64 offset;
+        double time;
+        int keyframe;  // Index des zugehoerigen Keyframes
+    };
+
+    bool applyVelocities(int index);
+
+    QFile file;
+    const uchar *data = nullptr;
+    qint64 size = 0;
+    TrajectoryCodec::FileHeader fileHeader;
+    QVector<FrameEntry> frames;
+    int keyframes = 0;
+
+    // Dekodierzustand: quantisierte Geschwindigkeiten von Bild decodedIndex
+    QVector<qint32> velocities;
+    int decodedIndex = -1;
+};
+
+#endif // TRAJECTORYREADER_H
@@ -0,0 +1,241 @@
+#include "trajectoryrecorder.h"
+#include "simulationcore.h"
+
+#include <QtEndian>
+#include <cstring>
+
+TrajectoryRecorder::TrajectoryRecorder()
+    : stopping(false),
+      recording(false),
+      stepCounter(0),
+      framesSinceKeyframe(0),
+      writtenFrames(0),
+      droppedFrames(0),
+      writtenBytes(0),
+      failed(false)
+{
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    stop();
+}
+
+bool TrajectoryRecorder::start(const QString &path, const Options &recordOptions, QString *error)
+{
+    stop();
+
+    options = recordOptions;
+    options.stepInterval = qMax(1, options.stepInterval);
+    options.keyframeInterval = qMax(1, options.keyframeInterval);
+    options.maxPendingFrames = qMax(1, options.maxPendingFrames);
+    failed.store(false, std::memory_order_relaxed);
+    failure.clear();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = QString("Datei konnte nicht geschrieben werden: %1").arg(file.errorString());
+        }
+        return false;
+    }
+
+    TrajectoryCodec::FileHeader header;
+    header.stepInterval = static_cast<quint32>(options.stepInterval);
+    header.keyframeInterval = static_cast<quint32>(options.keyframeInterval);
+    QByteArray headerBytes;
+    TrajectoryCodec::writeFileHeader(headerBytes, header);
+    if (file.write(headerBytes) != headerBytes.size()) {
+        if (error) {
+            *error = QString("Datei konnte nicht geschrieben werden: %1").arg(file.errorString());
+        }
+        file.close();
+        return false;
+    }
+
+    stepCounter = 0;
+    framesSinceKeyframe = 0;
+    previousVelocities.clear();
+    lastKeyframe = SimulationSnapshot();
+    writtenFrames.store(0, std::memory_order_relaxed);
+    droppedFrames.store(0, std::memory_order_relaxed);
+    writtenBytes.store(headerBytes.size(), std::memory_order_relaxed);
+
+    stopping = false;
+    recording = true;
+    writer = std::thread(&TrajectoryRecorder::writerLoop, this);
+    return true;
+}
+
+void TrajectoryRecorder::stop()
+{
+    if (!recording) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_one();
+    writer.join();
+    if (!hasError() && !file.flush()) {
+        setFailure(file.errorString());
+    }
+    file.close();
+    recording = false;
+}
+
+void TrajectoryRecorder::record(const SimulationCore &core, double simulationTime, quint64 stepCount)
+{
+    if (!recording || (stepCounter++ % quint64(options.stepInterval)) != 0) {
+        return;
+    }
+    if (hasError()) {
+        droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::unique_ptr<SimulationSnapshot> frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (options.blockWhenFull) {
+            spaceCondition.wait(lock, [this]() { return static_cast<int>(pending.size()) < options.maxPendingFrames; });
+        } else if (static_cast<int>(pending.size()) >= options.maxPendingFrames) {
+            droppedFrames.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!freeFrames.empty()) {
+            frame = std::move(freeFrames.back());
+            freeFrames.pop_back();
+        }
+    }
+    if (!frame) {
+        frame = std::make_unique<SimulationSnapshot>();
+    }
+
+    // Nur kopieren; gleiche Markeranzahl bedeutet keine Allokation
+    frame->capture(core, simulationTime, stepCount);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(frame));
+    }
+    wakeCondition.notify_one();
+}
+
+void TrajectoryRecorder::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wakeCondition.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return; // stopping und alles geschrieben
+        }
+        std::unique_ptr<SimulationSnapshot> frame = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        spaceCondition.notify_one();
+
+        if (hasError()) {
+            // Nach einem Schreibfehler nur noch leeren, damit ein wartendes record() weiterkommt
+            droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            encodeFrame(*frame);
+            if (file.write(encoded) == encoded.size()) {
+                writtenFrames.fetch_add(1, std::memory_order_relaxed);
+                writtenBytes.fetch_add(encoded.size(), std::memory_order_relaxed);
+            } else {
+                droppedFrames.fetch_add(1, std::memory_order_relaxed);
+                setFailure(file.errorString());
+            }
+        }
+
+        lock.lock();
+        freeFrames.push_back(std::move(frame));
+    }
+}
+
+void TrajectoryRecorder::setFailure(const QString &message)
+{
+    failure = message.isEmpty() ? QString("Schreibfehler") : message;
+    failed.store(true, std::memory_order_release);
+}
+
+bool TrajectoryRecorder::needsKeyframe(const SimulationSnapshot &frame) const
+{
+    if (framesSinceKeyframe >= options.keyframeInterval || frame.size() != lastKeyframe.size()) {
+        return true;
+    }
+    // Radien, Dichten und Farben stehen nur in Keyframes; jede Aenderung erzwingt einen neuen
+    return frame.radii != lastKeyframe.radii
+        || frame.densities != lastKeyframe.densities
+        || frame.colors != lastKeyframe.colors;
+}
+
+void TrajectoryRecorder::encodeFrame(const SimulationSnapshot &frame)
+{
+    const int n = frame.size();
+    const bool keyframe = writtenFrames.load(std::memory_order_relaxed) == 0 || needsKeyframe(frame);
+
+    encoded.resize(TrajectoryCodec::frameHeaderSize);
+
+    // Positionen: oktaeder-kodierte Einheitsvektoren, in jedem Bild absolut
+    const int positionsOffset = encoded.size();
+    encoded.resize(positionsOffset + n * 4);
+    uchar *positions = reinterpret_cast<uchar *>(encoded.data()) + positionsOffset;
+    for (int i = 0; i < n; ++i) {
+        quint16 u, v;
+        TrajectoryCodec::encodeOctahedral(frame.posX[i], frame.posY[i], frame.posZ[i], u, v);
+        qToLittleEndian<quint16>(u, positions + i * 4);
+        qToLittleEndian<quint16>(v, positions + i * 4 + 2);
+    }
+
+    // Kollisionsflags als Bitfeld
+    const int flagsOffset = encoded.size();
+    encoded.resize(flagsOffset + (n + 7) / 8);
+    uchar *flags = reinterpret_cast<uchar *>(encoded.data()) + flagsOffset;
+    std::memset(flags, 0, (n + 7) / 8);
+    for (int i = 0; i < n; ++i) {
+        if (frame.colliding[i]) {
+            flags[i >> 3] |= uchar(1u << (i & 7));
+        }
+    }
+
+    // Geschwindigkeiten: Festkomma, Differenz zum vorherigen Bild (Keyframe: zu 0)
+    if (keyframe || previousVelocities.size() != 3 * n) {
+        previousVelocities.fill(0, 3 * n);
+    }
+    const float *columns[3] = {frame.velX.constData(), frame.velY.constData(), frame.velZ.constData()};
+    qint32 *previous = previousVelocities.data();
+    for (int i = 0; i < n; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const qint32 quantized = TrajectoryCodec::quantizeVelocity(columns[axis][i], TrajectoryCodec::velocityScale);
+            TrajectoryCodec::appendVarint(encoded, TrajectoryCodec::zigZagEncode(quantized - previous[3 * i + axis]));
+            previous[3 * i + axis] = quantized;
+        }
+    }
+
+    if (keyframe) {
+        const int staticOffset = encoded.size();
+        encoded.resize(staticOffset + n * 12);
+        uchar *out = reinterpret_cast<uchar *>(encoded.data()) + staticOffset;
+        qToLittleEndian<float>(frame.radii.constData(), n, out);
+        qToLittleEndian<float>(frame.densities.constData(), n, out + n * 4);
+        qToLittleEndian<quint32>(frame.colors.constData(), n, out + n * 8);
+
+        lastKeyframe.radii = frame.radii;
+        lastKeyframe.densities = frame.densities;
+        lastKeyframe.colors = frame.colors;
+        lastKeyframe.posX.resize(n); // size() der Referenz folgt der Markeranzahl
+        framesSinceKeyframe = 0;
+    }
+    ++framesSinceKeyframe;
+
+    TrajectoryCodec::FrameHeader header;
+    header.frameBytes = static_cast<quint32>(encoded.size());
+    header.markerCount = static_cast<quint32>(n);
+    header.type = keyframe ? TrajectoryCodec::KeyFrame : TrajectoryCodec::DeltaFrame;
+    header.simulationTime = frame.simulationTime;
+    header.stepCount = frame.stepCount;
+    TrajectoryCodec::writeFrameHeader(reinterpret_cast<uchar *>(encoded.data()), header);
+}
@@ -0,0 +1,93 @@
+#ifndef TRAJECTORYRECORDER_H
+#define TRAJECTORYRECORDER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "simulationsnapshot.h"
+#include "trajectorycodec.h"
+
+class SimulationCore;
+
+/**
+ * @brief TrajectoryRecorder - Schreibt jeden k-ten Simulationsschritt komprimiert in eine .grvt-Datei
+ *
+ * Verantwortlichkeiten:
+ * - record() kopiert den Zustand nur in einen wiederverwendeten Rohpuffer und reiht ihn ein;
+ *   Kodierung und Dateizugriff laufen auf einem eigenen Schreib-Thread
+ * - Begrenzte Warteschlange: kommt der Schreib-Thread nicht nach, werden Bilder verworfen
+ *   statt die Simulationsschleife zu blockieren
+ * - Keyframes in festem Abstand sowie bei Aenderung von Markeranzahl, Radien, Dichten oder Farben
+ * - Schreibfehler (z. B. volle Platte) beenden die Aufzeichnung: hasError()/errorString(), weitere Bilder zaehlen
+ *   als verworfen; die Datei endet mit dem letzten vollstaendig geschriebenen Bild (ein Rest wird beim Lesen ignoriert)
+ */
+class TrajectoryRecorder {
+public:
+    struct Options {
+        int stepInterval = 1;       // jeder k-te Schritt wird aufgezeichnet
+        int keyframeInterval = 60;  // Bilder zwischen zwei Keyframes
+        int maxPendingFrames = 32;
+        bool blockWhenFull = false; // Headless-Laeufe warten statt Bilder zu verwerfen
+    };
+
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder &) = delete;
+    TrajectoryRecorder &operator=(const TrajectoryRecorder &) = delete;
+
+    bool start(const QString &path, const Options &options, QString *error = nullptr);
+    // Schreibt alle noch wartenden Bilder und schliesst die Datei
+    void stop();
+    bool isRecording() const { return recording; }
+
+    // Nur Simulations-Thread; zaehlt die Schritte selbst und zeichnet jeden k-ten auf
+    void record(const SimulationCore &core, double simulationTime, quint64 stepCount);
+
+    quint64 framesWritten() const { return writtenFrames.load(std::memory_order_relaxed); }
+    quint64 framesDropped() const { return droppedFrames.load(std::memory_order_relaxed); }
+    qint64 bytesWritten() const { return writtenBytes.load(std::memory_order_relaxed); }
+    // Aus jedem Thread lesbar; errorString() ist erst nach hasError() == true gueltig
+    bool hasError() const { return failed.load(std::memory_order_acquire); }
+    QString errorString() const { return hasError() ? failure : QString(); }
+
+private:
+    void writerLoop();
+    void encodeFrame(const SimulationSnapshot &frame);
+    bool needsKeyframe(const SimulationSnapshot &frame) const;
+    void setFailure(const QString &message);
+
+    Options options;
+    QFile file;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable spaceCondition;
+    std::deque<std::unique_ptr<SimulationSnapshot>> pending;
+    std::vector<std::unique_ptr<SimulationSnapshot>> freeFrames;
+    bool stopping;
+    bool recording;
+    quint64 stepCounter;
+
+    // Zustand des Schreib-Threads
+    QByteArray encoded;
+    QVector<qint32> previousVelocities;
+    SimulationSnapshot lastKeyframe;
+    int framesSinceKeyframe;
+
+    std::atomic<quint64> writtenFrames;
+    std::atomic<quint64> droppedFrames;
+    std::atomic<qint64> writtenBytes;
+    std::atomic<bool> failed;
+    QString failure;   // einmal vor failed = true geschrieben, danach unveraendert bis zum naechsten start()
+};
+
+#endif // TRAJECTORYRECORDER_H
@@ -0,0 +1,58 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ * @brief TripleBuffer - Lock-freier Dreifachpuffer fuer genau einen Schreiber und einen Leser
+ *
+ * Verantwortlichkeiten:
+ * - Der Schreiber fuellt writeBuffer() und veroeffentlicht ihn mit publish(), ohne je zu blockieren
+ * - Der Leser holt mit update() den zuletzt veroeffentlichten Puffer und liest readBuffer(),
+ *   bis er das naechste Mal update() aufruft
+ * - Zwischen beiden wird nur ein atomarer Index getauscht; kein Puffer wird gleichzeitig beschrieben und gelesen
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : middle(1),
+          back(0),
+          front(2)
+    {
+    }
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // Nur Schreiber-Thread
+    T &writeBuffer() { return buffers[back]; }
+
+    void publish()
+    {
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Nur Leser-Thread; true, wenn seit dem letzten Aufruf ein neuer Puffer veroeffentlicht wurde
+    bool update()
+    {
+        if ((middle.load(std::memory_order_acquire) & freshBit) == 0) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T &readBuffer() const { return buffers[front]; }
+
+private:
+    static constexpr int indexMask = 0x3;
+    static constexpr int freshBit = 0x4;
+
+    T buffers[3];
+    std::atomic<int> middle;
+    int back;
+    int front;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -1,24 +1,36 @@
 #include "viewportcontroller.h"
 #include "spherewidget.h"
+#include "frameprofileroverlay.h"
 
+#include <QVBoxLayout>
 #include <QWidget>
 
 ViewportController::ViewportController()
-    : sphereWidget(nullptr), containerWidget(nullptr)
+    : sphereWidget(nullptr), containerWidget(nullptr), profilerOverlay(nullptr)
 {
     // Create Qt3D sphere widget (NOT as parent!)
     sphereWidget = new SphereWidget();
 
     // Convert Qt3DWindow to QWidget using createWindowContainer
-    containerWidget = QWidget::createWindowContainer(sphereWidget);
-    containerWidget->setMinimumSize(800, 600);
+    QWidget *windowContainer = QWidget::createWindowContainer(sphereWidget);
+    windowContainer->setMinimumSize(800, 600);
+
+    // Viewport und darunter das (standardmaessig verborgene) Profiler-Overlay
+    containerWidget = new QWidget();
+    auto *layout = new QVBoxLayout(containerWidget);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    layout->addWidget(windowContainer, 1);
+
+    profilerOverlay = new FrameProfilerOverlay(containerWidget);
+    layout->addWidget(profilerOverlay);
 }
 
 ViewportController::~ViewportController()
 {
     if (containerWidget) {
         delete containerWidget;
-        // sphereWidget is deleted by containerWidget
+        // sphereWidget is deleted with its window container, a child of containerWidget
     }
 }
 
@@ -5,6 +5,7 @@
 #include <QColor>
 
 class SphereWidget;
+class FrameProfilerOverlay;
 
 /**
  * @brief ViewportController - Verwaltet den 3D-Viewport und die Sphere-Widget-Initialisierung
@@ -13,6 +14,8 @@ class SphereWidget;
  * - Erstellung und Initialisierung des Qt3D-SphereWidgets
  * - Umwandlung des Qt3DWindow in ein QWidget mittels createWindowContainer
  * - Verwaltung der Viewport-Eigenschaften (z.B. Hintergrundfarbe)
+ * - Einblendbares Frame-Profiler-Overlay unterhalb des 3D-Fensters (native Fenster-Container
+ *   lassen sich nicht zuverlaessig mit Widgets ueberlagern)
  * - Bereitstellung einer sauberen Schnittstelle fuer den Zugriff auf den 3D-Viewport
  */
 class ViewportController {
@@ -22,12 +25,14 @@ public:
 
     QWidget *getContainerWidget() const { return containerWidget; }
     SphereWidget *getSphereWidget() const { return sphereWidget; }
+    FrameProfilerOverlay *getProfilerOverlay() const { return profilerOverlay; }
 
     void setBackgroundColor(const QColor &color);
 
 private:
     SphereWidget *sphereWidget;
     QWidget *containerWidget;
+    FrameProfilerOverlay *profilerOverlay;
 };
 
 #endif // VIEWPORTCONTROLLER_H
@@ -0,0 +1,98 @@
+#include "workerpool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threadCount)
+    : currentTask(nullptr),
+      currentCount(0),
+      generation(0),
+      pending(0),
+      stopping(false)
+{
+    const int workers = std::max(1, threadCount) - 1;
+    threads.reserve(workers);
+    for (int k = 0; k < workers; ++k) {
+        threads.emplace_back(&WorkerPool::workerLoop, this, k + 1);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+int WorkerPool::idealThreadCount()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void WorkerPool::run(int count, const std::function<void(int, int, int)> &task)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    if (threads.empty()) {
+        task(0, count, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        currentCount = count;
+        pending = static_cast<int>(threads.size());
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    runBlock(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]() { return pending == 0; });
+    currentTask = nullptr;
+}
+
+void WorkerPool::runBlock(int block)
+{
+    const int blocks = threadCount();
+    const int begin = static_cast<int>(static_cast<long long>(currentCount) * block / blocks);
+    const int end = static_cast<int>(static_cast<long long>(currentCount) * (block + 1) / blocks);
+    if (begin < end) {
+        (*currentTask)(begin, end, block);
+    }
+}
+
+void WorkerPool::workerLoop(int block)
+{
+    unsigned long long seenGeneration = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runBlock(block);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                doneCondition.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief WorkerPool - Persistenter Thread-Pool fuer Fork/Join-Schleifen im Simulationskern
+ *
+ * Verantwortlichkeiten:
+ * - Dauerhaft laufende Worker-Threads, die pro Aufruf nur geweckt werden (kein Thread-Start pro Frame)
+ * - Statische Aufteilung eines Indexbereichs in einen zusammenhaengenden Block pro Thread
+ * - Der aufrufende Thread bearbeitet Block 0 selbst und wartet anschliessend auf alle anderen Bloecke
+ * - Teilergebnisse werden vom Aufrufer in fester Blockreihenfolge reduziert, damit Ergebnisse
+ *   unabhaengig von der Thread-Anzahl bitgleich bleiben
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(int threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Anzahl der Bloecke pro Aufruf (Worker-Threads plus aufrufender Thread)
+    int threadCount() const { return static_cast<int>(threads.size()) + 1; }
+
+    // Block k = [count * k / n, count * (k + 1) / n); task(begin, end, k)
+    void run(int count, const std::function<void(int begin, int end, int block)> &task);
+
+    static int idealThreadCount();
+
+private:
+    void workerLoop(int block);
+    void runBlock(int block);
+
+    std::vector<std::thread> threads;
+    std::mutex dispatchMutex;  // serialisiert Aufrufer, falls mehrere Kerne denselben Pool teilen
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(int, int, int)> *currentTask;
+    int currentCount;
+    unsigned long long generation;
+    int pending;
+    bool stopping;
+};
+
+#endif // WORKERPOOL_H